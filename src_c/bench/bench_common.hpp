@@ -0,0 +1,35 @@
+
+#ifndef BENCH_COMMON_HPP
+#define BENCH_COMMON_HPP
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../epir.h"
+
+/**
+ * The library threads swept by the parallel benchmarks (the caller included).
+ */
+#define BENCH_THREADS {1, 2, 4, 8}
+
+/**
+ * The key pair used by all the benchmarks.
+ */
+extern unsigned char bench_privkey[EPIR_SCALAR_SIZE];
+extern unsigned char bench_pubkey[EPIR_POINT_SIZE];
+
+/**
+ * Returns an executor with `threads` participants (the caller included), shared by the benchmarks.
+ */
+epir_executor *benchExecutor(const int64_t threads);
+
+/**
+ * Returns the sorted mG table of `mmax` entries.
+ * The default table is loaded from the path given on the command line (or the default path),
+ * the others are generated on the first use.
+ */
+const std::vector<epir_mG_t> &benchMG(const size_t mmax);
+
+#endif
+
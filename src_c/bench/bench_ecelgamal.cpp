@@ -0,0 +1,157 @@
+/**
+ * Benchmarks of EC-ElGamal encryption / decryption and of the mG table (search, sort and generation).
+ */
+
+#include <algorithm>
+#include <random>
+
+#include "bench_common.hpp"
+#include "bench_perf.hpp"
+
+#define BATCH (1024)
+
+static void BM_ecelgamal_encrypt(benchmark::State &state, epir_ecelgamal_encrypt_fn *encrypt, const bool fast) {
+	unsigned char cipher[EPIR_CIPHER_SIZE];
+	uint64_t msg = 0;
+	for(auto _: state) {
+		encrypt(cipher, fast ? bench_privkey : bench_pubkey, msg++ & (EPIR_DEFAULT_MG_MAX - 1), NULL);
+		benchmark::DoNotOptimize(cipher);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_ecelgamal_encrypt, normal, epir_ecelgamal_encrypt, false);
+BENCHMARK_CAPTURE(BM_ecelgamal_encrypt, fast, epir_ecelgamal_encrypt_fast, true);
+
+static void BM_ecelgamal_encrypt_ctx(benchmark::State &state) {
+	epir_pubkey_ctx ctx;
+	epir_pubkey_ctx_init(&ctx, bench_pubkey);
+	unsigned char cipher[EPIR_CIPHER_SIZE];
+	uint64_t msg = 0;
+	for(auto _: state) {
+		epir_ecelgamal_encrypt_ctx(cipher, &ctx, msg++ & (EPIR_DEFAULT_MG_MAX - 1), NULL);
+		benchmark::DoNotOptimize(cipher);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ecelgamal_encrypt_ctx);
+
+/**
+ * The public-key path of the bulk encryption (a table of P built once per call) against
+ * the baseline `epir_ecelgamal_encrypt()` per message, on one thread.
+ */
+static void BM_ecelgamal_encrypt_each(benchmark::State &state) {
+	const size_t n = state.range(0);
+	std::vector<unsigned char> ciphers(n * EPIR_CIPHER_SIZE);
+	for(auto _: state) {
+		for(size_t i=0; i<n; i++) {
+			epir_ecelgamal_encrypt(&ciphers[i * EPIR_CIPHER_SIZE], bench_pubkey, i & 1, NULL);
+		}
+		benchmark::DoNotOptimize(ciphers.data());
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_ecelgamal_encrypt_each)->ArgName("n")->RangeMultiplier(8)->Range(64, 1 << 15)->Unit(benchmark::kMillisecond);
+
+static void BM_ecelgamal_encrypt_bulk(benchmark::State &state) {
+	const size_t n = state.range(0);
+	std::vector<uint64_t> messages(n);
+	for(size_t i=0; i<n; i++) messages[i] = i & 1;
+	std::vector<unsigned char> ciphers(n * EPIR_CIPHER_SIZE);
+	for(auto _: state) {
+		epir_ecelgamal_encrypt_bulk_ex(ciphers.data(), bench_pubkey, messages.data(), n, NULL, EPIR_EXECUTOR_INLINE);
+		benchmark::DoNotOptimize(ciphers.data());
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_ecelgamal_encrypt_bulk)->ArgName("n")->RangeMultiplier(8)->Range(64, 1 << 15)->Unit(benchmark::kMillisecond);
+
+static void BM_ecelgamal_decrypt(benchmark::State &state) {
+	const size_t mmax = state.range(0);
+	const std::vector<epir_mG_t> &mG = benchMG(mmax);
+	std::vector<unsigned char> ciphers(BATCH * EPIR_CIPHER_SIZE);
+	std::mt19937 rng(0);
+	for(size_t i=0; i<BATCH; i++) {
+		epir_ecelgamal_encrypt_fast(&ciphers[i * EPIR_CIPHER_SIZE], bench_privkey, rng() % mmax, NULL);
+	}
+	size_t i = 0;
+	BenchPerf perf;
+	perf.start();
+	for(auto _: state) {
+		const int32_t m = epir_ecelgamal_decrypt(bench_privkey, &ciphers[(i++ % BATCH) * EPIR_CIPHER_SIZE], mG.data(), mmax);
+		if(m < 0) {
+			state.SkipWithError("Decryption failed.");
+			break;
+		}
+	}
+	perf.stop();
+	perf.report(state, state.iterations());
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ecelgamal_decrypt)->ArgName("mmax")->RangeMultiplier(16)->Range(1 << 16, EPIR_DEFAULT_MG_MAX);
+
+static void BM_ecelgamal_decrypt_to_mG_batch(benchmark::State &state) {
+	std::vector<unsigned char> ciphers(BATCH * EPIR_CIPHER_SIZE);
+	for(size_t i=0; i<BATCH; i++) {
+		epir_ecelgamal_encrypt_fast(&ciphers[i * EPIR_CIPHER_SIZE], bench_privkey, i, NULL);
+	}
+	std::vector<unsigned char> work(ciphers.size());
+	for(auto _: state) {
+		state.PauseTiming();
+		work = ciphers;
+		state.ResumeTiming();
+		epir_ecelgamal_decrypt_to_mG_batch(bench_privkey, work.data(), BATCH);
+	}
+	state.SetItemsProcessed(state.iterations() * BATCH);
+}
+BENCHMARK(BM_ecelgamal_decrypt_to_mG_batch);
+
+static void BM_mG_interpolation_search(benchmark::State &state) {
+	const size_t mmax = state.range(0);
+	const std::vector<epir_mG_t> &mG = benchMG(mmax);
+	std::mt19937 rng(0);
+	std::vector<size_t> finds(BATCH);
+	for(auto &find: finds) find = rng() % mmax;
+	size_t i = 0;
+	BenchPerf perf;
+	perf.start();
+	for(auto _: state) {
+		const int32_t m = epir_mG_interpolation_search(mG[finds[i++ % BATCH]].point, mG.data(), mmax);
+		benchmark::DoNotOptimize(m);
+	}
+	perf.stop();
+	perf.report(state, state.iterations());
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_mG_interpolation_search)->ArgName("mmax")->RangeMultiplier(16)->Range(1 << 16, EPIR_DEFAULT_MG_MAX);
+
+static void BM_mG_sort(benchmark::State &state) {
+	const size_t mmax = state.range(0);
+	epir_executor *exec = benchExecutor(state.range(1));
+	std::vector<epir_mG_t> shuffled = benchMG(mmax);
+	std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(0));
+	std::vector<epir_mG_t> mG(mmax);
+	for(auto _: state) {
+		state.PauseTiming();
+		mG = shuffled;
+		state.ResumeTiming();
+		epir_mG_sort_ex(mG.data(), mmax, exec);
+	}
+	state.SetItemsProcessed(state.iterations() * mmax);
+}
+BENCHMARK(BM_mG_sort)
+	->ArgNames({"mmax", "threads"})->ArgsProduct({{1 << 16, 1 << 20}, BENCH_THREADS})
+	->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_mG_generate(benchmark::State &state) {
+	const size_t mmax = state.range(0);
+	epir_executor *exec = benchExecutor(state.range(1));
+	std::vector<epir_mG_t> mG(mmax);
+	for(auto _: state) {
+		epir_mG_generate_ex(mG.data(), mmax, NULL, NULL, exec);
+	}
+	state.SetItemsProcessed(state.iterations() * mmax);
+}
+BENCHMARK(BM_mG_generate)
+	->ArgNames({"mmax", "threads"})->ArgsProduct({{1 << 16, 1 << 20}, BENCH_THREADS})
+	->Unit(benchmark::kMillisecond)->UseRealTime();
+
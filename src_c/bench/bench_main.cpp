@@ -0,0 +1,64 @@
+/**
+ * The entry point of the benchmarks: `bench_epir [benchmark flags] [--epir_perf_counters] [mG.bin path]`.
+ */
+
+#include <string.h>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "bench_common.hpp"
+#include "bench_perf.hpp"
+
+unsigned char bench_privkey[EPIR_SCALAR_SIZE];
+unsigned char bench_pubkey[EPIR_POINT_SIZE];
+
+static const char *mG_path = NULL;
+static std::map<int64_t, std::unique_ptr<epir_executor>> executors;
+static std::map<size_t, std::vector<epir_mG_t>> mGs;
+
+epir_executor *benchExecutor(const int64_t threads) {
+	if(threads <= 1) return EPIR_EXECUTOR_INLINE;
+	auto &exec = executors[threads];
+	if(!exec) {
+		exec.reset(new epir_executor);
+		if(epir_executor_init(exec.get(), threads - 1) != 0) {
+			exec.reset();
+			return NULL;
+		}
+	}
+	return exec.get();
+}
+
+const std::vector<epir_mG_t> &benchMG(const size_t mmax) {
+	std::vector<epir_mG_t> &mG = mGs[mmax];
+	if(mG.size() == mmax) return mG;
+	mG.resize(mmax);
+	if(mmax == EPIR_DEFAULT_MG_MAX && epir_mG_load(mG.data(), mmax, mG_path) == mmax) return mG;
+	epir_mG_generate_ex(mG.data(), mmax, NULL, NULL, epir_executor_default());
+	return mG;
+}
+
+int main(int argc, char *argv[]) {
+	benchmark::Initialize(&argc, argv);
+	for(int i=1; i<argc; i++) {
+		if(strcmp(argv[i], "--epir_perf_counters") == 0) {
+			bench_perf_enabled = true;
+		} else {
+			mG_path = argv[i];
+		}
+	}
+	epir_create_privkey(bench_privkey);
+	epir_pubkey_from_privkey(bench_pubkey, bench_privkey);
+	// Recorded in the JSON output to tell the builds apart.
+	benchmark::AddCustomContext("epir_simd_lanes", std::to_string(epir_simd_lanes()));
+	benchmark::AddCustomContext("epir_profiling", epir_profile_enabled() ? "on" : "off");
+	benchmark::AddCustomContext("epir_perf_counters", bench_perf_enabled ? "on" : "off");
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	for(auto &exec: executors) {
+		if(exec.second) epir_executor_destroy(exec.second.get());
+	}
+	return 0;
+}
+
@@ -0,0 +1,102 @@
+/**
+ * Hardware performance counters of the benchmarks (see `BenchPerf`).
+ */
+
+#include <stdio.h>
+#include <string>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "bench_perf.hpp"
+
+bool bench_perf_enabled = false;
+
+#ifdef __linux__
+
+#define HW_CACHE_READ_MISS(cache) \
+	((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct {
+	const char *name;
+	uint32_t type;
+	uint64_t config;
+} events[] = {
+	{ "cycles"       , PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES                   },
+	{ "instructions" , PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS                 },
+	{ "llc_misses"   , PERF_TYPE_HW_CACHE, HW_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL)  },
+	{ "dtlb_misses"  , PERF_TYPE_HW_CACHE, HW_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB)},
+	{ "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES                },
+};
+
+BenchPerf::BenchPerf() {
+	if(!bench_perf_enabled) return;
+	for(const auto &event: events) {
+		struct perf_event_attr attr = {};
+		attr.size = sizeof(attr);
+		attr.type = event.type;
+		attr.config = event.config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		const int fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		if(fd < 0) {
+			static bool warned = false;
+			if(!warned) {
+				perror("perf_event_open (some hardware counters are not reported)");
+				warned = true;
+			}
+			continue;
+		}
+		this->counters.push_back({ event.name, fd });
+	}
+}
+
+BenchPerf::~BenchPerf() {
+	for(const auto &counter: this->counters) close(counter.fd);
+}
+
+void BenchPerf::start() {
+	for(const auto &counter: this->counters) ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+void BenchPerf::stop() {
+	for(const auto &counter: this->counters) ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+}
+
+void BenchPerf::report(benchmark::State &state, const double ops) {
+	if(ops <= 0) return;
+	for(const auto &counter: this->counters) {
+		uint64_t values[3];
+		if(read(counter.fd, values, sizeof(values)) != (ssize_t)sizeof(values) || values[2] == 0) continue;
+		// Scale the count if the counter was multiplexed with the others.
+		const double count = (double)values[0] * values[1] / values[2];
+		state.counters[std::string(counter.name) + "/op"] = count / ops;
+	}
+}
+
+#else
+
+BenchPerf::BenchPerf() {
+	if(bench_perf_enabled) fprintf(stderr, "Hardware counters are only supported on Linux.\n");
+}
+
+BenchPerf::~BenchPerf() {
+}
+
+void BenchPerf::start() {
+}
+
+void BenchPerf::stop() {
+}
+
+void BenchPerf::report(benchmark::State&, const double) {
+}
+
+#endif
+
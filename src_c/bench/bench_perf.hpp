@@ -0,0 +1,47 @@
+
+#ifndef BENCH_PERF_HPP
+#define BENCH_PERF_HPP
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+/**
+ * Set by `--epir_perf_counters` on the command line.
+ */
+extern bool bench_perf_enabled;
+
+/**
+ * Hardware performance counters (cycles, instructions, LLC misses, dTLB misses and branch misses)
+ * of the benchmark thread, read with `perf_event_open()`.
+ * The counters which cannot be opened (no permission, no PMU, not Linux) are left out of the report.
+ * The threads of the executors are not counted: compare the values with a single library thread.
+ */
+class BenchPerf {
+	private:
+		struct Counter {
+			const char *name;
+			int fd;
+		};
+		std::vector<Counter> counters;
+	public:
+		BenchPerf();
+		BenchPerf(const BenchPerf&) = delete;
+		BenchPerf &operator=(const BenchPerf&) = delete;
+		~BenchPerf();
+		/**
+		 * Start (or resume) counting.
+		 */
+		void start();
+		/**
+		 * Stop (or pause) counting.
+		 */
+		void stop();
+		/**
+		 * Report the counts divided by `ops` (e.g. the number of lookups or ciphers) as the counters of `state`.
+		 */
+		void report(benchmark::State &state, const double ops);
+};
+
+#endif
+
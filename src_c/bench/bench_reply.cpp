@@ -0,0 +1,65 @@
+/**
+ * Benchmarks of the reply decryption.
+ */
+
+#include <map>
+#include <tuple>
+
+#include "bench_common.hpp"
+
+/**
+ * The largest reply decrypted (in ciphers) by a single iteration.
+ */
+#define MAX_REPLY_CIPHERS (1 << 17)
+
+/**
+ * Sweep the valid combinations of mmax, dimension, packing and element size
+ * (the packed bytes should be decryptable with mmax, and the reply should not be too large).
+ */
+static void replyArgs(benchmark::internal::Benchmark *b) {
+	b->ArgNames({"mmax", "dimension", "packing", "elem_size", "threads"});
+	for(const int64_t mmax_bits: {16, 24}) {
+		for(int64_t dimension=1; dimension<=3; dimension++) {
+			for(int64_t packing=1; packing<=mmax_bits/8; packing++) {
+				for(const int64_t elem_size: {32, 1024}) {
+					if(epir_reply_size(dimension, packing, elem_size) / EPIR_CIPHER_SIZE > MAX_REPLY_CIPHERS) continue;
+					for(const int64_t threads: BENCH_THREADS) {
+						b->Args({(int64_t)1 << mmax_bits, dimension, packing, elem_size, threads});
+					}
+				}
+			}
+		}
+	}
+}
+
+static void BM_reply_decrypt(benchmark::State &state) {
+	const size_t mmax = state.range(0);
+	const uint8_t dimension = state.range(1);
+	const uint8_t packing = state.range(2);
+	const size_t elem_size = state.range(3);
+	epir_executor *exec = benchExecutor(state.range(4));
+	const std::vector<epir_mG_t> &mG = benchMG(mmax);
+	// The replies are mocked once for all the thread counts.
+	static std::map<std::tuple<uint8_t, uint8_t, size_t>, std::vector<unsigned char>> replies;
+	std::vector<unsigned char> &reply = replies[std::make_tuple(dimension, packing, elem_size)];
+	if(reply.empty()) {
+		std::vector<unsigned char> elem(elem_size);
+		for(size_t i=0; i<elem_size; i++) elem[i] = i & 0xFF;
+		reply.resize(epir_reply_size(dimension, packing, elem_size));
+		epir_reply_mock(reply.data(), bench_pubkey, dimension, packing, elem.data(), elem_size, NULL);
+	}
+	std::vector<unsigned char> work(reply.size());
+	for(auto _: state) {
+		state.PauseTiming();
+		work = reply;
+		state.ResumeTiming();
+		if(epir_reply_decrypt_ex(work.data(), work.size(), bench_privkey, dimension, packing, mG.data(), mmax, exec) < (int)elem_size) {
+			state.SkipWithError("Decryption failed.");
+			break;
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * (reply.size() / EPIR_CIPHER_SIZE));
+	state.SetBytesProcessed(state.iterations() * elem_size);
+}
+BENCHMARK(BM_reply_decrypt)->Apply(replyArgs)->Unit(benchmark::kMillisecond)->UseRealTime();
+
@@ -0,0 +1,100 @@
+/**
+ * Benchmarks of the selector generation and of the selector factory.
+ */
+
+#include "bench_common.hpp"
+#include "bench_perf.hpp"
+
+#define N_INDEXES (3)
+
+static void BM_selector_create(benchmark::State &state, epir_selector_create_ex_fn *create, const bool fast) {
+	const std::vector<uint64_t> index_counts(N_INDEXES, state.range(0));
+	epir_executor *exec = benchExecutor(state.range(1));
+	const uint64_t ciphers_count = epir_selector_ciphers_count(index_counts.data(), N_INDEXES);
+	const uint64_t idx = epir_selector_elements_count(index_counts.data(), N_INDEXES) / 2;
+	std::vector<unsigned char> ciphers(ciphers_count * EPIR_CIPHER_SIZE);
+	BenchPerf perf;
+	perf.start();
+	for(auto _: state) {
+		create(ciphers.data(), fast ? bench_privkey : bench_pubkey, index_counts.data(), N_INDEXES, idx, NULL, exec);
+	}
+	perf.stop();
+	perf.report(state, state.iterations() * ciphers_count);
+	state.SetItemsProcessed(state.iterations() * ciphers_count);
+}
+BENCHMARK_CAPTURE(BM_selector_create, normal, epir_selector_create_ex, false)
+	->ArgNames({"elements_per_index", "threads"})->ArgsProduct({{100, 1000, 10000}, BENCH_THREADS})
+	->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_selector_create, fast, epir_selector_create_fast_ex, true)
+	->ArgNames({"elements_per_index", "threads"})->ArgsProduct({{100, 1000, 10000}, BENCH_THREADS})
+	->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_selector_factory_fill(benchmark::State &state) {
+	const uint32_t capacity_zero = state.range(0);
+	const uint32_t capacity_one = capacity_zero / 100;
+	epir_executor *exec = benchExecutor(state.range(1));
+	for(auto _: state) {
+		state.PauseTiming();
+		epir_selector_factory_ctx ctx;
+		if(epir_selector_factory_ctx_init_fast(&ctx, bench_privkey, capacity_zero, capacity_one) != 0) {
+			state.SkipWithError("Failed to initialize the selector factory.");
+			break;
+		}
+		epir_selector_factory_set_executor(&ctx, exec);
+		state.ResumeTiming();
+		epir_selector_factory_fill_sync(&ctx);
+		state.PauseTiming();
+		epir_selector_factory_ctx_destroy(&ctx);
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * (capacity_zero + capacity_one));
+}
+BENCHMARK(BM_selector_factory_fill)
+	->ArgNames({"capacity", "threads"})->ArgsProduct({{10000, 100000}, BENCH_THREADS})
+	->Unit(benchmark::kMillisecond)->UseRealTime();
+
+
+/**
+ * The selector factory under contention: the thread 0 fills the pool continuously (on its own thread)
+ * while the other threads create selectors from it.
+ * `selectors` is the rate of the selectors created and `empties` the rate of the creations failed (the pool empty).
+ */
+static void BM_selector_factory_contention(benchmark::State &state) {
+	static epir_selector_factory_ctx ctx;
+	static bool ready = false;
+	const std::vector<uint64_t> index_counts(N_INDEXES, state.range(0));
+	const uint64_t ciphers_count = epir_selector_ciphers_count(index_counts.data(), N_INDEXES);
+	const uint64_t idx = epir_selector_elements_count(index_counts.data(), N_INDEXES) / 2;
+	// The other threads wait for the thread 0 at the beginning of the loop, thus it initializes the shared factory here.
+	if(state.thread_index() == 0) {
+		ready = (epir_selector_factory_ctx_init_fast(&ctx, bench_privkey, 100 * ciphers_count, 100 * N_INDEXES) == 0);
+		if(ready) {
+			epir_selector_factory_set_executor(&ctx, EPIR_EXECUTOR_INLINE);
+			epir_selector_factory_fill_sync(&ctx);
+		}
+	}
+	std::vector<unsigned char> ciphers(ciphers_count * EPIR_CIPHER_SIZE);
+	size_t created = 0, failed = 0;
+	for(auto _: state) {
+		if(!ready) {
+			state.SkipWithError("Failed to initialize the selector factory.");
+			break;
+		}
+		if(state.thread_index() == 0) {
+			epir_selector_factory_fill_sync(&ctx);
+		} else if(epir_selector_factory_create_selector(ciphers.data(), &ctx, index_counts.data(), N_INDEXES, idx) == 0) {
+			created++;
+		} else {
+			failed++;
+		}
+	}
+	// The loop ends on all the threads before any of them returns.
+	if(state.thread_index() == 0 && ready) {
+		state.counters["fills"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+		epir_selector_factory_ctx_destroy(&ctx);
+	}
+	state.counters["selectors"] = benchmark::Counter(created, benchmark::Counter::kIsRate);
+	state.counters["empties"] = benchmark::Counter(failed, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_selector_factory_contention)
+	->ArgName("elements_per_index")->Arg(1000)->ThreadRange(2, 8)->UseRealTime();
@@ -6,14 +6,22 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
-#ifndef __EMSCRIPTEN__
-#include <omp.h>
-#endif
 
 #include "epir.h"
+#include "epir_lanes.h"
+#include "epir_point_table.h"
+#include "epir_memory.h"
+#include "epir_profile.h"
+#include "epir_trace.h"
 #include "common.h"
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
+#define divide_up(a, b) (((a) / (b)) + (((a) % (b)) == 0 ? 0 : 1))
+
+/**
+ * The number of ciphers compressed with a single field inversion.
+ */
+#define EPIR_ENCRYPT_BLOCK_SIZE ((size_t)64)
 
 void epir_create_privkey(unsigned char *privkey) {
 	crypto_core_ed25519_scalar_random(privkey);
@@ -27,10 +35,11 @@ void epir_ecelgamal_encrypt(unsigned char *cipher, const unsigned char *pubkey,
 	// Choose a random number r.
 	unsigned char rr[EPIR_SCALAR_SIZE];
 	if(r == NULL) {
-		crypto_core_ed25519_scalar_random(rr);
+		epir_scalar_random(rr);
 	} else {
 		memcpy(rr, r, EPIR_SCALAR_SIZE);
 	}
+	epir_scalar_reduce_(rr);
 	// Compute c1.
 	ge25519_p3 c1;
 	ge25519_scalarmult_base(&c1, rr);
@@ -45,26 +54,115 @@ void epir_ecelgamal_encrypt(unsigned char *cipher, const unsigned char *pubkey,
 	ge25519_tobytes(cipher + EPIR_POINT_SIZE, &c2);
 }
 
-void epir_ecelgamal_encrypt_fast(unsigned char *cipher, const unsigned char *privkey, const uint64_t message, const unsigned char *r) {
+int epir_pubkey_ctx_init(epir_pubkey_ctx *ctx, const unsigned char *pubkey) {
+	memcpy(ctx->pubkey, pubkey, EPIR_POINT_SIZE);
+	if(ge25519_frombytes(&ctx->point, pubkey) != 0) return -1;
+	// base = G.
+	ge25519_p3 base_p3;
+	{
+		unsigned char one_c[EPIR_SCALAR_SIZE];
+		memset(one_c, 0, EPIR_SCALAR_SIZE);
+		one_c[0] = 1;
+		ge25519_scalarmult_base(&base_p3, one_c);
+	}
+	ge25519_p3_to_precomp(&ctx->base, &base_p3);
+	epir_point_table_init(ctx->table, &ctx->point);
+	return 0;
+}
+
+/**
+ * Compute a EC-ElGamal ciphertext as projective points.
+ * Uses the private key `key` if `ctx` is NULL (fast), otherwise the public key context.
+ */
+static void epir_ecelgamal_encrypt_p3_(
+	ge25519_p3 *c1, ge25519_p3 *c2, const unsigned char *key, const epir_pubkey_ctx *ctx,
+	const uint64_t message, const unsigned char *r) {
 	unsigned char rr[EPIR_SCALAR_SIZE];
 	if(r == NULL) {
-		crypto_core_ed25519_scalar_random(rr);
+		epir_scalar_random(rr);
 	} else {
 		memcpy(rr, r, EPIR_SCALAR_SIZE);
 	}
+	// The randomness is reduced modulo L first (r * G and r * P are unchanged),
+	// thus the constant-time table lookups need no fallback for the scalars of 2^255 or above.
+	epir_scalar_reduce_(rr);
 	// Compute c1.
-	ge25519_p3 c1;
-	ge25519_scalarmult_base(&c1, rr);
+	ge25519_scalarmult_base(c1, rr);
 	// Compute c2.
 	unsigned char mm[EPIR_SCALAR_SIZE];
 	sc25519_load_uint64(mm, message);
-	sc25519_muladd(rr, rr, privkey, mm);
-	ge25519_p3 c2;
-	ge25519_scalarmult_base(&c2, rr);
+	if(!ctx) {
+		sc25519_muladd(rr, rr, key, mm);
+		ge25519_scalarmult_base(c2, rr);
+		return;
+	}
+	epir_point_table_scalarmult(c2, ctx->table, rr);
+	if(message > 1) {
+		ge25519_p3 mG;
+		ge25519_cached mG_cached;
+		ge25519_p1p1 t;
+		ge25519_scalarmult_base(&mG, mm);
+		ge25519_p3_to_cached(&mG_cached, &mG);
+		ge25519_add(&t, c2, &mG_cached);
+		ge25519_p1p1_to_p3(c2, &t);
+		return;
+	}
+	// The choice bits of a selector: add G or the neutral element by a masked move.
+	ge25519_precomp q;
+	fe25519_1(q.yplusx);
+	fe25519_1(q.yminusx);
+	fe25519_0(q.xy2d);
+	const unsigned int is_one = (unsigned int)message;
+	fe25519_cmov(q.yplusx, ctx->base.yplusx, is_one);
+	fe25519_cmov(q.yminusx, ctx->base.yminusx, is_one);
+	fe25519_cmov(q.xy2d, ctx->base.xy2d, is_one);
+	ge25519_add_p3_precomp(c2, c2, &q);
+}
+
+void epir_ecelgamal_encrypt_ctx(unsigned char *cipher, const epir_pubkey_ctx *ctx, const uint64_t message, const unsigned char *r) {
+	ge25519_p3 c1, c2;
+	epir_ecelgamal_encrypt_p3_(&c1, &c2, NULL, ctx, message, r);
 	ge25519_p3_tobytes(cipher, &c1);
 	ge25519_p3_tobytes(cipher + EPIR_POINT_SIZE, &c2);
 }
 
+void epir_ecelgamal_encrypt_fast(unsigned char *cipher, const unsigned char *privkey, const uint64_t message, const unsigned char *r) {
+	ge25519_p3 c1, c2;
+	epir_ecelgamal_encrypt_p3_(&c1, &c2, privkey, NULL, message, r);
+	ge25519_p3_tobytes(cipher, &c1);
+	ge25519_p3_tobytes(cipher + EPIR_POINT_SIZE, &c2);
+}
+
+/**
+ * Same as `ge25519_p3_tobytes()` for `n` points, sharing a single field inversion (Montgomery's trick).
+ */
+static void epir_p3_tobytes_batch(unsigned char *s, const ge25519_p3 *points, const size_t n) {
+	if(n == 0) return;
+	// acc[i] = Z_0 * .. * Z_i.
+	fe25519 acc[n];
+	fe25519_copy(acc[0], points[0].Z);
+	for(size_t i=1; i<n; i++) {
+		fe25519_mul(acc[i], acc[i-1], points[i].Z);
+	}
+	fe25519 inv;
+	fe25519_invert(inv, acc[n-1]);
+	for(size_t i=n; i-->0; ) {
+		// zinv = 1 / Z_i, inv = 1 / (Z_0 * .. * Z_(i-1)).
+		fe25519 zinv;
+		if(i > 0) {
+			fe25519_mul(zinv, inv, acc[i-1]);
+			fe25519_mul(inv, inv, points[i].Z);
+		} else {
+			fe25519_copy(zinv, inv);
+		}
+		fe25519 x, y;
+		fe25519_mul(x, points[i].X, zinv);
+		fe25519_mul(y, points[i].Y, zinv);
+		fe25519_tobytes(&s[i * EPIR_POINT_SIZE], y);
+		s[i * EPIR_POINT_SIZE + EPIR_POINT_SIZE - 1] ^= fe25519_isnegative(x) << 7;
+	}
+}
+
 inline size_t epir_mG_default_path_length() {
 	return strlen(getenv("HOME")) + 1 + sizeof(EPIR_DEFAULT_DATA_DIR) + 1 + sizeof(EPIR_DEFAULT_MG_FILE);
 }
@@ -82,6 +180,7 @@ size_t epir_mG_load(epir_mG_t *mG, const size_t mmax, const char *path) {
 	const char *path_ = (path ? path : path_default);
 	FILE *fp = fopen(path_, "r");
 	if(fp == NULL) return 0;
+	EPIR_TRACE_BEGIN(span, mG_load, mmax_);
 	#define BATCH_SIZE (1 << 10)
 	size_t elemsRead = 0;
 	for(;;) {
@@ -90,24 +189,10 @@ size_t epir_mG_load(epir_mG_t *mG, const size_t mmax, const char *path) {
 		if(read < BATCH_SIZE) break;
 	}
 	fclose(fp);
+	EPIR_TRACE_END(span, mG_load);
 	return elemsRead;
 }
 
-static inline uint32_t get_omp_threads() {
-#ifdef __EMSCRIPTEN__
-	return 1;
-#else
-	uint32_t omp_threads;
-	#pragma omp parallel
-	{
-		#pragma omp master
-		{
-			omp_threads = omp_get_num_threads();
-		}
-	}
-	return omp_threads;
-#endif
-}
 
 void epir_mG_generate_prepare(
 	epir_mG_generate_context *ctx,
@@ -155,44 +240,113 @@ void epir_mG_generate_compute(
 	}
 }
 
+/**
+ * The number of points computed between two updates of the progress.
+ */
+#define PROGRESS_CHUNK (4096)
+
+/**
+ * The points computed by a chain, written by its thread only.
+ */
+typedef struct {
+	size_t points __attribute__((aligned(64)));
+} mG_progress_slot;
+
 typedef struct {
-	size_t points_computed;
 	void (*cb)(const size_t, void*);
 	void *cb_data;
-} mG_cb_data;
+	epir_progress_cadence cadence;
+	size_t mmax;
+	uint32_t n_slots;
+	mG_progress_slot *slots;
+	bool reporting;
+	size_t reported;
+	double reported_at;
+} mG_progress;
 
-void mG_cb(void *cb_data) {
-	mG_cb_data *cb_data_ = (mG_cb_data*)cb_data;
-	#pragma omp critical
-	{
-		cb_data_->points_computed++;
-		cb_data_->cb(cb_data_->points_computed, cb_data_->cb_data);
+/**
+ * Publish the points computed by the chain `t`, and make a callback if the cadence allows
+ * (the threads which find another thread reporting do not wait).
+ */
+static void mG_progress_update(mG_progress *progress, const uint32_t t, const size_t points) {
+	__atomic_store_n(&progress->slots[t].points, points, __ATOMIC_RELAXED);
+	if(__atomic_exchange_n(&progress->reporting, true, __ATOMIC_ACQUIRE)) return;
+	size_t total = 0;
+	for(uint32_t s=0; s<progress->n_slots; s++) total += __atomic_load_n(&progress->slots[s].points, __ATOMIC_RELAXED);
+	// The completion is reported by the caller.
+	if(total < progress->mmax && total > progress->reported && total - progress->reported >= progress->cadence.points) {
+		const double now = (progress->cadence.seconds > 0 ? microtime() / 1e6 : progress->reported_at);
+		if(now - progress->reported_at >= progress->cadence.seconds) {
+			progress->reported = total;
+			progress->reported_at = now;
+			progress->cb(total, progress->cb_data);
+		}
 	}
+	__atomic_store_n(&progress->reporting, false, __ATOMIC_RELEASE);
 }
 
-void epir_mG_generate_no_sort(epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data) {
-	const uint32_t omp_threads = get_omp_threads();
-	ge25519_p3 mG_p3[omp_threads];
-	mG_cb_data cb_data_ = { 0, cb, cb_data };
+typedef struct {
+	epir_mG_generate_context *ctx;
+	epir_mG_t *mG;
+	size_t mmax;
+	ge25519_p3 *mG_p3;
+	uint32_t n_threads;
+	mG_progress *progress;
+} mG_generate_data;
+
+static void mG_generate_task(void *data_, const size_t t) {
+	const mG_generate_data *data = data_;
+	const uint32_t n_threads = data->n_threads;
+	const size_t mG_per_thread = divide_up(data->mmax - n_threads, n_threads);
+	const size_t mG_count = (t == n_threads - 1) ?
+		data->mmax - n_threads - (n_threads - 1) * mG_per_thread : mG_per_thread;
+	const size_t mG_offset = n_threads + (t * mG_per_thread);
+	if(!data->progress) {
+		epir_mG_generate_compute(
+			data->ctx, &data->mG[mG_offset], mG_count, &data->mG_p3[t], n_threads + t, n_threads, NULL, NULL);
+		return;
+	}
+	// Compute the chain in chunks to count the points without a per-point callback.
+	size_t points = (t == 0 ? n_threads : 0);
+	for(size_t begin=0; begin<mG_count; begin+=PROGRESS_CHUNK) {
+		const size_t count = min(PROGRESS_CHUNK, mG_count - begin);
+		epir_mG_generate_compute(
+			data->ctx, &data->mG[mG_offset + begin], count, &data->mG_p3[t],
+			n_threads + t + begin * n_threads, n_threads, NULL, NULL);
+		points += count;
+		mG_progress_update(data->progress, t, points);
+	}
+}
+
+void epir_mG_generate_no_sort_cadence_ex(
+	epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data,
+	const epir_progress_cadence *cadence, epir_executor *exec) {
+	EPIR_TRACE_BEGIN(span, mG_generate, mmax);
+	// The points are computed in a chain per thread (with the interval of the number of threads).
+	const uint32_t n_threads = epir_executor_concurrency(exec);
+	ge25519_p3 mG_p3[n_threads];
 	ge25519_precomp tG_precomp;
 	memset(&tG_precomp, 0, sizeof(ge25519_precomp));
 	epir_mG_generate_context ctx = { mmax, tG_precomp };
-	epir_mG_generate_prepare(&ctx, mG, mG_p3, omp_threads, cb ? mG_cb : NULL, cb ? &cb_data_ : NULL);
-	#pragma omp parallel
-	{
-		#ifdef __EMSCRIPTEN__
-		const uint32_t omp_id = 0;
-		#else
-		const uint32_t omp_id = omp_get_thread_num();
-		#endif
-		#define divide_up(a, b) (((a) / (b)) + (((a) % (b)) == 0 ? 0 : 1))
-		const size_t mG_per_thread = divide_up(mmax - omp_threads, omp_threads);
-		const size_t mG_count = (omp_id == omp_threads - 1) ?
-			mmax - omp_threads - (omp_threads - 1) * mG_per_thread : mG_per_thread;
-		const size_t mG_offset = omp_threads + (omp_id * mG_per_thread);
-		epir_mG_generate_compute(
-			&ctx, &mG[mG_offset], mG_count, &mG_p3[omp_id], omp_threads + omp_id, omp_threads, cb ? mG_cb : NULL, cb ? &cb_data_ : NULL);
-	}
+	epir_mG_generate_prepare(&ctx, mG, mG_p3, n_threads, NULL, NULL);
+	mG_progress_slot slots[n_threads];
+	memset(slots, 0, sizeof(mG_progress_slot) * n_threads);
+	const epir_progress_cadence cadence_default = { 0, EPIR_PROGRESS_DEFAULT_SECONDS };
+	mG_progress progress = {
+		cb, cb_data, cadence ? *cadence : cadence_default, mmax, n_threads, slots, false, 0, microtime() / 1e6 };
+	mG_generate_data data = { &ctx, mG, mmax, mG_p3, n_threads, cb ? &progress : NULL };
+	epir_executor_parallel_for(exec, n_threads, mG_generate_task, &data);
+	EPIR_TRACE_END(span, mG_generate);
+	if(cb) cb(mmax, cb_data);
+}
+
+inline void epir_mG_generate_no_sort_ex(
+	epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data, epir_executor *exec) {
+	epir_mG_generate_no_sort_cadence_ex(mG, mmax, cb, cb_data, NULL, exec);
+}
+
+inline void epir_mG_generate_no_sort(epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data) {
+	epir_mG_generate_no_sort_ex(mG, mmax, cb, cb_data, NULL);
 }
 
 int mG_compare(const void *a, const void *b) {
@@ -217,39 +371,70 @@ void epir_mG_merge(epir_mG_t *scratch, epir_mG_t *mG, const size_t a_count, cons
 	memcpy(mG, scratch, sizeof(epir_mG_t) * (a_count + b_count));
 }
 
-void epir_mG_sort(epir_mG_t *mG, const size_t mmax) {
-	const uint32_t omp_threads = get_omp_threads();
-	epir_mG_t *scratch = malloc(sizeof(epir_mG_t) * mmax);
-	#pragma omp parallel
-	{
-		#ifdef __EMSCRIPTEN__
-		const uint32_t omp_id = 0;
-		#else
-		const uint32_t omp_id = omp_get_thread_num();
-		#endif
-		#define divide_up(a, b) (((a) / (b)) + (((a) % (b)) == 0 ? 0 : 1))
-		{
-			const size_t mG_per_thread = divide_up(mmax, omp_threads);
-			const size_t mG_count = (omp_id == omp_threads - 1) ? mmax - (omp_threads - 1) * mG_per_thread : mG_per_thread;
-			const size_t mG_offset = omp_id * mG_per_thread;
-			qsort(&mG[mG_offset], mG_count, sizeof(epir_mG_t), mG_compare);
-		}
-		size_t mG_per_thread = divide_up(mmax, omp_threads);
-		for(uint32_t mG_count=omp_threads; mG_count>1; mG_count=divide_up(mG_count, 2)) {
-			#pragma omp barrier
-			if(2 * omp_id >= mG_count) continue;
-			const size_t offset = 2 * mG_per_thread * omp_id;
-			const size_t b_count = 2 * omp_id + 1 >= mG_count ? mmax - mG_per_thread * (mG_count - 1) : mG_per_thread;
-			epir_mG_merge(&scratch[offset], &mG[offset], mG_per_thread, b_count);
-			mG_per_thread <<= 1;
-		}
+typedef struct {
+	epir_mG_t *mG;
+	epir_mG_t *scratch;
+	size_t mmax;
+	size_t width;
+} mG_sort_data;
+
+static void mG_sort_task(void *data_, const size_t i) {
+	const mG_sort_data *data = data_;
+	const size_t offset = i * data->width;
+	qsort(&data->mG[offset], min(data->width, data->mmax - offset), sizeof(epir_mG_t), mG_compare);
+}
+
+static void mG_merge_task(void *data_, const size_t i) {
+	const mG_sort_data *data = data_;
+	const size_t offset = 2 * data->width * i;
+	const size_t a_count = min(data->width, data->mmax - offset);
+	const size_t b_count = min(data->width, data->mmax - offset - a_count);
+	if(b_count == 0) return;
+	epir_mG_merge(&data->scratch[offset], &data->mG[offset], a_count, b_count);
+}
+
+inline size_t epir_mG_sort_workspace_size(const size_t mmax) {
+	return sizeof(epir_mG_t) * mmax;
+}
+
+void epir_mG_sort_workspace_ex(epir_mG_t *mG, const size_t mmax, void *workspace, epir_executor *exec) {
+	if(mmax == 0) return;
+	EPIR_TRACE_BEGIN(span, mG_sort, mmax);
+	// Sort a part per thread, then merge the adjacent parts pairwise.
+	const uint32_t n_parts = epir_executor_concurrency(exec);
+	mG_sort_data data = { mG, workspace, mmax, divide_up(mmax, n_parts) };
+	epir_executor_parallel_for(exec, divide_up(mmax, data.width), mG_sort_task, &data);
+	for(; data.width<mmax; data.width*=2) {
+		epir_executor_parallel_for(exec, divide_up(mmax, 2 * data.width), mG_merge_task, &data);
 	}
-	free(scratch);
+	EPIR_TRACE_END(span, mG_sort);
 }
 
-void epir_mG_generate(epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data) {
-	epir_mG_generate_no_sort(mG, mmax, cb, cb_data);
-	epir_mG_sort(mG, mmax);
+void epir_mG_sort_ex(epir_mG_t *mG, const size_t mmax, epir_executor *exec) {
+	void *workspace = epir_malloc_(epir_mG_sort_workspace_size(mmax));
+	if(workspace == NULL) {
+		// Out of memory: sort in place on the calling thread.
+		EPIR_TRACE_BEGIN(span, mG_sort, mmax);
+		qsort(mG, mmax, sizeof(epir_mG_t), mG_compare);
+		EPIR_TRACE_END(span, mG_sort);
+		return;
+	}
+	epir_mG_sort_workspace_ex(mG, mmax, workspace, exec);
+	epir_free_(workspace);
+}
+
+inline void epir_mG_sort(epir_mG_t *mG, const size_t mmax) {
+	epir_mG_sort_ex(mG, mmax, NULL);
+}
+
+void epir_mG_generate_ex(
+	epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data, epir_executor *exec) {
+	epir_mG_generate_no_sort_ex(mG, mmax, cb, cb_data, exec);
+	epir_mG_sort_ex(mG, mmax, exec);
+}
+
+inline void epir_mG_generate(epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data) {
+	epir_mG_generate_ex(mG, mmax, cb, cb_data, NULL);
 }
 
 static inline uint32_t load_uint32_t(const unsigned char *n) {
@@ -264,9 +449,10 @@ int32_t epir_mG_interpolation_search(const unsigned char *find, const epir_mG_t
 	const uint32_t my = load_uint32_t(find);
 	for(; imin<=imax; ) {
 		//const size_t imid = imin + ((imax - imin) >> 1);
-		if(left >= right) return -1;
+		if(left >= right) break;
 		const size_t imid = imin + (uint64_t)(imax - imin) * (my - left) / (right - left);
-		if((imid < imin) || (imid > imax)) return -1;
+		if((imid < imin) || (imid > imax)) break;
+		EPIR_PROFILE_COUNT(probes, 1);
 		const int cmp = memcmp(mG[imid].point, find, EPIR_POINT_SIZE);
 		if(cmp < 0) {
 			imin = imid + 1;
@@ -278,16 +464,37 @@ int32_t epir_mG_interpolation_search(const unsigned char *find, const epir_mG_t
 			return mG[imid].scalar;
 		}
 	}
+	EPIR_PROFILE_COUNT(failures, 1);
 	return -1;
 }
 
 void epir_ecelgamal_decrypt_to_mG(const unsigned char *privkey, unsigned char *cipher) {
 	ge25519_p3 c1, c2;
+	EPIR_PROFILE_BEGIN(t_decompress);
 	ge25519_frombytes(&c1, cipher);
 	ge25519_frombytes(&c2, cipher + EPIR_POINT_SIZE);
+	EPIR_PROFILE_END(t_decompress, EPIR_PROFILE_DECOMPRESS);
+	EPIR_PROFILE_BEGIN(t_scalarmult);
 	ge25519_scalarmult(&c1, privkey, &c1);
 	ge25519_sub_p3_p3(&c2, &c2, &c1);
+	EPIR_PROFILE_END(t_scalarmult, EPIR_PROFILE_SCALARMULT);
+	EPIR_PROFILE_BEGIN(t_compress);
 	ge25519_p3_tobytes(cipher, &c2);
+	EPIR_PROFILE_END(t_compress, EPIR_PROFILE_COMPRESS);
+	EPIR_PROFILE_COUNT(ciphers, 1);
+}
+
+void epir_ecelgamal_decrypt_to_mG_batch(const unsigned char *privkey, unsigned char *ciphers, const size_t n) {
+	const epir_lanes_backend *lanes = epir_lanes_get();
+	size_t i = 0;
+	if(lanes && privkey[31] <= 127) {
+		for(; i+lanes->lanes<=n; i+=lanes->lanes) {
+			lanes->decrypt_to_mG(privkey, &ciphers[i * EPIR_CIPHER_SIZE]);
+		}
+	}
+	for(; i<n; i++) {
+		epir_ecelgamal_decrypt_to_mG(privkey, &ciphers[i * EPIR_CIPHER_SIZE]);
+	}
 }
 
 int32_t epir_ecelgamal_decrypt(const unsigned char *privkey, const unsigned char *cipher, const epir_mG_t *mG, const size_t mmax) {
@@ -331,63 +538,532 @@ void epir_selector_create_choice(
 	}
 }
 
+/**
+ * Encrypt `lanes->lanes` messages at once using the SIMD backend.
+ * Returns false (and does nothing) if the given randomness cannot be handled by the backend.
+ */
+static bool epir_ecelgamal_encrypt_lanes_(
+	const epir_lanes_backend *lanes, unsigned char *ciphers, const unsigned char *key, const bool is_fast,
+	const uint64_t *messages, const unsigned char *rr) {
+	unsigned char mm[EPIR_LANES_MAX * EPIR_SCALAR_SIZE];
+	for(size_t l=0; l<lanes->lanes; l++) {
+		if(rr[l * EPIR_SCALAR_SIZE + EPIR_SCALAR_SIZE - 1] > 127) return false;
+	}
+	for(size_t l=0; l<lanes->lanes; l++) {
+		sc25519_load_uint64(&mm[l * EPIR_SCALAR_SIZE], messages[l]);
+		if(is_fast) sc25519_muladd(&mm[l * EPIR_SCALAR_SIZE], &rr[l * EPIR_SCALAR_SIZE], key, &mm[l * EPIR_SCALAR_SIZE]);
+	}
+	// Compute c1.
+	lanes->scalarmult_base(ciphers, EPIR_CIPHER_SIZE, rr);
+	// Compute c2.
+	if(is_fast) {
+		lanes->scalarmult_base(ciphers + EPIR_POINT_SIZE, EPIR_CIPHER_SIZE, mm);
+	} else {
+		lanes->scalarmult_base_add(ciphers + EPIR_POINT_SIZE, EPIR_CIPHER_SIZE, rr, key, mm);
+	}
+	return true;
+}
+
+/**
+ * Get the randomnesses of `n` ciphers beginning at `offset`:
+ * copied from `r`, expanded from `seed`, or randomly chosen if both are NULL.
+ */
+static void epir_randomness_(
+	unsigned char *rr, const unsigned char *r, const unsigned char *seed, const size_t offset, const size_t n) {
+	for(size_t i=0; i<n; i++) {
+		if(r) {
+			memcpy(&rr[i * EPIR_SCALAR_SIZE], &r[(offset + i) * EPIR_SCALAR_SIZE], EPIR_SCALAR_SIZE);
+		} else if(seed) {
+			epir_scalar_from_seed(&rr[i * EPIR_SCALAR_SIZE], seed, offset + i);
+		} else {
+			epir_scalar_random(&rr[i * EPIR_SCALAR_SIZE]);
+		}
+	}
+}
+
+/**
+ * Encrypt up to `EPIR_ENCRYPT_BLOCK_SIZE` messages (single-threaded).
+ * Uses the private key `key` if `ctx` is NULL (fast), otherwise the public key context.
+ * The randomnesses are resolved by `epir_randomness_()` for the ciphers [offset, offset + n).
+ */
+static void epir_ecelgamal_encrypt_block_(
+	unsigned char *ciphers, const unsigned char *key, const epir_pubkey_ctx *ctx,
+	const uint64_t *messages, const size_t n, const unsigned char *r, const unsigned char *seed, const size_t offset) {
+	const bool is_fast = (ctx == NULL);
+	unsigned char rr[EPIR_ENCRYPT_BLOCK_SIZE * EPIR_SCALAR_SIZE];
+	epir_randomness_(rr, r, seed, offset, n);
+	const epir_lanes_backend *lanes = epir_lanes_get();
+	// Ciphers not computed by the SIMD backend are kept projective and compressed at once.
+	ge25519_p3 points[2 * EPIR_ENCRYPT_BLOCK_SIZE];
+	size_t offsets[EPIR_ENCRYPT_BLOCK_SIZE];
+	size_t n_points = 0;
+	for(size_t i=0; i<n; ) {
+		size_t count = 1;
+		if(lanes && i + lanes->lanes <= n) {
+			if(epir_ecelgamal_encrypt_lanes_(
+				lanes, &ciphers[i * EPIR_CIPHER_SIZE], is_fast ? key : ctx->pubkey, is_fast,
+				&messages[i], &rr[i * EPIR_SCALAR_SIZE])) {
+				i += lanes->lanes;
+				continue;
+			}
+			count = lanes->lanes;
+		}
+		for(size_t j=i; j<i+count; j++) {
+			epir_ecelgamal_encrypt_p3_(
+				&points[2 * n_points], &points[2 * n_points + 1], key, ctx, messages[j], &rr[j * EPIR_SCALAR_SIZE]);
+			offsets[n_points++] = j;
+		}
+		i += count;
+	}
+	unsigned char buf[2 * EPIR_ENCRYPT_BLOCK_SIZE * EPIR_POINT_SIZE];
+	epir_p3_tobytes_batch(buf, points, 2 * n_points);
+	for(size_t k=0; k<n_points; k++) {
+		memcpy(&ciphers[offsets[k] * EPIR_CIPHER_SIZE], &buf[k * EPIR_CIPHER_SIZE], EPIR_CIPHER_SIZE);
+	}
+}
+
+typedef struct {
+	unsigned char *ciphers;
+	const unsigned char *key;
+	const epir_pubkey_ctx *ctx;
+	const uint64_t *messages;
+	size_t n;
+	const unsigned char *r;
+} encrypt_bulk_data;
+
+static void encrypt_bulk_task(void *data_, const size_t b) {
+	const encrypt_bulk_data *data = data_;
+	const size_t begin = b * EPIR_ENCRYPT_BLOCK_SIZE;
+	epir_ecelgamal_encrypt_block_(
+		&data->ciphers[begin * EPIR_CIPHER_SIZE], data->key, data->ctx, &data->messages[begin],
+		min(EPIR_ENCRYPT_BLOCK_SIZE, data->n - begin), data->r, NULL, begin);
+}
+
+static void epir_ecelgamal_encrypt_bulk_(
+	unsigned char *ciphers, const unsigned char *key, const epir_pubkey_ctx *ctx,
+	const uint64_t *messages, const size_t n, const unsigned char *r, epir_executor *exec) {
+	encrypt_bulk_data data = { ciphers, key, ctx, messages, n, r };
+	epir_executor_parallel_for(exec, divide_up(n, EPIR_ENCRYPT_BLOCK_SIZE), encrypt_bulk_task, &data);
+}
+
+typedef struct {
+	unsigned char *ciphers;
+	const unsigned char *pubkey;
+	const uint64_t *messages;
+	const unsigned char *r;
+} encrypt_each_data;
+
+static void encrypt_each_task(void *data_, const size_t i) {
+	const encrypt_each_data *data = data_;
+	epir_ecelgamal_encrypt(
+		&data->ciphers[i * EPIR_CIPHER_SIZE], data->pubkey, data->messages[i], data->r ? &data->r[i * EPIR_SCALAR_SIZE] : NULL);
+}
+
+inline void epir_ecelgamal_encrypt_bulk_ex(
+	unsigned char *ciphers, const unsigned char *pubkey, const uint64_t *messages, const size_t n, const unsigned char *r,
+	epir_executor *exec) {
+	epir_pubkey_ctx *ctx = epir_malloc_(sizeof(epir_pubkey_ctx));
+	if(ctx && epir_pubkey_ctx_init(ctx, pubkey) == 0) {
+		epir_ecelgamal_encrypt_bulk_(ciphers, NULL, ctx, messages, n, r, exec);
+	} else {
+		// Invalid public key (or out of memory): keep the behavior of epir_ecelgamal_encrypt().
+		encrypt_each_data data = { ciphers, pubkey, messages, r };
+		epir_executor_parallel_for(exec, n, encrypt_each_task, &data);
+	}
+	epir_free_(ctx);
+}
+
+inline void epir_ecelgamal_encrypt_bulk(
+	unsigned char *ciphers, const unsigned char *pubkey, const uint64_t *messages, const size_t n, const unsigned char *r) {
+	epir_ecelgamal_encrypt_bulk_ex(ciphers, pubkey, messages, n, r, NULL);
+}
+
+inline void epir_ecelgamal_encrypt_bulk_fast_ex(
+	unsigned char *ciphers, const unsigned char *privkey, const uint64_t *messages, const size_t n, const unsigned char *r,
+	epir_executor *exec) {
+	epir_ecelgamal_encrypt_bulk_(ciphers, privkey, NULL, messages, n, r, exec);
+}
+
+inline void epir_ecelgamal_encrypt_bulk_fast(
+	unsigned char *ciphers, const unsigned char *privkey, const uint64_t *messages, const size_t n, const unsigned char *r) {
+	epir_ecelgamal_encrypt_bulk_(ciphers, privkey, NULL, messages, n, r, NULL);
+}
+
+inline void epir_ecelgamal_encrypt_bulk_ctx_ex(
+	unsigned char *ciphers, const epir_pubkey_ctx *ctx, const uint64_t *messages, const size_t n, const unsigned char *r,
+	epir_executor *exec) {
+	epir_ecelgamal_encrypt_bulk_(ciphers, NULL, ctx, messages, n, r, exec);
+}
+
+inline void epir_ecelgamal_encrypt_bulk_ctx(
+	unsigned char *ciphers, const epir_pubkey_ctx *ctx, const uint64_t *messages, const size_t n, const unsigned char *r) {
+	epir_ecelgamal_encrypt_bulk_(ciphers, NULL, ctx, messages, n, r, NULL);
+}
+
+typedef struct {
+	unsigned char *ciphers;
+	const unsigned char *key;
+	const epir_pubkey_ctx *ctx;
+	uint64_t n_ciphers;
+	const unsigned char *r;
+	const unsigned char *seed;
+} selector_create_data;
+
+static void selector_create_task(void *data_, const size_t b) {
+	const selector_create_data *data = data_;
+	const size_t begin = b * EPIR_ENCRYPT_BLOCK_SIZE;
+	const size_t count = min(EPIR_ENCRYPT_BLOCK_SIZE, data->n_ciphers - begin);
+	uint64_t messages[EPIR_ENCRYPT_BLOCK_SIZE];
+	for(size_t i=0; i<count; i++) {
+		messages[i] = data->ciphers[(begin + i) * EPIR_CIPHER_SIZE] ? 1 : 0;
+	}
+	epir_ecelgamal_encrypt_block_(
+		&data->ciphers[begin * EPIR_CIPHER_SIZE], data->key, data->ctx, messages, count, data->r, data->seed, begin);
+}
+
 static void epir_selector_create_(
-	unsigned char *ciphers, const unsigned char *key,
+	unsigned char *ciphers, const unsigned char *key, const epir_pubkey_ctx *ctx,
 	const uint64_t *index_counts, const uint8_t n_indexes,
-	const uint64_t idx, epir_ecelgamal_encrypt_fn *encrypt,
-	const unsigned char *r) {
+	const uint64_t idx, const unsigned char *r, const unsigned char *seed, epir_executor *exec) {
 	const uint64_t n_ciphers = epir_selector_ciphers_count(index_counts, n_indexes);
+	EPIR_TRACE_BEGIN(span, selector_create, n_ciphers);
 	epir_selector_create_choice(ciphers, EPIR_CIPHER_SIZE, index_counts, n_indexes, idx);
-	#pragma omp parallel for
-	for(size_t i=0; i<n_ciphers; i++) {
-		encrypt(ciphers + i * EPIR_CIPHER_SIZE, key, ciphers[i * EPIR_CIPHER_SIZE] ? 1 : 0, r ? &r[i * EPIR_SCALAR_SIZE] : NULL);
+	selector_create_data data = { ciphers, key, ctx, n_ciphers, r, seed };
+	epir_executor_parallel_for(exec, divide_up(n_ciphers, EPIR_ENCRYPT_BLOCK_SIZE), selector_create_task, &data);
+	EPIR_TRACE_END(span, selector_create);
+}
+
+typedef struct {
+	unsigned char *ciphers;
+	const unsigned char *pubkey;
+	const unsigned char *r;
+	const unsigned char *seed;
+} selector_create_each_data;
+
+static void selector_create_each_task(void *data_, const size_t i) {
+	const selector_create_each_data *data = data_;
+	unsigned char rr[EPIR_SCALAR_SIZE];
+	epir_randomness_(rr, data->r, data->seed, i, 1);
+	epir_ecelgamal_encrypt(&data->ciphers[i * EPIR_CIPHER_SIZE], data->pubkey, data->ciphers[i * EPIR_CIPHER_SIZE] ? 1 : 0, rr);
+}
+
+static void epir_selector_create_pubkey_(
+	unsigned char *ciphers, const unsigned char *pubkey,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const unsigned char *seed, epir_executor *exec) {
+	epir_pubkey_ctx *ctx = epir_malloc_(sizeof(epir_pubkey_ctx));
+	if(ctx && epir_pubkey_ctx_init(ctx, pubkey) == 0) {
+		epir_selector_create_(ciphers, NULL, ctx, index_counts, n_indexes, idx, r, seed, exec);
+	} else {
+		// Invalid public key (or out of memory): keep the behavior of epir_ecelgamal_encrypt().
+		const uint64_t n_ciphers = epir_selector_ciphers_count(index_counts, n_indexes);
+		EPIR_TRACE_BEGIN(span, selector_create, n_ciphers);
+		epir_selector_create_choice(ciphers, EPIR_CIPHER_SIZE, index_counts, n_indexes, idx);
+		selector_create_each_data data = { ciphers, pubkey, r, seed };
+		epir_executor_parallel_for(exec, n_ciphers, selector_create_each_task, &data);
+		EPIR_TRACE_END(span, selector_create);
 	}
+	epir_free_(ctx);
 }
 
-inline void epir_selector_create(
+void epir_selector_create(
 	unsigned char *ciphers, const unsigned char *pubkey,
 	const uint64_t *index_counts, const uint8_t n_indexes,
 	const uint64_t idx, const unsigned char *r) {
-	epir_selector_create_(ciphers, pubkey, index_counts, n_indexes, idx, epir_ecelgamal_encrypt, r);
+	epir_selector_create_pubkey_(ciphers, pubkey, index_counts, n_indexes, idx, r, NULL, NULL);
+}
+
+inline void epir_selector_create_ctx(
+	unsigned char *ciphers, const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r) {
+	epir_selector_create_(ciphers, NULL, ctx, index_counts, n_indexes, idx, r, NULL, NULL);
 }
 
 inline void epir_selector_create_fast(
 	unsigned char *ciphers, const unsigned char *privkey,
 	const uint64_t *index_counts, const uint8_t n_indexes,
 	const uint64_t idx, const unsigned char *r) {
-	epir_selector_create_(ciphers, privkey, index_counts, n_indexes, idx, epir_ecelgamal_encrypt_fast, r);
+	epir_selector_create_(ciphers, privkey, NULL, index_counts, n_indexes, idx, r, NULL, NULL);
+}
+
+void epir_selector_create_ex(
+	unsigned char *ciphers, const unsigned char *pubkey,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, epir_executor *exec) {
+	epir_selector_create_pubkey_(ciphers, pubkey, index_counts, n_indexes, idx, r, NULL, exec);
+}
+
+inline void epir_selector_create_ctx_ex(
+	unsigned char *ciphers, const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, epir_executor *exec) {
+	epir_selector_create_(ciphers, NULL, ctx, index_counts, n_indexes, idx, r, NULL, exec);
+}
+
+inline void epir_selector_create_fast_ex(
+	unsigned char *ciphers, const unsigned char *privkey,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, epir_executor *exec) {
+	epir_selector_create_(ciphers, privkey, NULL, index_counts, n_indexes, idx, r, NULL, exec);
+}
+
+void epir_selector_create_seeded(
+	unsigned char *ciphers, const unsigned char *pubkey,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *seed) {
+	epir_selector_create_pubkey_(ciphers, pubkey, index_counts, n_indexes, idx, NULL, seed, NULL);
+}
+
+inline void epir_selector_create_ctx_seeded(
+	unsigned char *ciphers, const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *seed) {
+	epir_selector_create_(ciphers, NULL, ctx, index_counts, n_indexes, idx, NULL, seed, NULL);
+}
+
+inline void epir_selector_create_fast_seeded(
+	unsigned char *ciphers, const unsigned char *privkey,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *seed) {
+	epir_selector_create_(ciphers, privkey, NULL, index_counts, n_indexes, idx, NULL, seed, NULL);
+}
+
+typedef struct {
+	const unsigned char *key;
+	const epir_pubkey_ctx *ctx;
+	const uint64_t *offsets;
+	const uint64_t *rows;
+	uint8_t n_indexes;
+	uint64_t n_ciphers;
+	const unsigned char *r;
+	size_t chunk;
+	epir_selector_sink_fn sink;
+	void *sink_data;
+	unsigned char *bufs[2];
+	/** The chunk encrypted by the current loop. */
+	size_t c;
+	int ret;
+} selector_stream_data;
+
+/**
+ * The item 0 passes the chunk `c - 1` to the sink, and the item `b + 1` encrypts the block `b` of the chunk `c`.
+ */
+static void selector_stream_task(void *data_, const size_t i) {
+	selector_stream_data *data = data_;
+	const size_t c = data->c;
+	if(i == 0) {
+		if(c > 0) {
+			const uint64_t begin = (c - 1) * data->chunk;
+			data->ret = data->sink(
+				data->bufs[(c - 1) % 2], begin, min(data->chunk, data->n_ciphers - begin), data->sink_data);
+		}
+		return;
+	}
+	const uint64_t chunk_begin = c * data->chunk;
+	const uint64_t begin = chunk_begin + (i - 1) * EPIR_ENCRYPT_BLOCK_SIZE;
+	const size_t count = min(EPIR_ENCRYPT_BLOCK_SIZE, data->n_ciphers - begin);
+	uint64_t messages[EPIR_ENCRYPT_BLOCK_SIZE];
+	size_t ic = 0;
+	for(size_t j=0; j<count; j++) {
+		while(ic + 1 < data->n_indexes && begin + j >= data->offsets[ic + 1]) ic++;
+		messages[j] = (begin + j - data->offsets[ic] == data->rows[ic] ? 1 : 0);
+	}
+	epir_ecelgamal_encrypt_block_(
+		&data->bufs[c % 2][(begin - chunk_begin) * EPIR_CIPHER_SIZE], data->key, data->ctx,
+		messages, count, data->r, NULL, begin);
 }
 
-int epir_reply_decrypt(
+/**
+ * Stream a selector to `sink` in chunks.
+ * A loop on the executor encrypts the chunk `c` while one of its items passes the chunk `c - 1` to `sink`,
+ * thus at most two chunks are resident.
+ */
+static int epir_selector_create_stream_(
+	const unsigned char *key, const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const size_t chunk_size, epir_selector_sink_fn sink, void *sink_data,
+	epir_executor *exec) {
+	const uint64_t n_ciphers = epir_selector_ciphers_count(index_counts, n_indexes);
+	// The choices are computed on the fly from the offset and the chosen row of each index.
+	uint64_t offsets[n_indexes], rows[n_indexes];
+	uint64_t idx_ = idx;
+	uint64_t prod = epir_selector_elements_count(index_counts, n_indexes);
+	uint64_t offset = 0;
+	for(size_t ic=0; ic<n_indexes; ic++) {
+		prod /= index_counts[ic];
+		rows[ic] = idx_ / prod;
+		idx_ -= rows[ic] * prod;
+		offsets[ic] = offset;
+		offset += index_counts[ic];
+	}
+	const size_t chunk = EPIR_ENCRYPT_BLOCK_SIZE * divide_up(chunk_size ? chunk_size : EPIR_SELECTOR_STREAM_CHUNK_SIZE, EPIR_ENCRYPT_BLOCK_SIZE);
+	const size_t n_chunks = divide_up(n_ciphers, chunk);
+	selector_stream_data data = {
+		key, ctx, offsets, rows, n_indexes, n_ciphers, r, chunk, sink, sink_data,
+		{ epir_malloc_(chunk * EPIR_CIPHER_SIZE), epir_malloc_(chunk * EPIR_CIPHER_SIZE) }, 0, 0,
+	};
+	if(data.bufs[0] == NULL || data.bufs[1] == NULL) {
+		epir_free_(data.bufs[0]);
+		epir_free_(data.bufs[1]);
+		return -1;
+	}
+	EPIR_TRACE_BEGIN(span, selector_create, n_ciphers);
+	// The loop of the chunk `c` returns after the sink of the chunk `c - 1`, thus the streaming stops at the next chunk.
+	for(size_t c=0; c<=n_chunks && data.ret == 0; c++) {
+		data.c = c;
+		const size_t n_blocks = (c == n_chunks ? 0 : divide_up(min(chunk, n_ciphers - c * chunk), EPIR_ENCRYPT_BLOCK_SIZE));
+		epir_executor_parallel_for(exec, n_blocks + 1, selector_stream_task, &data);
+	}
+	EPIR_TRACE_END(span, selector_create);
+	epir_free_(data.bufs[0]);
+	epir_free_(data.bufs[1]);
+	return data.ret;
+}
+
+int epir_selector_create_stream_ex(
+	const unsigned char *pubkey,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const size_t chunk_size, epir_selector_sink_fn sink, void *sink_data,
+	epir_executor *exec) {
+	epir_pubkey_ctx *ctx = epir_malloc_(sizeof(epir_pubkey_ctx));
+	int ret = -1;
+	if(ctx && epir_pubkey_ctx_init(ctx, pubkey) == 0) {
+		ret = epir_selector_create_stream_(NULL, ctx, index_counts, n_indexes, idx, r, chunk_size, sink, sink_data, exec);
+	}
+	epir_free_(ctx);
+	return ret;
+}
+
+int epir_selector_create_stream(
+	const unsigned char *pubkey,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const size_t chunk_size, epir_selector_sink_fn sink, void *sink_data) {
+	return epir_selector_create_stream_ex(pubkey, index_counts, n_indexes, idx, r, chunk_size, sink, sink_data, NULL);
+}
+
+int epir_selector_create_stream_fast_ex(
+	const unsigned char *privkey,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const size_t chunk_size, epir_selector_sink_fn sink, void *sink_data,
+	epir_executor *exec) {
+	return epir_selector_create_stream_(privkey, NULL, index_counts, n_indexes, idx, r, chunk_size, sink, sink_data, exec);
+}
+
+int epir_selector_create_stream_fast(
+	const unsigned char *privkey,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const size_t chunk_size, epir_selector_sink_fn sink, void *sink_data) {
+	return epir_selector_create_stream_(privkey, NULL, index_counts, n_indexes, idx, r, chunk_size, sink, sink_data, NULL);
+}
+
+int epir_selector_create_stream_ctx_ex(
+	const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const size_t chunk_size, epir_selector_sink_fn sink, void *sink_data,
+	epir_executor *exec) {
+	return epir_selector_create_stream_(NULL, ctx, index_counts, n_indexes, idx, r, chunk_size, sink, sink_data, exec);
+}
+
+int epir_selector_create_stream_ctx(
+	const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const size_t chunk_size, epir_selector_sink_fn sink, void *sink_data) {
+	return epir_selector_create_stream_(NULL, ctx, index_counts, n_indexes, idx, r, chunk_size, sink, sink_data, NULL);
+}
+
+#define DECRYPT_BLOCK_SIZE (64)
+
+typedef struct {
+	unsigned char *reply;
+	const unsigned char *privkey;
+	uint8_t packing;
+	const epir_mG_t *mG;
+	/** The table of which the replica of the node running the task is used (instead of `mG`, if not NULL). */
+	const epir_mG_table *table;
+	size_t mmax;
+	size_t mid_count;
+	uint8_t phase;
+	bool success;
+} reply_decrypt_data;
+
+static void reply_decrypt_task(void *data_, const size_t b) {
+	reply_decrypt_data *data = data_;
+	unsigned char *reply = data->reply;
+	const size_t begin = b * DECRYPT_BLOCK_SIZE;
+	const size_t end = min(begin + DECRYPT_BLOCK_SIZE, data->mid_count);
+	const epir_mG_t *mG = data->table ? epir_mG_table_local(data->table) : data->mG;
+	EPIR_PROFILE_SET_PHASE(data->phase);
+	EPIR_TRACE_BEGIN(span_decrypt, reply_decrypt_to_mG, end - begin);
+	epir_ecelgamal_decrypt_to_mG_batch(data->privkey, &reply[begin * EPIR_CIPHER_SIZE], end - begin);
+	EPIR_TRACE_END(span_decrypt, reply_decrypt_to_mG);
+	EPIR_TRACE_BEGIN(span_search, reply_search, end - begin);
+	EPIR_PROFILE_BEGIN(t_search);
+	for(size_t i=begin; i<end; i++) {
+		const int32_t decrypted = epir_mG_interpolation_search(&reply[i * EPIR_CIPHER_SIZE], mG, data->mmax);
+		if(decrypted < 0) {
+			//printf("Decryption error found at i=%zd\n", i);
+			__atomic_store_n(&data->success, false, __ATOMIC_RELAXED);
+			continue;
+		}
+		for(uint8_t p=0; p<data->packing; p++) {
+			reply[i * EPIR_CIPHER_SIZE + p] = (decrypted >> (8 * p)) & 0xFF;
+		}
+	}
+	EPIR_PROFILE_END(t_search, EPIR_PROFILE_SEARCH);
+	EPIR_TRACE_END(span_search, reply_search);
+	EPIR_PROFILE_SET_PHASE(0);
+}
+
+static int epir_reply_decrypt_(
 	unsigned char *reply, const size_t reply_size, const unsigned char *privkey,
-	const uint8_t dimension, const uint8_t packing, const epir_mG_t *mG, const size_t mmax) {
+	const uint8_t dimension, const uint8_t packing, const epir_mG_t *mG, const epir_mG_table *table, const size_t mmax,
+	epir_executor *exec) {
 	size_t mid_count = reply_size / EPIR_CIPHER_SIZE;
+	EPIR_TRACE_BEGIN(span, reply_decrypt, reply_size);
 	for(uint8_t phase=0; phase<dimension; phase++) {
-		bool success = true;
-		#pragma omp parallel for
-		for(size_t i=0; i<mid_count; i++) {
-			const int32_t decrypted = epir_ecelgamal_decrypt(privkey, &reply[i * EPIR_CIPHER_SIZE], mG, mmax);
-			if(decrypted < 0) {
-				//printf("Decryption error found at phase=%d, i=%zd\n", phase, i);
-				success = false;
-				continue;
-			}
-			for(uint8_t p=0; p<packing; p++) {
-				reply[i * EPIR_CIPHER_SIZE + p] = (decrypted >> (8 * p)) & 0xFF;
-			}
-		}
-		if(!success) {
+		EPIR_TRACE_BEGIN(span_phase, reply_decrypt_phase, mid_count);
+		reply_decrypt_data data = { reply, privkey, packing, mG, table, mmax, mid_count, phase, true };
+		epir_executor_parallel_for(exec, divide_up(mid_count, DECRYPT_BLOCK_SIZE), reply_decrypt_task, &data);
+		if(!data.success) {
+			EPIR_TRACE_END(span_phase, reply_decrypt_phase);
+			EPIR_TRACE_END(span, reply_decrypt);
 			return -1;
 		}
+		EPIR_PROFILE_SET_PHASE(phase);
+		EPIR_PROFILE_BEGIN(t_compact);
+		EPIR_TRACE_BEGIN(span_compact, reply_compact, mid_count);
 		for(size_t i=0; i<mid_count; i++) {
 			memcpy(&reply[i * packing], &reply[i * EPIR_CIPHER_SIZE], packing);
 		}
+		EPIR_TRACE_END(span_compact, reply_compact);
+		EPIR_PROFILE_END(t_compact, EPIR_PROFILE_COMPACT);
+		EPIR_PROFILE_SET_PHASE(0);
+		EPIR_TRACE_END(span_phase, reply_decrypt_phase);
 		if(phase == dimension - 1) {
 			mid_count *= packing;
 			break;
 		}
 		mid_count = mid_count * packing / EPIR_CIPHER_SIZE;
 	}
+	EPIR_TRACE_END(span, reply_decrypt);
 	return mid_count;
 }
 
+int epir_reply_decrypt_ex(
+	unsigned char *reply, const size_t reply_size, const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing, const epir_mG_t *mG, const size_t mmax, epir_executor *exec) {
+	return epir_reply_decrypt_(reply, reply_size, privkey, dimension, packing, mG, NULL, mmax, exec);
+}
+
+int epir_reply_decrypt_table_ex(
+	unsigned char *reply, const size_t reply_size, const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing, const epir_mG_table *table, epir_executor *exec) {
+	return epir_reply_decrypt_(reply, reply_size, privkey, dimension, packing, NULL, table, table->mmax, exec);
+}
+
+inline int epir_reply_decrypt(
+	unsigned char *reply, const size_t reply_size, const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing, const epir_mG_t *mG, const size_t mmax) {
+	return epir_reply_decrypt_ex(reply, reply_size, privkey, dimension, packing, mG, mmax, NULL);
+}
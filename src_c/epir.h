@@ -58,6 +58,27 @@ extern "C" {
  */
 #define EPIR_DEFAULT_MG_FILE ("mG.bin")
 
+/**
+ * The byte size of seeds used to expand randomnesses (see `epir_scalar_from_seed()`).
+ */
+#define EPIR_SEED_SIZE (32)
+
+/**
+ * Generate a random scalar using the buffered per-thread ChaCha20 generator (seeded by `randombytes_buf()`).
+ * This is used by all the encryption functions when the randomness is not given.
+ * @param s The scalar to output. The `EPIR_SCALAR_SIZE` bytes of memory should be allocated.
+ */
+void epir_scalar_random(unsigned char *s);
+
+/**
+ * Deterministically expand a scalar from a seed and a counter (ChaCha20 with the counter as the nonce).
+ * The `*_seeded` functions use this with the cipher index as the counter.
+ * @param s       The scalar to output. The `EPIR_SCALAR_SIZE` bytes of memory should be allocated.
+ * @param seed    The `EPIR_SEED_SIZE` bytes seed.
+ * @param counter The counter.
+ */
+void epir_scalar_from_seed(unsigned char *s, const unsigned char *seed, const uint64_t counter);
+
 /**
  * Generate a new private key.
  * @param privkey The private key to output. The `EPIR_SCALAR_SIZE` bytes of memory should be allocated.
@@ -72,6 +93,128 @@ void epir_create_privkey(unsigned char *privkey);
 EMSCRIPTEN_KEEPALIVE
 void epir_pubkey_from_privkey(unsigned char *pubkey, const unsigned char *privkey);
 
+/**
+ * Returns the number of points the SIMD (AVX2 / AVX-512) backend computes at once.
+ * The backend is selected at runtime by the CPU features.
+ * Returns 1 if no backend is available (or the `EPIR_DISABLE_SIMD` environment variable is set)
+ * and the scalar code is used.
+ */
+size_t epir_simd_lanes();
+
+/**
+ * Enable or disable the SIMD backend (enabled by default).
+ */
+void epir_simd_enable(const bool enable);
+
+/**
+ * A task of `epir_executor_parallel_for()`, which processes the item `i`.
+ */
+typedef void (*epir_executor_task_fn)(void *task_data, const size_t i);
+
+/**
+ * Run `run(run_data)` once on any thread (e.g. by pushing it to the task queue of the application).
+ * The run may be deferred: the caller of `epir_executor_parallel_for()` does not wait for the runs which have not started.
+ */
+typedef void (*epir_executor_submit_fn)(void (*run)(void*), void *run_data, void *submit_data);
+
+typedef struct epir_executor_run_ epir_executor_run_;
+
+/**
+ * An executor, which runs the parallel loops of the `*_ex` functions (instead of the global OpenMP team).
+ * It is backed by a persistent pool of threads, or by a task submission callback.
+ * The loops are split into a range per thread, and the threads steal the items of the other ranges when done.
+ * The caller of a loop runs the items too, thus the loop completes even if no submitted run ever starts.
+ */
+typedef struct {
+	/** The number of threads (excluding the caller) which run the items of a loop. */
+	uint32_t n_threads;
+	epir_executor_submit_fn submit;
+	void *submit_data;
+	/** The threads of the pool (NULL if the runs are submitted to the callback). */
+	pthread_t *workers;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	epir_executor_run_ *head;
+	epir_executor_run_ *tail;
+	bool stopping;
+	/** The number of NUMA nodes the threads of the pool are bound to (zero if not bound). */
+	uint32_t n_nodes;
+	uint32_t n_started;
+} epir_executor;
+
+/**
+ * The executor which runs the loops on the calling thread only.
+ */
+extern epir_executor epir_executor_inline;
+#define EPIR_EXECUTOR_INLINE (&epir_executor_inline)
+
+/**
+ * Initialize an executor backed by a persistent pool of threads.
+ * @param n_threads The number of threads of the pool
+ *                  (0 means the number of processors minus one, as the callers run items too, but at least one).
+ * @return Zero if success, otherwise an error code.
+ */
+int epir_executor_init(epir_executor *exec, const uint32_t n_threads);
+
+/**
+ * The maximum number of NUMA nodes.
+ */
+#define EPIR_NUMA_MAX_NODES (64)
+
+/**
+ * Returns the number of NUMA nodes of the machine (one if not a NUMA machine or unknown).
+ */
+uint32_t epir_numa_nodes();
+
+/**
+ * Returns the NUMA node of the calling thread: the node it is bound to by an executor, or the node of the current CPU.
+ */
+uint32_t epir_numa_current_node();
+
+/**
+ * Initialize an executor backed by a persistent pool of threads bound to NUMA nodes.
+ * The threads are assigned to the nodes in turn and pinned to the CPUs of their nodes,
+ * and the decryption tasks run by them use the replicas of their nodes (see `epir_reply_decrypt_table_ex()`).
+ * @param n_threads The number of threads of the pool (see `epir_executor_init()`).
+ * @param n_nodes   The number of nodes (0 means `epir_numa_nodes()`).
+ *                  The threads assigned to the nodes which do not exist are not pinned, but still use the replicas.
+ * @return Zero if success, otherwise an error code.
+ */
+int epir_executor_init_numa(epir_executor *exec, const uint32_t n_threads, const uint32_t n_nodes);
+
+/**
+ * Initialize an executor which submits the runs to a callback.
+ * @param submit      The submission callback.
+ * @param submit_data The user data for `submit`.
+ * @param n_threads   The number of runs submitted per loop (i.e. the number of threads the callback can run concurrently).
+ * @return Zero if success, otherwise an error code.
+ */
+int epir_executor_init_submit(epir_executor *exec, epir_executor_submit_fn submit, void *submit_data, const uint32_t n_threads);
+
+/**
+ * Destroy the executor. The threads of the pool are joined after running the pending runs.
+ * The executor should not be in use.
+ */
+int epir_executor_destroy(epir_executor *exec);
+
+/**
+ * Returns the pool of the library (created on the first call with the default number of threads, and never destroyed).
+ * Returns NULL if the pool cannot be created.
+ */
+epir_executor *epir_executor_default();
+
+/**
+ * Returns the number of threads which run the items of a loop (including the caller).
+ * If `exec` is NULL, returns the number of threads of the OpenMP team.
+ */
+uint32_t epir_executor_concurrency(const epir_executor *exec);
+
+/**
+ * Run `task(task_data, i)` for each `i` in [0, n) in parallel, and wait for them.
+ * @param exec The executor. If set to NULL, an OpenMP parallel loop is used.
+ */
+void epir_executor_parallel_for(epir_executor *exec, const size_t n, epir_executor_task_fn task, void *task_data);
+
 typedef void (epir_ecelgamal_encrypt_fn)
 	(unsigned char *cipher, const unsigned char *key, const uint64_t message, const unsigned char *r);
 
@@ -95,6 +238,98 @@ epir_ecelgamal_encrypt_fn epir_ecelgamal_encrypt;
 EMSCRIPTEN_KEEPALIVE
 epir_ecelgamal_encrypt_fn epir_ecelgamal_encrypt_fast;
 
+/**
+ * The window size (in bits) of the fixed-base table of `epir_pubkey_ctx`.
+ */
+#define EPIR_POINT_TABLE_BITS (4)
+/**
+ * The number of windows of the fixed-base table of `epir_pubkey_ctx`.
+ */
+#define EPIR_POINT_TABLE_WINDOWS (256 / EPIR_POINT_TABLE_BITS)
+/**
+ * The number of points per window of the fixed-base table of `epir_pubkey_ctx`.
+ */
+#define EPIR_POINT_TABLE_HALF (1 << (EPIR_POINT_TABLE_BITS - 1))
+
+/**
+ * A public key context, which holds the decompressed public key P and a fixed-base table of P (about 80KB).
+ * Use this to encrypt many messages with the same public key.
+ */
+typedef struct {
+	unsigned char pubkey[EPIR_POINT_SIZE];
+	ge25519_p3 point;
+	ge25519_precomp base;
+	ge25519_cached table[EPIR_POINT_TABLE_WINDOWS * EPIR_POINT_TABLE_HALF];
+} epir_pubkey_ctx;
+
+/**
+ * Initialize the public key context.
+ * @param ctx    The context to initialize.
+ * @param pubkey The public key.
+ * @return Zero if success, otherwise (if the public key is not a valid point) a negative value.
+ */
+int epir_pubkey_ctx_init(epir_pubkey_ctx *ctx, const unsigned char *pubkey);
+
+/**
+ * Create a new EC-ElGamal cipher text using a public key context (encrypt).
+ * The result is the same as `epir_ecelgamal_encrypt()`.
+ * @param cipher  Output the ciphertext computed.
+ * @param ctx     A public key context.
+ * @param message A message to encrypt.
+ * @param r       A randomness used when the cipher generation. If set to NULL, we will randomly choose the value.
+ */
+void epir_ecelgamal_encrypt_ctx(unsigned char *cipher, const epir_pubkey_ctx *ctx, const uint64_t message, const unsigned char *r);
+
+typedef void (epir_ecelgamal_encrypt_bulk_fn)(
+	unsigned char *ciphers, const unsigned char *key, const uint64_t *messages, const size_t n, const unsigned char *r);
+
+/**
+ * Encrypt `n` messages at once (normal).
+ * A public key context is built once per call (on the heap) and shared by all the messages.
+ * The points are kept projective and compressed per block with a single shared field inversion.
+ * The result is the same as calling `epir_ecelgamal_encrypt()` for each message.
+ * @param ciphers  Output the `n` ciphertexts computed (`n * EPIR_CIPHER_SIZE` bytes).
+ * @param pubkey   A public key to use with cipher generation.
+ * @param messages The `n` messages to encrypt.
+ * @param n        The number of messages.
+ * @param r        The `n` randomnesses (`n * EPIR_SCALAR_SIZE` bytes). If set to NULL, we will randomly choose the values.
+ */
+epir_ecelgamal_encrypt_bulk_fn epir_ecelgamal_encrypt_bulk;
+
+/**
+ * Encrypt `n` messages at once using a private key (fast).
+ * The result is the same as calling `epir_ecelgamal_encrypt_fast()` for each message.
+ */
+epir_ecelgamal_encrypt_bulk_fn epir_ecelgamal_encrypt_bulk_fast;
+
+/**
+ * Encrypt `n` messages at once using a public key context.
+ * The result is the same as calling `epir_ecelgamal_encrypt_ctx()` for each message.
+ */
+void epir_ecelgamal_encrypt_bulk_ctx(
+	unsigned char *ciphers, const epir_pubkey_ctx *ctx, const uint64_t *messages, const size_t n, const unsigned char *r);
+
+/**
+ * The same as `epir_ecelgamal_encrypt_bulk()`, run by the executor `exec` (see `epir_executor_parallel_for()`).
+ */
+void epir_ecelgamal_encrypt_bulk_ex(
+	unsigned char *ciphers, const unsigned char *pubkey, const uint64_t *messages, const size_t n, const unsigned char *r,
+	epir_executor *exec);
+
+/**
+ * The same as `epir_ecelgamal_encrypt_bulk_fast()`, run by the executor `exec`.
+ */
+void epir_ecelgamal_encrypt_bulk_fast_ex(
+	unsigned char *ciphers, const unsigned char *privkey, const uint64_t *messages, const size_t n, const unsigned char *r,
+	epir_executor *exec);
+
+/**
+ * The same as `epir_ecelgamal_encrypt_bulk_ctx()`, run by the executor `exec`.
+ */
+void epir_ecelgamal_encrypt_bulk_ctx_ex(
+	unsigned char *ciphers, const epir_pubkey_ctx *ctx, const uint64_t *messages, const size_t n, const unsigned char *r,
+	epir_executor *exec);
+
 typedef struct __attribute__((__packed__)) {
 	unsigned char point[EPIR_POINT_SIZE];
 	uint32_t scalar;
@@ -156,6 +391,35 @@ void epir_mG_generate_compute(
  */
 void epir_mG_generate_no_sort(epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data);
 
+/**
+ * Generate mGs (without sort) using the executor `exec` (see `epir_executor_parallel_for()`).
+ */
+void epir_mG_generate_no_sort_ex(
+	epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data, epir_executor *exec);
+
+/**
+ * The sampling cadence of the progress callbacks.
+ * A callback is made at most once per `points` points and per `seconds` seconds (zero disables the criterion).
+ * The callbacks are never concurrent, and the last one reports the completion (e.g. `mmax` points).
+ */
+typedef struct {
+	size_t points;
+	double seconds;
+} epir_progress_cadence;
+
+/**
+ * The cadence of the progress callbacks when none is given: at most ten times per second.
+ */
+#define EPIR_PROGRESS_DEFAULT_SECONDS (0.1)
+
+/**
+ * Generate mGs (without sort) with the progress callbacks sampled at `cadence` (NULL for the default cadence).
+ * The threads count their points privately: the progress reporting does not serialize them.
+ */
+void epir_mG_generate_no_sort_cadence_ex(
+	epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data,
+	const epir_progress_cadence *cadence, epir_executor *exec);
+
 /**
  * Merge mG buffers while keeping the order of mGs.
  * @param scratch The buffer to be used when merging mGs. The buffer size should be equals to or greater than `(a_count + b_count)`.
@@ -172,15 +436,38 @@ void epir_mG_merge(epir_mG_t *scratch, epir_mG_t *mG, const size_t a_count, cons
 EMSCRIPTEN_KEEPALIVE
 void epir_mG_sort(epir_mG_t *mG, const size_t mmax);
 
+/**
+ * Sort mGs in parallel using the executor `exec` (see `epir_executor_parallel_for()`).
+ */
+void epir_mG_sort_ex(epir_mG_t *mG, const size_t mmax, epir_executor *exec);
+
+/**
+ * Returns the byte size of the workspace of `epir_mG_sort_workspace_ex()`.
+ */
+size_t epir_mG_sort_workspace_size(const size_t mmax);
+
+/**
+ * The same as `epir_mG_sort_ex()` using the caller-owned `workspace` (of `epir_mG_sort_workspace_size()` bytes)
+ * instead of allocating a scratch buffer.
+ */
+void epir_mG_sort_workspace_ex(epir_mG_t *mG, const size_t mmax, void *workspace, epir_executor *exec);
+
 /**
  * Generate mGs with given callback.
  * @param mG The mG buffer.
  * @param mmax The maximum number of mG entries.
- * @param cb The callback function called every after a point is computed. If NULL, the callback will not be called.
+ * @param cb The callback function called with the number of points computed, at the default cadence (see `epir_progress_cadence`).
+ *           If NULL, the callback will not be called.
  * @param cb_data The user data for `cb`.
  */
 void epir_mG_generate(epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data);
 
+/**
+ * Generate mGs using the executor `exec` (see `epir_executor_parallel_for()`).
+ */
+void epir_mG_generate_ex(
+	epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data, epir_executor *exec);
+
 /**
  * Resolve m from mG buffer.
  * @param find The point to find.
@@ -197,6 +484,15 @@ int32_t epir_mG_interpolation_search(const unsigned char *find, const epir_mG_t
 EMSCRIPTEN_KEEPALIVE
 void epir_ecelgamal_decrypt_to_mG(const unsigned char *privkey, unsigned char *cipher);
 
+/**
+ * Decrypt `n` consecutive ciphertexts to points on the curve (mG).
+ * Uses the SIMD backend when available (see `epir_simd_lanes()`).
+ * @param privkey The private key.
+ * @param ciphers The ciphertexts. For each ciphertext, the result will be written to its first `EPIR_POINT_SIZE` buffer area.
+ * @param n The number of ciphertexts.
+ */
+void epir_ecelgamal_decrypt_to_mG_batch(const unsigned char *privkey, unsigned char *ciphers, const size_t n);
+
 /**
  * Decrypt a EC-ElGamal ciphertext.
  * @param privkey A private key to use with decryption.
@@ -254,6 +550,136 @@ epir_selector_create_fn epir_selector_create;
  */
 epir_selector_create_fn epir_selector_create_fast;
 
+typedef void (epir_selector_create_seeded_fn)(
+	unsigned char *ciphers, const unsigned char *key,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *seed);
+
+/**
+ * Create a selector with the randomnesses expanded from a seed (normal).
+ * The result is the same as `epir_selector_create()` with `r[i] = epir_scalar_from_seed(seed, i)`,
+ * without materializing the `r` array.
+ * @param seed The `EPIR_SEED_SIZE` bytes seed.
+ */
+epir_selector_create_seeded_fn epir_selector_create_seeded;
+
+/**
+ * Create a selector with the randomnesses expanded from a seed (fast).
+ * @param seed The `EPIR_SEED_SIZE` bytes seed.
+ */
+epir_selector_create_seeded_fn epir_selector_create_fast_seeded;
+
+/**
+ * Create a selector using a public key context.
+ * `epir_selector_create()` builds the context internally for every call; use this to reuse the context.
+ * @param ciphers      The output will be written to this pointer.
+ * @param ctx          A public key context.
+ * @param index_counts The index counts of server's data matrix.
+ * @param n_indexes    The number of elements in the `index_counts`.
+ * @param idx          The index to set.
+ */
+void epir_selector_create_ctx(
+	unsigned char *ciphers, const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r);
+
+/**
+ * Create a selector using a public key context with the randomnesses expanded from a seed.
+ * @param seed The `EPIR_SEED_SIZE` bytes seed.
+ */
+void epir_selector_create_ctx_seeded(
+	unsigned char *ciphers, const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *seed);
+
+typedef void (epir_selector_create_ex_fn)(
+	unsigned char *ciphers, const unsigned char *key,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, epir_executor *exec);
+
+/**
+ * The same as `epir_selector_create()`, run by the executor `exec` (see `epir_executor_parallel_for()`).
+ */
+epir_selector_create_ex_fn epir_selector_create_ex;
+
+/**
+ * The same as `epir_selector_create_fast()`, run by the executor `exec`.
+ */
+epir_selector_create_ex_fn epir_selector_create_fast_ex;
+
+/**
+ * The same as `epir_selector_create_ctx()`, run by the executor `exec`.
+ */
+void epir_selector_create_ctx_ex(
+	unsigned char *ciphers, const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, epir_executor *exec);
+
+/**
+ * The default number of ciphers passed to the sink at once by the streaming selector generation (1MiB).
+ */
+#define EPIR_SELECTOR_STREAM_CHUNK_SIZE (16384)
+
+/**
+ * Receives a chunk of a selector: the `n` ciphers beginning at the cipher `offset`.
+ * The chunks are passed in order, and the buffer is reused after the sink returns.
+ * @return Zero to continue, otherwise the streaming is aborted and this value is returned.
+ */
+typedef int (*epir_selector_sink_fn)(const unsigned char *ciphers, const uint64_t offset, const size_t n, void *sink_data);
+
+typedef int (epir_selector_create_stream_fn)(
+	const unsigned char *key,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const size_t chunk_size, epir_selector_sink_fn sink, void *sink_data);
+
+/**
+ * Create a selector in chunks of `chunk_size` ciphers (normal), without materializing the whole selector.
+ * The next chunk is encrypted in parallel while `sink` processes the current one (the sink is called one chunk at a time).
+ * The ciphers are the same as `epir_selector_create()`.
+ * @param chunk_size The number of ciphers of a chunk (rounded up to a multiple of 64; 0 means `EPIR_SELECTOR_STREAM_CHUNK_SIZE`).
+ * @return Zero if success, the non-zero value returned by `sink`, or -1 on error (e.g., an invalid public key).
+ */
+epir_selector_create_stream_fn epir_selector_create_stream;
+
+/**
+ * Create a selector in chunks (fast).
+ */
+epir_selector_create_stream_fn epir_selector_create_stream_fast;
+
+/**
+ * Create a selector in chunks using a public key context.
+ */
+int epir_selector_create_stream_ctx(
+	const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const size_t chunk_size, epir_selector_sink_fn sink, void *sink_data);
+
+typedef int (epir_selector_create_stream_ex_fn)(
+	const unsigned char *key,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const size_t chunk_size, epir_selector_sink_fn sink, void *sink_data,
+	epir_executor *exec);
+
+/**
+ * The same as `epir_selector_create_stream()`, run by the executor `exec` (see `epir_executor_parallel_for()`).
+ * The sink is called by one of the threads running the encryption of the next chunk (the caller or a worker of `exec`).
+ */
+epir_selector_create_stream_ex_fn epir_selector_create_stream_ex;
+
+/**
+ * The same as `epir_selector_create_stream_fast()`, run by the executor `exec`.
+ */
+epir_selector_create_stream_ex_fn epir_selector_create_stream_fast_ex;
+
+/**
+ * The same as `epir_selector_create_stream_ctx()`, run by the executor `exec`.
+ */
+int epir_selector_create_stream_ctx_ex(
+	const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes,
+	const uint64_t idx, const unsigned char *r, const size_t chunk_size, epir_selector_sink_fn sink, void *sink_data,
+	epir_executor *exec);
+
 /**
  * Decrypt a server's reply.
  * @param reply      The server's reply.
@@ -271,6 +697,171 @@ int epir_reply_decrypt(
 	unsigned char *reply, const size_t reply_size, const unsigned char *privkey,
 	const uint8_t dimension, const uint8_t packing, const epir_mG_t *mG, const size_t mmax);
 
+/**
+ * The same as `epir_reply_decrypt()`, run by the executor `exec` (see `epir_executor_parallel_for()`).
+ */
+int epir_reply_decrypt_ex(
+	unsigned char *reply, const size_t reply_size, const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing, const epir_mG_t *mG, const size_t mmax, epir_executor *exec);
+
+/**
+ * The number of dimension phases profiled separately (the later phases are accumulated into the last one).
+ */
+#define EPIR_PROFILE_MAX_PHASES (8)
+
+/**
+ * The stages of the reply decryption.
+ * The multi-lane backends fuse the point subtraction into the scalar multiplication: it is timed as `EPIR_PROFILE_SCALARMULT`.
+ */
+typedef enum {
+	EPIR_PROFILE_DECOMPRESS = 0,
+	EPIR_PROFILE_SCALARMULT,
+	EPIR_PROFILE_COMPRESS,
+	EPIR_PROFILE_SEARCH,
+	EPIR_PROFILE_COMPACT,
+	EPIR_PROFILE_STAGES
+} epir_profile_stage;
+
+/**
+ * The timers and the counters of the reply decryption, per dimension phase.
+ * The decryptions outside `epir_reply_decrypt()` (e.g. `epir_ecelgamal_decrypt()`) are accumulated into the phase 0.
+ */
+typedef struct {
+	/** The time spent in each stage, summed over the threads (TSC ticks on x86, nanoseconds elsewhere). */
+	uint64_t cycles[EPIR_PROFILE_MAX_PHASES][EPIR_PROFILE_STAGES];
+	/** The number of ciphertexts decrypted. */
+	uint64_t ciphers[EPIR_PROFILE_MAX_PHASES];
+	/** The number of entries of `mG` compared by `epir_mG_interpolation_search()`. */
+	uint64_t probes[EPIR_PROFILE_MAX_PHASES];
+	/** The number of searches which did not find the point. */
+	uint64_t failures[EPIR_PROFILE_MAX_PHASES];
+} epir_profile_stats;
+
+/**
+ * Returns true if the library is built with the profiling (the CMake option `EPIR_ENABLE_PROFILING`).
+ * Otherwise the timers and the counters are not compiled in and the statistics stay zero.
+ */
+bool epir_profile_enabled();
+
+/**
+ * Aggregate the statistics of all the threads since the last `epir_profile_reset()`.
+ * The counters of the running threads are read without stopping them.
+ */
+void epir_profile_get(epir_profile_stats *stats);
+
+/**
+ * Restart the statistics from zero.
+ */
+void epir_profile_reset();
+
+/**
+ * Write out the buffered trace events.
+ * With the CMake option `EPIR_ENABLE_TRACING`, the selector creation, the selector factory fills,
+ * the phases of the reply decryption and the mG load, generation and sort are traced
+ * to the file named by the `EPIR_TRACE` environment variable in the Chrome trace event format
+ * (the timestamps are of `CLOCK_MONOTONIC` in microseconds), and fire the USDT probes `epir:*_begin` and `epir:*_end`.
+ */
+void epir_trace_flush();
+
+typedef struct {
+	/** The bytes of the heap memory allocated by the library now. */
+	size_t current;
+	/** The maximum of `current` since the start (or the last `epir_memory_reset_peak()`). */
+	size_t peak;
+} epir_memory_stats;
+
+/**
+ * Read the process-wide counters of the heap memory allocated by the library,
+ * including the transient buffers (e.g. the scratch buffer of `epir_mG_sort()` and the midstate of `epir_reply_mock()`).
+ * The memory owned by the caller (e.g. mG tables, workspaces and contexts) is not counted.
+ */
+void epir_memory_get(epir_memory_stats *stats);
+
+/**
+ * Restart the peak from the current value.
+ */
+void epir_memory_reset_peak();
+
+/**
+ * The memory held by an object.
+ */
+typedef struct {
+	/** The bytes holding data now (e.g. the available ciphers of a selector cache). */
+	size_t resident;
+	/** The bytes allocated (or placed in the workspace) for the object, including the unused capacity. */
+	size_t reserved;
+} epir_memory_usage;
+
+/**
+ * The placement of an mG table over the NUMA nodes.
+ */
+typedef enum {
+	/** The pages are placed on the node of the thread which first writes them (i.e. the loading thread). */
+	EPIR_NUMA_FIRST_TOUCH = 0,
+	/** The pages are interleaved over the nodes. */
+	EPIR_NUMA_INTERLEAVE,
+	/** A copy of the table is placed on each node (for small tables). */
+	EPIR_NUMA_REPLICATE,
+} epir_numa_policy;
+
+/**
+ * An mG table placed by a NUMA policy.
+ */
+typedef struct {
+	epir_numa_policy policy;
+	size_t mmax;
+	uint32_t n_nodes;
+	/** The number of copies (`n_nodes` if replicated, otherwise one). */
+	uint32_t n_replicas;
+	/** The bytes mapped per copy. */
+	size_t map_size;
+	/** The copy placed on each node (only the first one is used unless replicated). */
+	epir_mG_t *replicas[EPIR_NUMA_MAX_NODES];
+} epir_mG_table;
+
+/**
+ * Allocate an mG table of `mmax` points (0 means `EPIR_DEFAULT_MG_MAX`) placed by `policy`.
+ * @param n_nodes The number of nodes (0 means `epir_numa_nodes()`).
+ *                The copies for the nodes which do not exist are kept without placement,
+ *                thus the policies can be tested on a single node machine.
+ * @return Zero if success, otherwise a negative value.
+ */
+int epir_mG_table_init(epir_mG_table *table, const size_t mmax, const epir_numa_policy policy, const uint32_t n_nodes);
+
+/**
+ * Release the table.
+ */
+int epir_mG_table_destroy(epir_mG_table *table);
+
+/**
+ * Load `mG.bin` into the table (see `epir_mG_load()`) and copy it to the replicas.
+ * @return The number of entries loaded.
+ */
+size_t epir_mG_table_load(epir_mG_table *table, const char *path);
+
+/**
+ * Copy `replicas[0]` to the other replicas (after it is written by the caller, e.g. by `epir_mG_generate_ex()`).
+ */
+void epir_mG_table_replicate(epir_mG_table *table);
+
+/**
+ * Returns the copy of the table for the node of the calling thread.
+ */
+const epir_mG_t *epir_mG_table_local(const epir_mG_table *table);
+
+/**
+ * Take the memory held by the table (all the copies).
+ */
+void epir_mG_table_memory_usage(const epir_mG_table *table, epir_memory_usage *usage);
+
+/**
+ * The same as `epir_reply_decrypt_ex()` using the mG table:
+ * each decryption task searches the copy for the node of the thread running it.
+ */
+int epir_reply_decrypt_table_ex(
+	unsigned char *reply, const size_t reply_size, const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing, const epir_mG_table *table, epir_executor *exec);
+
 /**
  * Compute the size of reply from given parameters.
  * @param dimension Dimension.
@@ -294,6 +885,8 @@ typedef void (epir_reply_mock_fn)(
 
 /**
  * Generates a sample server reply (normal).
+ * The functions of this type allocate a midstate buffer, and zero-fill the reply if they fail to
+ * (see `epir_reply_mock_workspace()` for the variant without allocation).
  */
 EMSCRIPTEN_KEEPALIVE
 epir_reply_mock_fn epir_reply_mock;
@@ -304,14 +897,325 @@ epir_reply_mock_fn epir_reply_mock;
 EMSCRIPTEN_KEEPALIVE
 epir_reply_mock_fn epir_reply_mock_fast;
 
+typedef void (epir_reply_mock_ex_fn)(
+	unsigned char *reply,
+	const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing,
+	const uint8_t *elem, const size_t elem_size, const unsigned char *r, epir_executor *exec);
+
+/**
+ * The same as `epir_reply_mock()`, run by the executor `exec` (see `epir_executor_parallel_for()`).
+ */
+epir_reply_mock_ex_fn epir_reply_mock_ex;
+
+/**
+ * The same as `epir_reply_mock_fast()`, run by the executor `exec`.
+ */
+epir_reply_mock_ex_fn epir_reply_mock_fast_ex;
+
+/**
+ * Generates a sample server reply (normal) with the randomnesses expanded from a seed.
+ * The result is the same as `epir_reply_mock()` with `r[i] = epir_scalar_from_seed(seed, i)`.
+ * @param seed The `EPIR_SEED_SIZE` bytes seed.
+ */
+EMSCRIPTEN_KEEPALIVE
+epir_reply_mock_fn epir_reply_mock_seeded;
+
+/**
+ * Generates a sample server reply (fast) with the randomnesses expanded from a seed.
+ * @param seed The `EPIR_SEED_SIZE` bytes seed.
+ */
+EMSCRIPTEN_KEEPALIVE
+epir_reply_mock_fn epir_reply_mock_fast_seeded;
+
+/**
+ * Returns the byte size of the workspace of `epir_reply_mock*_workspace()`.
+ */
+EMSCRIPTEN_KEEPALIVE
+size_t epir_reply_mock_workspace_size(const uint8_t dimension, const uint8_t packing, const size_t elem_size);
+
+typedef void (epir_reply_mock_workspace_fn)(
+	unsigned char *reply,
+	const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing,
+	const uint8_t *elem, const size_t elem_size, const unsigned char *r, unsigned char *workspace);
+
+/**
+ * The same as `epir_reply_mock()` using the caller-owned `workspace` (of `epir_reply_mock_workspace_size()` bytes)
+ * to keep the ciphers of a dimension instead of allocating it.
+ */
+EMSCRIPTEN_KEEPALIVE
+epir_reply_mock_workspace_fn epir_reply_mock_workspace;
+
+/**
+ * The same as `epir_reply_mock_fast()` using the caller-owned `workspace`.
+ */
+EMSCRIPTEN_KEEPALIVE
+epir_reply_mock_workspace_fn epir_reply_mock_fast_workspace;
+
+/**
+ * The same as `epir_reply_mock_seeded()` using the caller-owned `workspace`.
+ * @param r The `EPIR_SEED_SIZE` bytes seed.
+ */
+EMSCRIPTEN_KEEPALIVE
+epir_reply_mock_workspace_fn epir_reply_mock_seeded_workspace;
+
+/**
+ * The same as `epir_reply_mock_fast_seeded()` using the caller-owned `workspace`.
+ * @param r The `EPIR_SEED_SIZE` bytes seed.
+ */
+EMSCRIPTEN_KEEPALIVE
+epir_reply_mock_workspace_fn epir_reply_mock_fast_seeded_workspace;
+
+/**
+ * The costs of the primitive operations used to estimate the cost of a PIR query.
+ */
+typedef struct {
+	/** The client time (in seconds) to encrypt a cipher of the selector. */
+	double encrypt_seconds;
+	/** The client time (in seconds) to decrypt a cipher of the reply. */
+	double decrypt_seconds;
+	/** The server time (in seconds) to multiply a cipher by a message and accumulate it: `base + per_bit * 8 * packing`. */
+	double server_seconds_base;
+	double server_seconds_per_bit;
+} epir_cost_model;
+
+/**
+ * Calibrate the cost model by a quick benchmark on the calling thread (the costs are per thread).
+ */
+void epir_cost_model_calibrate(epir_cost_model *model);
+
+/**
+ * The maximum number of `index_counts` considered by the parameter optimizer.
+ */
+#define EPIR_PARAMS_MAX_INDEXES (4)
+
+/**
+ * A set of PIR parameters and its estimated costs. The `dimension` of the reply equals `n_indexes`.
+ */
+typedef struct {
+	uint8_t n_indexes;
+	uint64_t index_counts[EPIR_PARAMS_MAX_INDEXES];
+	uint8_t packing;
+	/** The number of bytes of the selector. */
+	uint64_t selector_size;
+	/** The number of bytes of the reply. */
+	uint64_t reply_size;
+	double client_seconds;
+	double server_seconds;
+} epir_params;
+
+/**
+ * Find the Pareto-optimal parameter sets for bandwidth (`selector_size + reply_size`), client time and server time.
+ * @param params     The buffer to write the parameter sets (in ascending order of bandwidth).
+ * @param max_params The number of elements of `params`.
+ * @param n_elements The number of elements in the database.
+ * @param elem_size  The number of bytes of each element.
+ * @param mmax       The number of points in mG (which limits `packing`).
+ * @param model      The cost model (see `epir_cost_model_calibrate()`).
+ * @return The number of the Pareto-optimal parameter sets (only the first `max_params` of them are written).
+ */
+size_t epir_params_optimize(
+	epir_params *params, const size_t max_params,
+	const uint64_t n_elements, const size_t elem_size, const size_t mmax, const epir_cost_model *model);
+
+/**
+ * The number of candidate buckets of each element in a batch query.
+ */
+#define EPIR_BATCH_HASHES (3)
+
+/**
+ * The bucket layout of a batch query.
+ * Each element is placed in (up to) `EPIR_BATCH_HASHES` buckets chosen by hashing its index,
+ * and the client assigns the requested indexes to distinct buckets by cuckoo hashing.
+ * The server treats each bucket as a database of `epir_selector_elements_count(index_counts, n_indexes)` elements
+ * (the elements `elements[offsets[b]..offsets[b+1]]` followed by zero paddings), and replies to each bucket query.
+ * Thus, the server processes `EPIR_BATCH_HASHES` times the database for any number of indexes (up to `max_batch`).
+ */
+typedef struct {
+	uint64_t n_elements;
+	uint32_t n_buckets;
+	uint64_t seed;
+	uint8_t n_indexes;
+	/** The `index_counts` shared by all the buckets. */
+	uint64_t *index_counts;
+	/** The elements of the bucket `b` are `elements[offsets[b]..offsets[b+1]]`, in ascending order. */
+	uint64_t *offsets;
+	uint64_t *elements;
+} epir_batch_ctx;
+
+/**
+ * Initialize the bucket layout.
+ * @param n_elements The number of elements in the database.
+ * @param max_batch  The maximum number of indexes in a batch query.
+ * @param n_indexes  The number of `index_counts` of each bucket (i.e., the dimension of the bucket queries).
+ * @param seed       The seed of the hash functions (the server and the client should share it).
+ * @return Zero if success, otherwise -1.
+ */
+int epir_batch_ctx_init(
+	epir_batch_ctx *ctx, const uint64_t n_elements, const uint32_t max_batch, const uint8_t n_indexes, const uint64_t seed);
+
+/**
+ * Destroy the `epir_batch_ctx`.
+ */
+void epir_batch_ctx_destroy(epir_batch_ctx *ctx);
+
+/**
+ * Compute the number of ciphers of a batch selector (the selectors of all the buckets).
+ */
+uint64_t epir_batch_ciphers_count(const epir_batch_ctx *ctx);
+
+/**
+ * Returns the position of `idx` in the bucket, or -1 if the bucket does not hold it (or does not exist).
+ */
+int64_t epir_batch_position(const epir_batch_ctx *ctx, const uint32_t bucket, const uint64_t idx);
+
+/**
+ * Assign distinct buckets to the (distinct) indexes by cuckoo hashing.
+ * @param buckets The bucket of `idxs[i]` is written to `buckets[i]`.
+ * @return Zero if success, otherwise -1 (if an index is out of range, or no assignment is found).
+ */
+int epir_batch_assign(const epir_batch_ctx *ctx, uint32_t *buckets, const uint64_t *idxs, const size_t n_idxs);
+
+typedef int (epir_batch_selector_create_fn)(
+	unsigned char *ciphers, const unsigned char *key,
+	const epir_batch_ctx *ctx, uint32_t *buckets, const uint64_t *idxs, const size_t n_idxs);
+
+/**
+ * Create a batch selector (normal): the concatenated selectors of all the buckets.
+ * The buckets with no index assigned query a dummy element.
+ * @param ciphers The buffer of `epir_batch_ciphers_count(ctx) * EPIR_CIPHER_SIZE` bytes.
+ * @param key     Public key.
+ * @param buckets The buckets assigned to the indexes (see `epir_batch_assign()`).
+ * @return Zero if success, otherwise -1.
+ */
+epir_batch_selector_create_fn epir_batch_selector_create;
+
+/**
+ * Create a batch selector (fast).
+ * @param key Private key.
+ */
+epir_batch_selector_create_fn epir_batch_selector_create_fast;
+
+/**
+ * Decrypt a server's reply to a batch selector (the concatenated replies of all the buckets).
+ * Only the buckets assigned to the indexes are decrypted.
+ * @param elems      The `n_idxs * elem_size` bytes buffer to write the elements.
+ * @param reply      The server's reply (destroyed).
+ * @param reply_size The number of bytes of `reply`.
+ * @param buckets    The buckets assigned to the indexes on the selector creation.
+ * @return Zero if success, otherwise -1. A `reply_size` which is not a multiple of the number of buckets
+ *         and a bucket which does not exist are rejected before anything is decrypted (the reply is kept).
+ */
+int epir_batch_reply_decrypt(
+	unsigned char *elems, const size_t elem_size, unsigned char *reply, const size_t reply_size,
+	const unsigned char *privkey, const uint8_t dimension, const uint8_t packing, const epir_mG_t *mG, const size_t mmax,
+	const epir_batch_ctx *ctx, const uint32_t *buckets, const size_t n_idxs);
+
+/**
+ * The size of a cache line, by which the fields written by different threads are separated.
+ */
+#define EPIR_CACHE_LINE_SIZE (64)
+
+/**
+ * A lock-free bounded ring of ciphers (multi-producer, multi-consumer) used by the selector factory.
+ * The counters increase monotonically and the n-th cipher is stored at the slot `n % capacity`.
+ * Producers (consumers) reserve a contiguous range with a CAS on `write_reserved` (`read_reserved`),
+ * copy the ciphers outside any lock and publish the range by advancing `write_committed` (`read_committed`) in order.
+ * The counters are padded (not aligned) to separate cache lines, thus the context may be allocated by `malloc()`.
+ */
+typedef struct {
+	unsigned char pad0[EPIR_CACHE_LINE_SIZE];
+	uint64_t write_reserved;
+	unsigned char pad1[EPIR_CACHE_LINE_SIZE - sizeof(uint64_t)];
+	uint64_t write_committed;
+	unsigned char pad2[EPIR_CACHE_LINE_SIZE - sizeof(uint64_t)];
+	uint64_t read_reserved;
+	unsigned char pad3[EPIR_CACHE_LINE_SIZE - sizeof(uint64_t)];
+	uint64_t read_committed;
+	unsigned char pad4[EPIR_CACHE_LINE_SIZE - sizeof(uint64_t)];
+} epir_selector_factory_ring;
+
+/**
+ * The configuration of the background replenisher of the selector factory.
+ */
+typedef struct {
+	/** The replenisher wakes up when the pool has less ciphers than this, including the ciphers being written or read (0 means a half of the high watermark). */
+	uint32_t low_watermark;
+	/** The replenisher refills the pool up to this, counted in the same way (0 or larger than the capacity means the capacity). */
+	uint32_t high_watermark;
+	/** The nice value of the replenisher threads (0 keeps the current one). */
+	int nice;
+	/** The maximum number of ciphers encrypted per second (0 means unlimited). */
+	uint32_t rate_limit;
+	/** The number of OpenMP threads used by the replenisher (0 means the default). */
+	uint32_t n_threads;
+} epir_selector_factory_replenisher_config;
+
+/**
+ * The number of buckets of the refill latency histogram (the bucket `b` counts the latencies of [2^b, 2^(b+1)) microseconds).
+ */
+#define EPIR_SELECTOR_FACTORY_LATENCY_BUCKETS (32)
+
+/**
+ * The raw counters of the selector factory, updated with relaxed atomics.
+ */
+typedef struct {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t empties;
+	uint64_t produced;
+	uint64_t fill_ns;
+	uint64_t commit_wait_ns;
+	uint64_t refill_latency[EPIR_SELECTOR_FACTORY_LATENCY_BUCKETS];
+} epir_selector_factory_counters;
+
+/**
+ * A snapshot of the selector factory statistics.
+ */
+typedef struct {
+	/** The number of selectors created from the cache. */
+	uint64_t hits;
+	/** The number of selectors failed to be created because of insufficient ciphers. */
+	uint64_t misses;
+	/** The number of times the cache went empty (including the misses on an empty cache). */
+	uint64_t empties;
+	/** The number of ciphers currently available. */
+	uint32_t depth;
+	uint32_t capacity;
+	/** The total number of ciphers produced. */
+	uint64_t produced;
+	/** The number of ciphers produced per second of filling. */
+	double produced_per_second;
+	/** The time (in seconds) spent waiting for the preceding ranges of the ring to be published (the ring has no locks otherwise). */
+	double commit_wait_seconds;
+	/** The percentiles of the refill (a single pass of filling) latencies in seconds (upper bounds of the histogram buckets). */
+	double refill_latency_p50;
+	double refill_latency_p90;
+	double refill_latency_p99;
+} epir_selector_factory_stats;
+
 typedef struct {
 	bool is_fast;
 	unsigned char key[32];
-	uint32_t capacities[2];
-	unsigned char *ciphers[2];
-	int32_t idx[2];
-	pthread_mutex_t mutex;
+	/** False if `pubkey_ctx` and `ciphers` are in a caller-owned workspace. */
+	bool owns_buffers;
+	epir_pubkey_ctx *pubkey_ctx;
+	uint32_t capacity;
+	unsigned char *ciphers;
+	epir_selector_factory_ring ring;
 	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool replenishing;
+	bool stopping;
+	epir_selector_factory_replenisher_config replenisher_config;
+	pthread_t replenisher_thread;
+	/** The executor which fills the pool (NULL means OpenMP). */
+	epir_executor *executor;
+	/** The counters updated by all the threads are kept off the cache lines of the fields above. */
+	unsigned char counters_pad[EPIR_CACHE_LINE_SIZE];
+	epir_selector_factory_counters counters;
 } epir_selector_factory_ctx;
 
 typedef int (epir_selector_factory_ctx_init_fn)(
@@ -319,6 +1223,8 @@ typedef int (epir_selector_factory_ctx_init_fn)(
 
 /**
  * Initialize the `epir_selector_factory_ctx` from given public key (normal).
+ * The ciphers of one are derived from the ciphers of zero on demand,
+ * thus a single pool of `capacity_zero + capacity_one` ciphers is allocated.
  * @param key Public key.
  */
 epir_selector_factory_ctx_init_fn epir_selector_factory_ctx_init;
@@ -329,13 +1235,57 @@ epir_selector_factory_ctx_init_fn epir_selector_factory_ctx_init;
  */
 epir_selector_factory_ctx_init_fn epir_selector_factory_ctx_init_fast;
 
+/**
+ * Returns the byte size of the workspace of `epir_selector_factory_ctx_init[_fast]_workspace()`.
+ */
+size_t epir_selector_factory_ctx_workspace_size(const bool is_fast, const uint32_t capacity_zero, const uint32_t capacity_one);
+
+typedef int (epir_selector_factory_ctx_init_workspace_fn)(
+	epir_selector_factory_ctx *ctx, const unsigned char *key, const uint32_t capacity_zero, const uint32_t capacity_one,
+	unsigned char *workspace);
+
+/**
+ * The same as `epir_selector_factory_ctx_init()` keeping the public key context and the ciphers
+ * in the caller-owned `workspace` (of `epir_selector_factory_ctx_workspace_size(false, ...)` bytes, aligned as `malloc()`).
+ * The workspace should outlive the context; `epir_selector_factory_ctx_destroy()` does not free it.
+ */
+epir_selector_factory_ctx_init_workspace_fn epir_selector_factory_ctx_init_workspace;
+
+/**
+ * The same as `epir_selector_factory_ctx_init_fast()` using the caller-owned `workspace`
+ * (of `epir_selector_factory_ctx_workspace_size(true, ...)` bytes).
+ */
+epir_selector_factory_ctx_init_workspace_fn epir_selector_factory_ctx_init_fast_workspace;
+
 /**
  * Destroy the `epir_selector_factory_ctx`.
  */
 int epir_selector_factory_ctx_destroy(epir_selector_factory_ctx *ctx);
 
+/**
+ * Returns the number of ciphers available in the selector cache.
+ */
+uint32_t epir_selector_factory_available(epir_selector_factory_ctx *ctx);
+
+/**
+ * Take a snapshot of the statistics of the selector factory.
+ */
+void epir_selector_factory_get_stats(epir_selector_factory_ctx *ctx, epir_selector_factory_stats *stats);
+
+/**
+ * Take a snapshot of the memory held by the selector factory (the public key context and the cipher cache).
+ */
+void epir_selector_factory_memory_usage(epir_selector_factory_ctx *ctx, epir_memory_usage *usage);
+
+/**
+ * Set the executor which fills the pool (NULL, the default, means OpenMP).
+ * The executor should outlive the context, and should not be changed while the pool is filled.
+ */
+void epir_selector_factory_set_executor(epir_selector_factory_ctx *ctx, epir_executor *exec);
+
 /**
  * Fill selector caches synchronously.
+ * @return Zero if success, or 2 if some ciphers were discarded because the cache was filled concurrently.
  */
 int epir_selector_factory_fill_sync(epir_selector_factory_ctx *ctx);
 
@@ -346,13 +1296,286 @@ int epir_selector_factory_fill_sync(epir_selector_factory_ctx *ctx);
  */
 int epir_selector_factory_fill(epir_selector_factory_ctx *ctx);
 
+/**
+ * Start the background replenisher, which refills the pool up to its high watermark
+ * whenever it drops below its low watermark.
+ * @param config The configuration. If set to NULL, the default (all zeros) is used.
+ * @return Zero if success, otherwise an error code (or -1 if the replenisher is already running).
+ */
+int epir_selector_factory_start_replenisher(
+	epir_selector_factory_ctx *ctx, const epir_selector_factory_replenisher_config *config);
+
+/**
+ * Stop the background replenisher and wait for it to exit.
+ * @return Zero if success, otherwise an error code (or -1 if the replenisher is not running).
+ */
+int epir_selector_factory_stop_replenisher(epir_selector_factory_ctx *ctx);
+
+/**
+ * Move the unused ciphers of the selector cache to a file (the ciphers saved are removed from the cache).
+ * The file is created exclusively (with the mode 0600) as `path`.tmp and atomically renamed to `path`.
+ * Concurrent saves to the same path are serialized by locking `path`.lock (which is left in place).
+ * @return The number of ciphers saved, or a negative value on error.
+ */
+int64_t epir_selector_factory_save(epir_selector_factory_ctx *ctx, const char *path);
+
+/**
+ * Load the ciphers saved by `epir_selector_factory_save()` into the selector cache (as many as fit).
+ * The loaded ciphers are durably marked as consumed in the file (msync) before they become usable,
+ * thus no cipher is reused even after a crash. The remaining ciphers are kept for the next load.
+ * Concurrent loads (and saves) of the same path, even by other processes, are serialized by locking `path`.lock.
+ * @return The number of ciphers loaded, -1 on I/O errors, or -2 if the file is broken or saved with another key.
+ */
+int64_t epir_selector_factory_load(epir_selector_factory_ctx *ctx, const char *path);
+
 /**
  * Create a selector using the given selector factory context.
+ * Returns -1 without blocking if the pool does not have enough ciphers.
  */
 int epir_selector_factory_create_selector(
 	unsigned char *ciphers, epir_selector_factory_ctx *ctx,
 	const uint64_t *index_counts, const uint8_t n_indexes, const uint64_t idx);
 
+/**
+ * The configuration of the multi-key selector factory pool.
+ */
+typedef struct {
+	/** The memory (in bytes) shared by the caches of all the keys. */
+	uint64_t memory_budget;
+	/** The maximum number of keys. */
+	uint32_t max_keys;
+	/** The number of worker threads shared by all the keys (0 means the number of processors). */
+	uint32_t n_workers;
+	/** The nice value of the worker threads (0 keeps the current one). */
+	int nice;
+} epir_selector_factory_pool_config;
+
+/**
+ * A key managed by the selector factory pool.
+ */
+typedef struct {
+	epir_selector_factory_ctx factory;
+	/** Held for reading while the cache is used, and for writing while it is resized. */
+	pthread_rwlock_t lock;
+	/** The number of ciphers requested since the last tick. */
+	uint64_t demand;
+	/** The number of ciphers of the last selector requested (the cache is kept at least this large while the key is used). */
+	uint64_t selector_ciphers;
+	/** The exponentially weighted moving average of the ciphers requested per second. */
+	double rate;
+	bool refilling;
+	bool busy;
+} epir_selector_factory_pool_entry;
+
+/**
+ * Manages the selector caches of many keys with a fixed set of worker threads.
+ * The memory budget is distributed to the keys by their recent consumption rates,
+ * and the workers refill the hottest keys first. The caches of idle keys are released.
+ */
+typedef struct {
+	epir_selector_factory_pool_config config;
+	epir_selector_factory_pool_entry **entries;
+	/** The number of ciphers allocated for all the caches. */
+	uint64_t allocated;
+	double last_tick;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool stopping;
+	pthread_t *workers;
+} epir_selector_factory_pool;
+
+/**
+ * Initialize the `epir_selector_factory_pool` and start the worker threads.
+ */
+int epir_selector_factory_pool_init(epir_selector_factory_pool *pool, const epir_selector_factory_pool_config *config);
+
+/**
+ * Stop the worker threads and destroy the `epir_selector_factory_pool` (including all the keys).
+ */
+int epir_selector_factory_pool_destroy(epir_selector_factory_pool *pool);
+
+typedef int64_t (epir_selector_factory_pool_add_key_fn)(epir_selector_factory_pool *pool, const unsigned char *key);
+
+/**
+ * Add a public key (normal) to the pool.
+ * The cache is not allocated until the key is used.
+ * @return The key ID, or a negative value on error (or if the pool is full).
+ */
+epir_selector_factory_pool_add_key_fn epir_selector_factory_pool_add_key;
+
+/**
+ * Add a private key (fast) to the pool.
+ * @return The key ID, or a negative value on error (or if the pool is full).
+ */
+epir_selector_factory_pool_add_key_fn epir_selector_factory_pool_add_key_fast;
+
+/**
+ * Remove a key from the pool.
+ * The functions using the key concurrently finish with its cache before it is freed,
+ * and fail as an invalid key ID once it is removed.
+ * @return Zero if success, otherwise (if the key ID is invalid or already removed) a negative value.
+ */
+int epir_selector_factory_pool_remove_key(epir_selector_factory_pool *pool, const uint32_t key_id);
+
+/**
+ * Returns the number of ciphers available in the cache of the key (zero if the key ID is invalid or removed).
+ */
+uint32_t epir_selector_factory_pool_available(epir_selector_factory_pool *pool, const uint32_t key_id);
+
+/**
+ * Take a snapshot of the statistics of the cache of the key.
+ * @return Zero if success, otherwise (if the key ID is invalid or removed) a negative value.
+ */
+int epir_selector_factory_pool_get_stats(
+	epir_selector_factory_pool *pool, const uint32_t key_id, epir_selector_factory_stats *stats);
+
+/**
+ * Take a snapshot of the memory held by the pool (the caches of all the keys and the bookkeeping).
+ */
+void epir_selector_factory_pool_memory_usage(epir_selector_factory_pool *pool, epir_memory_usage *usage);
+
+/**
+ * Create a selector using the cache of the key.
+ * Returns -1 without blocking if the cache does not have enough ciphers (or if the key ID is invalid or removed).
+ * Failed requests also count in the consumption rate, thus the cache is warmed up for the next request.
+ */
+int epir_selector_factory_pool_create_selector(
+	unsigned char *ciphers, epir_selector_factory_pool *pool, const uint32_t key_id,
+	const uint64_t *index_counts, const uint8_t n_indexes, const uint64_t idx);
+
+typedef struct epir_job epir_job;
+
+/**
+ * The result of a job cancelled before it started.
+ */
+#define EPIR_JOB_CANCELLED (-2)
+
+/**
+ * Called on a thread of the executor when the job completes, after the file descriptor is written.
+ * The job is marked done when the callback returns, thus `epir_job_wait()` and `epir_job_destroy()`
+ * of other threads return after it (and `cb_data` may be freed then).
+ * In the callback, the job may be waited for (which returns the result without blocking) and destroyed (and freed),
+ * but not polled nor submitted again.
+ * @param result The result of the job (the same as `job->result`).
+ */
+typedef void (*epir_job_callback_fn)(epir_job *job, const int result, void *cb_data);
+
+/**
+ * An asynchronous job, which runs a blocking function on an executor.
+ * Submit it with one of the `*_submit()` functions, and wait for the completion
+ * with `epir_job_poll()`, `epir_job_wait()`, the callback or the eventfd.
+ */
+struct epir_job {
+	/** The executor which runs the job (and its parallel loops). */
+	epir_executor *exec;
+	epir_job_callback_fn cb;
+	void *cb_data;
+	/** The file descriptor to which an 8 bytes integer of 1 is written on the completion (e.g. an eventfd), or -1. */
+	int fd;
+	/** The result: the value returned by the blocking function (zero if it returns nothing). */
+	int result;
+	bool done;
+	bool cancelled;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	void (*run)(epir_job*);
+	union {
+		struct {
+			unsigned char *ciphers;
+			const unsigned char *key;
+			const epir_pubkey_ctx *ctx;
+			const uint64_t *index_counts;
+			uint8_t n_indexes;
+			uint64_t idx;
+			const unsigned char *r;
+		} selector_create;
+		struct {
+			unsigned char *reply;
+			size_t reply_size;
+			const unsigned char *privkey;
+			uint8_t dimension;
+			uint8_t packing;
+			const epir_mG_t *mG;
+			size_t mmax;
+		} reply_decrypt;
+		struct {
+			epir_mG_t *mG;
+			size_t mmax;
+			void (*cb)(const size_t, void*);
+			void *cb_data;
+		} mG_generate;
+	} args;
+};
+
+/**
+ * Initialize a job.
+ * @param exec    The executor (NULL means `epir_executor_default()`).
+ *                `EPIR_EXECUTOR_INLINE` runs the job on submission (blocking).
+ * @param cb      The callback called on the completion, or NULL.
+ * @param cb_data The user data for `cb`.
+ * @param fd      The file descriptor to notify on the completion (e.g. `eventfd(0, EFD_NONBLOCK)`), or -1.
+ *                The file descriptor is owned by the caller.
+ * @return Zero if success, otherwise an error code.
+ */
+int epir_job_init(epir_job *job, epir_executor *exec, epir_job_callback_fn cb, void *cb_data, const int fd);
+
+/**
+ * Destroy the job (waits for the completion, including the file descriptor write and the callback, if submitted).
+ */
+int epir_job_destroy(epir_job *job);
+
+/**
+ * Returns true if the job is completed, including the file descriptor write and the callback (without blocking).
+ */
+bool epir_job_poll(epir_job *job);
+
+/**
+ * Cancel the job if it has not started (the job completes with the result `EPIR_JOB_CANCELLED`).
+ * A job which has started runs to the end. Cancelling a job which is not pending has no effect (each submission resets it).
+ */
+void epir_job_cancel(epir_job *job);
+
+/**
+ * Wait for the completion of the job, including the file descriptor write and the callback. Returns the result.
+ * In the callback of the job, returns the result without waiting.
+ */
+int epir_job_wait(epir_job *job);
+
+/**
+ * Submit `epir_selector_create()` as a job. The buffers should be kept until the completion.
+ * @return Zero if submitted, otherwise a negative value.
+ */
+int epir_selector_create_submit(
+	epir_job *job, unsigned char *ciphers, const unsigned char *pubkey,
+	const uint64_t *index_counts, const uint8_t n_indexes, const uint64_t idx, const unsigned char *r);
+
+/**
+ * Submit `epir_selector_create_fast()` as a job.
+ */
+int epir_selector_create_fast_submit(
+	epir_job *job, unsigned char *ciphers, const unsigned char *privkey,
+	const uint64_t *index_counts, const uint8_t n_indexes, const uint64_t idx, const unsigned char *r);
+
+/**
+ * Submit `epir_selector_create_ctx()` as a job.
+ */
+int epir_selector_create_ctx_submit(
+	epir_job *job, unsigned char *ciphers, const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes, const uint64_t idx, const unsigned char *r);
+
+/**
+ * Submit `epir_reply_decrypt()` as a job. The result is the value returned by `epir_reply_decrypt()`.
+ */
+int epir_reply_decrypt_submit(
+	epir_job *job, unsigned char *reply, const size_t reply_size, const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing, const epir_mG_t *mG, const size_t mmax);
+
+/**
+ * Submit `epir_mG_generate()` as a job. `cb` is called on the threads of the executor.
+ */
+int epir_mG_generate_submit(
+	epir_job *job, epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data);
+
 #ifdef __cplusplus
 }
 #endif
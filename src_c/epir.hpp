@@ -10,6 +10,14 @@
 #include <array>
 #include <string>
 #include <algorithm>
+#include <memory>
+#include <functional>
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+#include <coroutine>
+#include <optional>
+#include <stop_token>
+#define EPIR_HAS_COROUTINES 1
+#endif
 
 #include "epir.h"
 
@@ -21,6 +29,142 @@ namespace EllipticPIR {
 		return std::string(path_default);
 	}
 	
+	/**
+	 * Calibrate the cost model on this machine (see `epir_cost_model_calibrate()`).
+	 */
+	static inline epir_cost_model costModelCalibrate() {
+		epir_cost_model model;
+		epir_cost_model_calibrate(&model);
+		return model;
+	}
+	
+	/**
+	 * Find the Pareto-optimal parameter sets (see `epir_params_optimize()`).
+	 */
+	static inline std::vector<epir_params> paramsOptimize(
+		const uint64_t nElements, const size_t elemSize, const epir_cost_model &model, const size_t mmax = EPIR_DEFAULT_MG_MAX) {
+		std::vector<epir_params> params(epir_params_optimize(NULL, 0, nElements, elemSize, mmax, &model));
+		epir_params_optimize(params.data(), params.size(), nElements, elemSize, mmax, &model);
+		return params;
+	}
+	
+	/**
+	 * Aggregate the timers and the counters of the reply decryption (see `epir_profile_get()`).
+	 */
+	static inline epir_profile_stats profileGet() {
+		epir_profile_stats stats;
+		epir_profile_get(&stats);
+		return stats;
+	}
+	
+	/**
+	 * Read the process-wide counters of the heap memory allocated by the library (see `epir_memory_get()`).
+	 */
+	static inline epir_memory_stats memoryGet() {
+		epir_memory_stats stats;
+		epir_memory_get(&stats);
+		return stats;
+	}
+	
+	/**
+	 * A persistent pool of threads which runs the parallel loops (see `epir_executor`).
+	 */
+	class Executor {
+		private:
+			epir_executor exec;
+		public:
+			Executor(const uint32_t nThreads = 0) {
+				if(epir_executor_init(&this->exec, nThreads) != 0) throw "Failed to initialize the executor.";
+			}
+			/**
+			 * Bind the threads round-robin to the NUMA nodes (see `epir_executor_init_numa()`).
+			 */
+			Executor(const uint32_t nThreads, const uint32_t nNodes) {
+				if(epir_executor_init_numa(&this->exec, nThreads, nNodes) != 0) throw "Failed to initialize the executor.";
+			}
+			Executor(const Executor&) = delete;
+			Executor &operator=(const Executor&) = delete;
+			~Executor() {
+				epir_executor_destroy(&this->exec);
+			}
+			epir_executor *get() {
+				return &this->exec;
+			}
+	};
+	
+#ifdef EPIR_HAS_COROUTINES
+	/**
+	 * Awaits an asynchronous job (see `epir_job`) in a C++20 coroutine.
+	 * The coroutine is resumed on the thread of the executor which completed the job.
+	 * A stop request of the `stopToken` cancels the job if it has not started (then `co_await` throws).
+	 * `co_await` also throws if the job could not be submitted.
+	 */
+	template<typename T>
+	class JobAwaitable {
+		private:
+			struct Canceller {
+				epir_job *job;
+				void operator()() const {
+					epir_job_cancel(this->job);
+				}
+			};
+			epir_job job;
+			std::function<int(epir_job*)> submit;
+			std::function<T(const int)> complete;
+			std::stop_token stopToken;
+			std::optional<std::stop_callback<Canceller>> stopCallback;
+			std::coroutine_handle<> handle;
+			int submitResult = 0;
+			static void resume(epir_job*, const int, void *self) {
+				((JobAwaitable*)self)->handle.resume();
+			}
+		public:
+			/**
+			 * @param submit   Submits the job (returns zero if submitted).
+			 * @param complete Returns the value of `co_await` from the result of the job.
+			 *                 Keeps the buffers of the job alive (it lives until the awaitable is destroyed).
+			 */
+			JobAwaitable(
+				std::function<int(epir_job*)> submit, std::function<T(const int)> complete,
+				epir_executor *exec = NULL, std::stop_token stopToken = {}) :
+				submit(std::move(submit)), complete(std::move(complete)), stopToken(stopToken) {
+				if(epir_job_init(&this->job, exec, resume, this, -1) != 0) throw "Failed to initialize the job.";
+			}
+			JobAwaitable(const JobAwaitable&) = delete;
+			JobAwaitable &operator=(const JobAwaitable&) = delete;
+			~JobAwaitable() {
+				this->stopCallback.reset();
+				epir_job_destroy(&this->job);
+			}
+			bool await_ready() const noexcept {
+				return false;
+			}
+			bool await_suspend(std::coroutine_handle<> handle) {
+				this->handle = handle;
+				// The submission resets the cancellation, thus a stop requested before it is checked here.
+				if(this->stopToken.stop_requested()) {
+					this->submitResult = EPIR_JOB_CANCELLED;
+					return false;
+				}
+				this->stopCallback.emplace(this->stopToken, Canceller{ &this->job });
+				// The coroutine may be resumed (and this awaitable destroyed) before `submit()` returns.
+				const std::function<int(epir_job*)> submit = std::move(this->submit);
+				const int ret = submit(&this->job);
+				if(ret == 0) return true;
+				this->submitResult = ret;
+				return false;
+			}
+			T await_resume() {
+				this->stopCallback.reset();
+				if(this->submitResult == EPIR_JOB_CANCELLED) throw "The job is cancelled.";
+				if(this->submitResult != 0) throw "Failed to submit the job.";
+				const int result = epir_job_wait(&this->job);
+				if(result == EPIR_JOB_CANCELLED) throw "The job is cancelled.";
+				return this->complete(result);
+			}
+	};
+#endif
+	
 	class Cipher : public std::array<unsigned char, EPIR_CIPHER_SIZE> {
 		public:
 			Cipher() {}
@@ -28,6 +172,7 @@ namespace EllipticPIR {
 				memcpy(this->data(), cipher, EPIR_CIPHER_SIZE);
 			}
 	};
+	static_assert(sizeof(Cipher) == EPIR_CIPHER_SIZE, "std::vector<Cipher> should be a contiguous ciphers buffer.");
 	
 	class Scalar : public std::array<unsigned char, EPIR_SCALAR_SIZE> {
 		public:
@@ -44,6 +189,7 @@ namespace EllipticPIR {
 				memcpy(this->data(), buf, EPIR_SCALAR_SIZE);
 			}
 	};
+	static_assert(sizeof(Scalar) == EPIR_SCALAR_SIZE, "std::vector<Scalar> should be a contiguous scalars buffer.");
 	
 	class IndexCounts : public std::vector<uint64_t> {
 		public:
@@ -80,6 +226,14 @@ namespace EllipticPIR {
 			 * Encrypt a message using a given randomness.
 			 */
 			virtual Cipher encrypt(const uint64_t message, const Scalar &r) const = 0;
+			/**
+			 * Encrypt messages at once.
+			 */
+			virtual std::vector<Cipher> encryptBulk(const std::vector<uint64_t> &messages) const = 0;
+			/**
+			 * Encrypt messages at once using given randomnesses (one for each message).
+			 */
+			virtual std::vector<Cipher> encryptBulk(const std::vector<uint64_t> &messages, const std::vector<Scalar> &r) const = 0;
 			/**
 			 * Create a selector with random entropy.
 			 */
@@ -88,6 +242,38 @@ namespace EllipticPIR {
 			 * Create a selector with given randomness.
 			 */
 			virtual Selector createSelector(const IndexCounts &indexCounts, const uint64_t idx, const Scalar &r) const = 0;
+			/**
+			 * Create a selector with random entropy using the executor.
+			 * The default implementation ignores the executor (for the encryptors which do not support one).
+			 */
+			virtual Selector createSelector(const IndexCounts &indexCounts, const uint64_t idx, Executor &executor) const {
+				(void)executor;
+				return this->createSelector(indexCounts, idx);
+			}
+			/**
+			 * Receives a chunk of a selector (see `epir_selector_sink_fn`).
+			 */
+			typedef std::function<int(const unsigned char *ciphers, const uint64_t offset, const size_t n)> SelectorSink;
+			/**
+			 * Create a selector in chunks (see `epir_selector_create_stream()`).
+			 * Returns zero, the non-zero value returned by the sink, or -1 on error.
+			 */
+			virtual int createSelectorStream(
+				const IndexCounts &indexCounts, const uint64_t idx, const SelectorSink &sink, const size_t chunkSize = 0) const = 0;
+			/**
+			 * Create a selector in chunks using the executor (see `epir_selector_create_stream_ex()`).
+			 * The default implementation ignores the executor (for the encryptors which do not support one).
+			 */
+			virtual int createSelectorStream(
+				const IndexCounts &indexCounts, const uint64_t idx, const SelectorSink &sink, Executor &executor,
+				const size_t chunkSize = 0) const {
+				(void)executor;
+				return this->createSelectorStream(indexCounts, idx, sink, chunkSize);
+			}
+		protected:
+			static int selectorSink(const unsigned char *ciphers, const uint64_t offset, const size_t n, void *sink) {
+				return (*(const SelectorSink*)sink)(ciphers, offset, n);
+			}
 		
 	};
 	
@@ -105,6 +291,17 @@ namespace EllipticPIR {
 				epir_ecelgamal_encrypt_fast(cipher.data(), this->data(), message, r.data());
 				return cipher;
 			}
+			std::vector<Cipher> encryptBulk(const std::vector<uint64_t> &messages) const override {
+				std::vector<Cipher> ciphers(messages.size());
+				epir_ecelgamal_encrypt_bulk_fast(ciphers.data()->data(), this->data(), messages.data(), messages.size(), NULL);
+				return ciphers;
+			}
+			std::vector<Cipher> encryptBulk(const std::vector<uint64_t> &messages, const std::vector<Scalar> &r) const override {
+				if(r.size() != messages.size()) throw "The number of randomnesses does not match.";
+				std::vector<Cipher> ciphers(messages.size());
+				epir_ecelgamal_encrypt_bulk_fast(ciphers.data()->data(), this->data(), messages.data(), messages.size(), r.data()->data());
+				return ciphers;
+			}
 			Selector createSelector(const IndexCounts &indexCounts, const uint64_t idx) const override {
 				Selector selector(indexCounts.ciphersCount());
 				epir_selector_create_fast(selector.data(), this->data(), indexCounts.data(), indexCounts.size(), idx, NULL);
@@ -115,46 +312,187 @@ namespace EllipticPIR {
 				epir_selector_create_fast(selector.data(), this->data(), indexCounts.data(), indexCounts.size(), idx, r.data());
 				return selector;
 			}
+			Selector createSelector(const IndexCounts &indexCounts, const uint64_t idx, Executor &executor) const override {
+				Selector selector(indexCounts.ciphersCount());
+				epir_selector_create_fast_ex(
+					selector.data(), this->data(), indexCounts.data(), indexCounts.size(), idx, NULL, executor.get());
+				return selector;
+			}
+			int createSelectorStream(
+				const IndexCounts &indexCounts, const uint64_t idx, const SelectorSink &sink, const size_t chunkSize = 0) const override {
+				return epir_selector_create_stream_fast(
+					this->data(), indexCounts.data(), indexCounts.size(), idx, NULL, chunkSize, selectorSink, (void*)&sink);
+			}
+			int createSelectorStream(
+				const IndexCounts &indexCounts, const uint64_t idx, const SelectorSink &sink, Executor &executor,
+				const size_t chunkSize = 0) const override {
+				return epir_selector_create_stream_fast_ex(
+					this->data(), indexCounts.data(), indexCounts.size(), idx, NULL, chunkSize, selectorSink, (void*)&sink,
+					executor.get());
+			}
+#ifdef EPIR_HAS_COROUTINES
+			/**
+			 * Create a selector asynchronously: `co_await privkey.createSelectorAsync(indexCounts, idx)`.
+			 */
+			JobAwaitable<Selector> createSelectorAsync(
+				const IndexCounts &indexCounts, const uint64_t idx, Executor *executor = NULL, std::stop_token stopToken = {}) const {
+				struct State {
+					Selector selector;
+					IndexCounts indexCounts;
+					PrivateKey privkey;
+				};
+				auto state = std::make_shared<State>(State{ Selector(indexCounts.ciphersCount()), indexCounts, *this });
+				return JobAwaitable<Selector>([state, idx](epir_job *job) {
+					return epir_selector_create_fast_submit(
+						job, state->selector.data(), state->privkey.data(), state->indexCounts.data(), state->indexCounts.size(), idx, NULL);
+				}, [state](const int) {
+					return std::move(state->selector);
+				}, executor ? executor->get() : NULL, stopToken);
+			}
+#endif
 	};
 	
 	class Point : public std::array<unsigned char, EPIR_POINT_SIZE> {};
 	
 	class PublicKey : public Point, Encryptor {
+		private:
+			std::shared_ptr<epir_pubkey_ctx> ctx;
+			void initContext() {
+				this->ctx = std::make_shared<epir_pubkey_ctx>();
+				// Keep the behavior of the context-less functions for an invalid public key.
+				if(epir_pubkey_ctx_init(this->ctx.get(), this->data()) != 0) this->ctx.reset();
+			}
 		public:
 			/**
 			 * Create a new PublicKey instance using a PrivateKey.
 			 */
 			PublicKey(const PrivateKey &privkey) {
 				epir_pubkey_from_privkey(this->data(), privkey.data());
+				this->initContext();
 			}
 			/**
 			 * Create a new PublicKey instance with a given buffer.
 			 */
 			PublicKey(const unsigned char *buf) {
 				memcpy(this->data(), buf, EPIR_POINT_SIZE);
+				this->initContext();
 			}
 			Cipher encrypt(const uint64_t message) const override {
 				Cipher cipher;
-				epir_ecelgamal_encrypt(cipher.data(), this->data(), message, NULL);
+				if(this->ctx) {
+					epir_ecelgamal_encrypt_ctx(cipher.data(), this->ctx.get(), message, NULL);
+				} else {
+					epir_ecelgamal_encrypt(cipher.data(), this->data(), message, NULL);
+				}
 				return cipher;
 			}
 			Cipher encrypt(const uint64_t message, const Scalar &r) const override {
 				Cipher cipher;
-				epir_ecelgamal_encrypt(cipher.data(), this->data(), message, r.data());
+				if(this->ctx) {
+					epir_ecelgamal_encrypt_ctx(cipher.data(), this->ctx.get(), message, r.data());
+				} else {
+					epir_ecelgamal_encrypt(cipher.data(), this->data(), message, r.data());
+				}
 				return cipher;
 			}
+			std::vector<Cipher> encryptBulk(const std::vector<uint64_t> &messages) const override {
+				std::vector<Cipher> ciphers(messages.size());
+				if(this->ctx) {
+					epir_ecelgamal_encrypt_bulk_ctx(ciphers.data()->data(), this->ctx.get(), messages.data(), messages.size(), NULL);
+				} else {
+					epir_ecelgamal_encrypt_bulk(ciphers.data()->data(), this->data(), messages.data(), messages.size(), NULL);
+				}
+				return ciphers;
+			}
+			std::vector<Cipher> encryptBulk(const std::vector<uint64_t> &messages, const std::vector<Scalar> &r) const override {
+				if(r.size() != messages.size()) throw "The number of randomnesses does not match.";
+				std::vector<Cipher> ciphers(messages.size());
+				if(this->ctx) {
+					epir_ecelgamal_encrypt_bulk_ctx(
+						ciphers.data()->data(), this->ctx.get(), messages.data(), messages.size(), r.data()->data());
+				} else {
+					epir_ecelgamal_encrypt_bulk(ciphers.data()->data(), this->data(), messages.data(), messages.size(), r.data()->data());
+				}
+				return ciphers;
+			}
 			Selector createSelector(
 				const IndexCounts &indexCounts, const uint64_t idx) const override {
 				Selector selector(indexCounts.ciphersCount());
-				epir_selector_create(selector.data(), this->data(), indexCounts.data(), indexCounts.size(), idx, NULL);
+				if(this->ctx) {
+					epir_selector_create_ctx(selector.data(), this->ctx.get(), indexCounts.data(), indexCounts.size(), idx, NULL);
+				} else {
+					epir_selector_create(selector.data(), this->data(), indexCounts.data(), indexCounts.size(), idx, NULL);
+				}
 				return selector;
 			}
 			Selector createSelector(
 				const IndexCounts &indexCounts, const uint64_t idx, const Scalar &r) const override {
 				Selector selector(indexCounts.ciphersCount());
-				epir_selector_create(selector.data(), this->data(), indexCounts.data(), indexCounts.size(), idx, r.data());
+				if(this->ctx) {
+					epir_selector_create_ctx(selector.data(), this->ctx.get(), indexCounts.data(), indexCounts.size(), idx, r.data());
+				} else {
+					epir_selector_create(selector.data(), this->data(), indexCounts.data(), indexCounts.size(), idx, r.data());
+				}
 				return selector;
 			}
+			Selector createSelector(
+				const IndexCounts &indexCounts, const uint64_t idx, Executor &executor) const override {
+				Selector selector(indexCounts.ciphersCount());
+				if(this->ctx) {
+					epir_selector_create_ctx_ex(
+						selector.data(), this->ctx.get(), indexCounts.data(), indexCounts.size(), idx, NULL, executor.get());
+				} else {
+					epir_selector_create_ex(
+						selector.data(), this->data(), indexCounts.data(), indexCounts.size(), idx, NULL, executor.get());
+				}
+				return selector;
+			}
+			int createSelectorStream(
+				const IndexCounts &indexCounts, const uint64_t idx, const SelectorSink &sink, const size_t chunkSize = 0) const override {
+				if(this->ctx) {
+					return epir_selector_create_stream_ctx(
+						this->ctx.get(), indexCounts.data(), indexCounts.size(), idx, NULL, chunkSize, selectorSink, (void*)&sink);
+				}
+				return epir_selector_create_stream(
+					this->data(), indexCounts.data(), indexCounts.size(), idx, NULL, chunkSize, selectorSink, (void*)&sink);
+			}
+			int createSelectorStream(
+				const IndexCounts &indexCounts, const uint64_t idx, const SelectorSink &sink, Executor &executor,
+				const size_t chunkSize = 0) const override {
+				if(this->ctx) {
+					return epir_selector_create_stream_ctx_ex(
+						this->ctx.get(), indexCounts.data(), indexCounts.size(), idx, NULL, chunkSize, selectorSink, (void*)&sink,
+						executor.get());
+				}
+				return epir_selector_create_stream_ex(
+					this->data(), indexCounts.data(), indexCounts.size(), idx, NULL, chunkSize, selectorSink, (void*)&sink,
+					executor.get());
+			}
+#ifdef EPIR_HAS_COROUTINES
+			/**
+			 * Create a selector asynchronously: `co_await pubkey.createSelectorAsync(indexCounts, idx)`.
+			 */
+			JobAwaitable<Selector> createSelectorAsync(
+				const IndexCounts &indexCounts, const uint64_t idx, Executor *executor = NULL, std::stop_token stopToken = {}) const {
+				struct State {
+					Selector selector;
+					IndexCounts indexCounts;
+					Point pubkey;
+					std::shared_ptr<epir_pubkey_ctx> ctx;
+				};
+				auto state = std::make_shared<State>(State{ Selector(indexCounts.ciphersCount()), indexCounts, *this, this->ctx });
+				return JobAwaitable<Selector>([state, idx](epir_job *job) {
+					if(state->ctx) {
+						return epir_selector_create_ctx_submit(
+							job, state->selector.data(), state->ctx.get(), state->indexCounts.data(), state->indexCounts.size(), idx, NULL);
+					}
+					return epir_selector_create_submit(
+						job, state->selector.data(), state->pubkey.data(), state->indexCounts.data(), state->indexCounts.size(), idx, NULL);
+				}, [state](const int) {
+					return std::move(state->selector);
+				}, executor ? executor->get() : NULL, stopToken);
+			}
+#endif
 	};
 	
 	class Reply : public std::vector<unsigned char> {
@@ -209,25 +547,112 @@ namespace EllipticPIR {
 			}
 			/**
 			 * Generate mG.bin.
+			 * @param cadence The sampling cadence of `cb` (see `epir_progress_cadence`; NULL for the default cadence).
 			 */
 			static DecryptionContext generate(
-				void (*cb)(const size_t, void*) = NULL, void *cbData = NULL, const size_t mmax = EPIR_DEFAULT_MG_MAX) {
+				void (*cb)(const size_t, void*) = NULL, void *cbData = NULL, const size_t mmax = EPIR_DEFAULT_MG_MAX,
+				const epir_progress_cadence *cadence = NULL) {
 				DecryptionContext decCtx(mmax);
-				epir_mG_generate_no_sort(decCtx.data(), mmax, cb, cbData);
+				epir_mG_generate_no_sort_cadence_ex(decCtx.data(), mmax, cb, cbData, cadence, NULL);
 				std::sort(decCtx.begin(), decCtx.end(), [](const epir_mG_t &a, const epir_mG_t &b) {
 					return memcmp(a.point, b.point, EPIR_POINT_SIZE) < 0;
 				});
 				return decCtx;
 			}
+			/**
+			 * The memory held by the mG table.
+			 */
+			epir_memory_usage memoryUsage() const {
+				return { sizeof(epir_mG_t) * this->size(), sizeof(epir_mG_t) * this->capacity() };
+			}
 			int32_t decryptCipher(const PrivateKey &privkey, const Cipher &cipher) const {
 				return epir_ecelgamal_decrypt(privkey.data(), cipher.data(), this->data(), this->size());
 			}
+			/**
+			 * Decrypt a reply using the executor (or OpenMP if NULL).
+			 */
+			std::vector<unsigned char> decryptReply(
+				const PrivateKey &privkey, const Reply &reply, const uint8_t dimension, const uint8_t packing,
+				Executor *executor = NULL) const {
+				std::vector<unsigned char> buf(reply.size());
+				memcpy(buf.data(), reply.data(), reply.size());
+				int decryptedCount = epir_reply_decrypt_ex(
+					buf.data(), reply.size(), privkey.data(), dimension, packing, this->data(), this->size(),
+					executor ? executor->get() : NULL);
+				if(decryptedCount < 0) throw "Failed to decrypt.";
+				buf.resize(decryptedCount);
+				return buf;
+			}
+#ifdef EPIR_HAS_COROUTINES
+			/**
+			 * Decrypt a reply asynchronously: `co_await decCtx.decryptReplyAsync(privkey, reply, dimension, packing)`.
+			 * The context should be kept until the completion.
+			 */
+			JobAwaitable<std::vector<unsigned char>> decryptReplyAsync(
+				const PrivateKey &privkey, const Reply &reply, const uint8_t dimension, const uint8_t packing,
+				Executor *executor = NULL, std::stop_token stopToken = {}) const {
+				struct State {
+					std::vector<unsigned char> buf;
+					PrivateKey privkey;
+				};
+				auto state = std::make_shared<State>(State{ reply, privkey });
+				return JobAwaitable<std::vector<unsigned char>>([this, state, dimension, packing](epir_job *job) {
+					return epir_reply_decrypt_submit(
+						job, state->buf.data(), state->buf.size(), state->privkey.data(), dimension, packing, this->data(), this->size());
+				}, [state](const int decryptedCount) {
+					if(decryptedCount < 0) throw "Failed to decrypt.";
+					state->buf.resize(decryptedCount);
+					return std::move(state->buf);
+				}, executor ? executor->get() : NULL, stopToken);
+			}
+#endif
+	};
+	
+	/**
+	 * The mG table placed over the NUMA nodes by the policy (see `epir_mG_table`).
+	 */
+	class MGTable {
+		private:
+			epir_mG_table table;
+		public:
+			/**
+			 * Load mG.bin into the table (and its replicas).
+			 */
+			MGTable(const std::string path = "", const size_t mmax = EPIR_DEFAULT_MG_MAX,
+				const epir_numa_policy policy = EPIR_NUMA_INTERLEAVE, const uint32_t nNodes = 0) {
+				if(epir_mG_table_init(&this->table, mmax, policy, nNodes) != 0) throw "Failed to allocate the mG table.";
+				if(epir_mG_table_load(&this->table, (path == "" ? NULL : path.c_str())) != this->table.mmax) {
+					epir_mG_table_destroy(&this->table);
+					throw "Failed to load mG.bin.";
+				}
+			}
+			MGTable(const MGTable&) = delete;
+			MGTable &operator=(const MGTable&) = delete;
+			~MGTable() {
+				epir_mG_table_destroy(&this->table);
+			}
+			const epir_mG_table *get() const {
+				return &this->table;
+			}
+			/**
+			 * The memory held by the table (all the replicas).
+			 */
+			epir_memory_usage memoryUsage() const {
+				epir_memory_usage usage;
+				epir_mG_table_memory_usage(&this->table, &usage);
+				return usage;
+			}
+			/**
+			 * Decrypt a reply using the executor (or OpenMP if NULL), each task reading the replica of its node.
+			 */
 			std::vector<unsigned char> decryptReply(
-				const PrivateKey &privkey, const Reply &reply, const uint8_t dimension, const uint8_t packing) const {
+				const PrivateKey &privkey, const Reply &reply, const uint8_t dimension, const uint8_t packing,
+				Executor *executor = NULL) const {
 				std::vector<unsigned char> buf(reply.size());
 				memcpy(buf.data(), reply.data(), reply.size());
-				int decryptedCount = epir_reply_decrypt(
-					buf.data(), reply.size(), privkey.data(), dimension, packing, this->data(), this->size());
+				int decryptedCount = epir_reply_decrypt_table_ex(
+					buf.data(), reply.size(), privkey.data(), dimension, packing, &this->table,
+					executor ? executor->get() : NULL);
 				if(decryptedCount < 0) throw "Failed to decrypt.";
 				buf.resize(decryptedCount);
 				return buf;
@@ -247,12 +672,59 @@ namespace EllipticPIR {
 			SelectorFactory(const PublicKey &pubkey, const uint32_t capacityZero = 10'000, const uint32_t capacityOne = 100) {
 				epir_selector_factory_ctx_init(&this->ctx, pubkey.data(), capacityZero, capacityOne);
 			}
+			/**
+			 * Fill the pool using the executor (see `epir_selector_factory_set_executor()`).
+			 */
+			void setExecutor(Executor *executor) {
+				epir_selector_factory_set_executor(&this->ctx, executor ? executor->get() : NULL);
+			}
 			void fillSync() {
 				epir_selector_factory_fill_sync(&this->ctx);
 			}
 			void fill() {
 				epir_selector_factory_fill(&this->ctx);
 			}
+			/**
+			 * Start the background replenisher (see `epir_selector_factory_start_replenisher()`).
+			 */
+			void startReplenisher(const epir_selector_factory_replenisher_config *config = NULL) {
+				if(epir_selector_factory_start_replenisher(&this->ctx, config) != 0) throw "Failed to start the replenisher.";
+			}
+			void stopReplenisher() {
+				if(epir_selector_factory_stop_replenisher(&this->ctx) != 0) throw "Failed to stop the replenisher.";
+			}
+			/**
+			 * Move the unused ciphers to a file (see `epir_selector_factory_save()`).
+			 */
+			int64_t save(const std::string &path) {
+				const int64_t saved = epir_selector_factory_save(&this->ctx, path.c_str());
+				if(saved < 0) throw "Failed to save the selector factory.";
+				return saved;
+			}
+			/**
+			 * Load the ciphers from a file (see `epir_selector_factory_load()`).
+			 */
+			int64_t load(const std::string &path) {
+				const int64_t loaded = epir_selector_factory_load(&this->ctx, path.c_str());
+				if(loaded < 0) throw "Failed to load the selector factory.";
+				return loaded;
+			}
+			/**
+			 * Take a snapshot of the statistics (see `epir_selector_factory_get_stats()`).
+			 */
+			epir_selector_factory_stats getStats() {
+				epir_selector_factory_stats stats;
+				epir_selector_factory_get_stats(&this->ctx, &stats);
+				return stats;
+			}
+			/**
+			 * Take a snapshot of the memory held by the factory (see `epir_selector_factory_memory_usage()`).
+			 */
+			epir_memory_usage memoryUsage() {
+				epir_memory_usage usage;
+				epir_selector_factory_memory_usage(&this->ctx, &usage);
+				return usage;
+			}
 			Selector create(const IndexCounts &indexCounts, const uint64_t idx) {
 				Selector selector(indexCounts.ciphersCount());
 				epir_selector_factory_create_selector(selector.data(), &this->ctx, indexCounts.data(), indexCounts.size(), idx);
@@ -260,6 +732,58 @@ namespace EllipticPIR {
 			}
 	};
 	
+	/**
+	 * Manages the selector caches of many keys (see `epir_selector_factory_pool`).
+	 */
+	class SelectorFactoryPool {
+		private:
+			epir_selector_factory_pool pool;
+		public:
+			SelectorFactoryPool(const epir_selector_factory_pool_config &config) {
+				if(epir_selector_factory_pool_init(&this->pool, &config) != 0) throw "Failed to initialize the selector factory pool.";
+			}
+			~SelectorFactoryPool() {
+				epir_selector_factory_pool_destroy(&this->pool);
+			}
+			uint32_t addKey(const PrivateKey &privkey) {
+				const int64_t keyId = epir_selector_factory_pool_add_key_fast(&this->pool, privkey.data());
+				if(keyId < 0) throw "Failed to add the key.";
+				return keyId;
+			}
+			uint32_t addKey(const PublicKey &pubkey) {
+				const int64_t keyId = epir_selector_factory_pool_add_key(&this->pool, pubkey.data());
+				if(keyId < 0) throw "Failed to add the key.";
+				return keyId;
+			}
+			void removeKey(const uint32_t keyId) {
+				if(epir_selector_factory_pool_remove_key(&this->pool, keyId) != 0) throw "Failed to remove the key.";
+			}
+			uint32_t available(const uint32_t keyId) {
+				return epir_selector_factory_pool_available(&this->pool, keyId);
+			}
+			epir_selector_factory_stats getStats(const uint32_t keyId) {
+				epir_selector_factory_stats stats;
+				if(epir_selector_factory_pool_get_stats(&this->pool, keyId, &stats) != 0) throw "Invalid key ID.";
+				return stats;
+			}
+			epir_memory_usage memoryUsage() {
+				epir_memory_usage usage;
+				epir_selector_factory_pool_memory_usage(&this->pool, &usage);
+				return usage;
+			}
+			/**
+			 * Create a selector from the cache of the key, or throw if the cache does not have enough ciphers.
+			 */
+			Selector create(const uint32_t keyId, const IndexCounts &indexCounts, const uint64_t idx) {
+				Selector selector(indexCounts.ciphersCount());
+				if(epir_selector_factory_pool_create_selector(
+					selector.data(), &this->pool, keyId, indexCounts.data(), indexCounts.size(), idx) != 0) {
+					throw "Not enough ciphers in the cache.";
+				}
+				return selector;
+			}
+	};
+	
 }
 
 #endif
@@ -0,0 +1,220 @@
+/**
+ * Batch queries: many indexes retrieved with cuckoo-hashed buckets.
+ */
+
+#include "epir.h"
+#include "epir_memory.h"
+
+/**
+ * The maximum number of evictions while inserting an index to the cuckoo table.
+ */
+#define CUCKOO_MAX_KICKS (1000)
+
+static inline uint64_t mix64(uint64_t z) {
+	z += 0x9e3779b97f4a7c15ULL;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * Compute the candidate buckets of `idx`. Returns the number of distinct candidates.
+ */
+static size_t epir_batch_candidates_(const epir_batch_ctx *ctx, const uint64_t idx, uint32_t *buckets) {
+	size_t n = 0;
+	for(size_t h=0; h<EPIR_BATCH_HASHES; h++) {
+		const uint32_t bucket = mix64(ctx->seed ^ mix64(idx * EPIR_BATCH_HASHES + h)) % ctx->n_buckets;
+		bool dup = false;
+		for(size_t i=0; i<n; i++) dup = dup || (buckets[i] == bucket);
+		if(!dup) buckets[n++] = bucket;
+	}
+	return n;
+}
+
+int epir_batch_ctx_init(
+	epir_batch_ctx *ctx, const uint64_t n_elements, const uint32_t max_batch, const uint8_t n_indexes, const uint64_t seed) {
+	if(n_elements == 0 || max_batch == 0 || n_indexes == 0) return -1;
+	ctx->n_elements = n_elements;
+	// 1.5k buckets with 3 hash functions: the cuckoo insertion fails with a negligible probability.
+	ctx->n_buckets = max_batch + (max_batch + 1) / 2;
+	ctx->seed = seed;
+	ctx->n_indexes = n_indexes;
+	ctx->index_counts = epir_malloc_(sizeof(uint64_t) * n_indexes);
+	ctx->offsets = epir_calloc_(ctx->n_buckets + 1, sizeof(uint64_t));
+	if(ctx->index_counts == NULL || ctx->offsets == NULL) {
+		epir_free_(ctx->index_counts);
+		epir_free_(ctx->offsets);
+		return -1;
+	}
+	// Count the elements of each bucket, then place them (in ascending order of the indexes).
+	uint32_t buckets[EPIR_BATCH_HASHES];
+	for(uint64_t idx=0; idx<n_elements; idx++) {
+		const size_t n = epir_batch_candidates_(ctx, idx, buckets);
+		for(size_t h=0; h<n; h++) ctx->offsets[buckets[h] + 1]++;
+	}
+	uint64_t max_bucket_size = 0;
+	for(uint32_t b=0; b<ctx->n_buckets; b++) {
+		if(ctx->offsets[b + 1] > max_bucket_size) max_bucket_size = ctx->offsets[b + 1];
+		ctx->offsets[b + 1] += ctx->offsets[b];
+	}
+	ctx->elements = epir_malloc_(sizeof(uint64_t) * ctx->offsets[ctx->n_buckets]);
+	uint64_t *cursors = epir_malloc_(sizeof(uint64_t) * ctx->n_buckets);
+	if(ctx->elements == NULL || cursors == NULL) {
+		epir_free_(cursors);
+		epir_batch_ctx_destroy(ctx);
+		return -1;
+	}
+	memcpy(cursors, ctx->offsets, sizeof(uint64_t) * ctx->n_buckets);
+	for(uint64_t idx=0; idx<n_elements; idx++) {
+		const size_t n = epir_batch_candidates_(ctx, idx, buckets);
+		for(size_t h=0; h<n; h++) ctx->elements[cursors[buckets[h]]++] = idx;
+	}
+	epir_free_(cursors);
+	// Every bucket is padded to the largest one, thus shares the same `index_counts`.
+	uint64_t cols = 1;
+	for(;;) {
+		uint64_t prod = 1;
+		for(uint8_t i=0; i<n_indexes && prod<max_bucket_size; i++) prod *= cols;
+		if(prod >= max_bucket_size) break;
+		cols++;
+	}
+	for(uint8_t i=0; i<n_indexes; i++) ctx->index_counts[i] = cols;
+	return 0;
+}
+
+void epir_batch_ctx_destroy(epir_batch_ctx *ctx) {
+	epir_free_(ctx->index_counts);
+	epir_free_(ctx->offsets);
+	epir_free_(ctx->elements);
+}
+
+uint64_t epir_batch_ciphers_count(const epir_batch_ctx *ctx) {
+	return ctx->n_buckets * epir_selector_ciphers_count(ctx->index_counts, ctx->n_indexes);
+}
+
+int64_t epir_batch_position(const epir_batch_ctx *ctx, const uint32_t bucket, const uint64_t idx) {
+	if(bucket >= ctx->n_buckets) return -1;
+	uint64_t lo = ctx->offsets[bucket];
+	uint64_t hi = ctx->offsets[bucket + 1];
+	while(lo < hi) {
+		const uint64_t mid = lo + (hi - lo) / 2;
+		if(ctx->elements[mid] < idx) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if(lo == ctx->offsets[bucket + 1] || ctx->elements[lo] != idx) return -1;
+	return lo - ctx->offsets[bucket];
+}
+
+int epir_batch_assign(const epir_batch_ctx *ctx, uint32_t *buckets, const uint64_t *idxs, const size_t n_idxs) {
+	if(n_idxs > ctx->n_buckets) return -1;
+	int64_t *table = epir_malloc_(sizeof(int64_t) * ctx->n_buckets);
+	if(table == NULL) return -1;
+	for(uint32_t b=0; b<ctx->n_buckets; b++) table[b] = -1;
+	for(size_t i=0; i<n_idxs; i++) {
+		if(idxs[i] >= ctx->n_elements) {
+			epir_free_(table);
+			return -1;
+		}
+		// Insert by the random walk: evict one of the candidates (other than the one just evicted from).
+		size_t cur = i;
+		uint32_t prev = UINT32_MAX;
+		bool placed = false;
+		for(size_t kick=0; kick<CUCKOO_MAX_KICKS && !placed; kick++) {
+			uint32_t candidates[EPIR_BATCH_HASHES];
+			const size_t n = epir_batch_candidates_(ctx, idxs[cur], candidates);
+			for(size_t h=0; h<n && !placed; h++) {
+				if(table[candidates[h]] >= 0) continue;
+				table[candidates[h]] = cur;
+				buckets[cur] = candidates[h];
+				placed = true;
+			}
+			if(placed) break;
+			uint32_t victim = candidates[mix64(ctx->seed + i + kick) % n];
+			if(victim == prev && n > 1) victim = candidates[(mix64(ctx->seed + i + kick) + 1) % n];
+			const size_t evicted = table[victim];
+			table[victim] = cur;
+			buckets[cur] = victim;
+			prev = victim;
+			cur = evicted;
+		}
+		if(!placed) {
+			epir_free_(table);
+			return -1;
+		}
+	}
+	epir_free_(table);
+	return 0;
+}
+
+/**
+ * Create the selector of each bucket: the assigned index, or the first element of the bucket (dummy) if no index is assigned.
+ */
+static int epir_batch_selector_create_(
+	unsigned char *ciphers, const unsigned char *privkey, const epir_pubkey_ctx *pubkey_ctx,
+	const epir_batch_ctx *ctx, uint32_t *buckets, const uint64_t *idxs, const size_t n_idxs) {
+	if(epir_batch_assign(ctx, buckets, idxs, n_idxs) != 0) return -1;
+	uint64_t *positions = epir_calloc_(ctx->n_buckets, sizeof(uint64_t));
+	if(positions == NULL) return -1;
+	for(size_t i=0; i<n_idxs; i++) {
+		const int64_t position = epir_batch_position(ctx, buckets[i], idxs[i]);
+		if(position < 0) {
+			epir_free_(positions);
+			return -1;
+		}
+		positions[buckets[i]] = position;
+	}
+	const uint64_t bucket_ciphers = epir_selector_ciphers_count(ctx->index_counts, ctx->n_indexes);
+	for(uint32_t b=0; b<ctx->n_buckets; b++) {
+		unsigned char *bucket_selector = &ciphers[b * bucket_ciphers * EPIR_CIPHER_SIZE];
+		if(privkey) {
+			epir_selector_create_fast(bucket_selector, privkey, ctx->index_counts, ctx->n_indexes, positions[b], NULL);
+		} else {
+			epir_selector_create_ctx(bucket_selector, pubkey_ctx, ctx->index_counts, ctx->n_indexes, positions[b], NULL);
+		}
+	}
+	epir_free_(positions);
+	return 0;
+}
+
+int epir_batch_selector_create(
+	unsigned char *ciphers, const unsigned char *pubkey,
+	const epir_batch_ctx *ctx, uint32_t *buckets, const uint64_t *idxs, const size_t n_idxs) {
+	epir_pubkey_ctx *pubkey_ctx = epir_malloc_(sizeof(epir_pubkey_ctx));
+	if(pubkey_ctx == NULL) return -1;
+	int ret = -1;
+	if(epir_pubkey_ctx_init(pubkey_ctx, pubkey) == 0) {
+		ret = epir_batch_selector_create_(ciphers, NULL, pubkey_ctx, ctx, buckets, idxs, n_idxs);
+	}
+	epir_free_(pubkey_ctx);
+	return ret;
+}
+
+int epir_batch_selector_create_fast(
+	unsigned char *ciphers, const unsigned char *privkey,
+	const epir_batch_ctx *ctx, uint32_t *buckets, const uint64_t *idxs, const size_t n_idxs) {
+	return epir_batch_selector_create_(ciphers, privkey, NULL, ctx, buckets, idxs, n_idxs);
+}
+
+int epir_batch_reply_decrypt(
+	unsigned char *elems, const size_t elem_size, unsigned char *reply, const size_t reply_size,
+	const unsigned char *privkey, const uint8_t dimension, const uint8_t packing, const epir_mG_t *mG, const size_t mmax,
+	const epir_batch_ctx *ctx, const uint32_t *buckets, const size_t n_idxs) {
+	// The reply is the concatenation of the replies of the same size.
+	if(reply_size % ctx->n_buckets != 0) return -1;
+	const size_t bucket_reply_size = reply_size / ctx->n_buckets;
+	// The buckets are validated before any of them is decrypted (in place).
+	for(size_t i=0; i<n_idxs; i++) {
+		if(buckets[i] >= ctx->n_buckets) return -1;
+	}
+	// Only the buckets which hold the requested indexes are decrypted (the others are dummies).
+	for(size_t i=0; i<n_idxs; i++) {
+		unsigned char *bucket_reply = &reply[buckets[i] * bucket_reply_size];
+		const int decrypted = epir_reply_decrypt(bucket_reply, bucket_reply_size, privkey, dimension, packing, mG, mmax);
+		if(decrypted < (int)elem_size) return -1;
+		memcpy(&elems[i * elem_size], bucket_reply, elem_size);
+	}
+	return 0;
+}
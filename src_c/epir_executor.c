@@ -0,0 +1,268 @@
+/**
+ * Executors: parallel loops on a persistent work-stealing pool or on a user-supplied task submission callback.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#ifndef __EMSCRIPTEN__
+#include <omp.h>
+#endif
+
+#include "epir.h"
+#include "epir_memory.h"
+#include "epir_numa.h"
+
+epir_executor epir_executor_inline = { 0 };
+
+struct epir_executor_run_ {
+	void (*run)(void*);
+	void *run_data;
+	epir_executor_run_ *next;
+};
+
+/**
+ * The range of items of a participant of a loop. The items are claimed (by the owner or by thieves) with `next`.
+ */
+typedef struct {
+	size_t next __attribute__((aligned(64)));
+	size_t end;
+} epir_executor_range_;
+
+/**
+ * A parallel loop, shared (with reference counting) by the caller and the submitted runs.
+ */
+typedef struct {
+	epir_executor_task_fn task;
+	void *task_data;
+	size_t n;
+	uint32_t n_ranges;
+	uint32_t next_range;
+	size_t done;
+	uint32_t refs;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	epir_executor_range_ ranges[];
+} epir_executor_loop_;
+
+static void *epir_executor_worker(void *exec_) {
+	epir_executor *exec = exec_;
+	if(exec->n_nodes > 0) {
+		// Spread the workers over the nodes in the order of their start.
+		epir_numa_bind_thread_(__atomic_fetch_add(&exec->n_started, 1, __ATOMIC_RELAXED) % exec->n_nodes);
+	}
+	pthread_mutex_lock(&exec->mutex);
+	for(;;) {
+		// Run the pending runs before exiting: they hold the references to their loops.
+		while(exec->head == NULL && !exec->stopping) pthread_cond_wait(&exec->cond, &exec->mutex);
+		epir_executor_run_ *run = exec->head;
+		if(run == NULL) break;
+		exec->head = run->next;
+		if(exec->head == NULL) exec->tail = NULL;
+		pthread_mutex_unlock(&exec->mutex);
+		run->run(run->run_data);
+		epir_free_(run);
+		pthread_mutex_lock(&exec->mutex);
+	}
+	pthread_mutex_unlock(&exec->mutex);
+	return NULL;
+}
+
+static void epir_executor_pool_submit(void (*run_fn)(void*), void *run_data, void *exec_) {
+	epir_executor *exec = exec_;
+	epir_executor_run_ *run = epir_malloc_(sizeof(epir_executor_run_));
+	if(run == NULL) {
+		run_fn(run_data);
+		return;
+	}
+	run->run = run_fn;
+	run->run_data = run_data;
+	run->next = NULL;
+	pthread_mutex_lock(&exec->mutex);
+	if(exec->tail) {
+		exec->tail->next = run;
+	} else {
+		exec->head = run;
+	}
+	exec->tail = run;
+	pthread_cond_signal(&exec->cond);
+	pthread_mutex_unlock(&exec->mutex);
+}
+
+/**
+ * Initialize a pool, of which the workers are bound to `n_nodes` nodes (or not bound if zero).
+ */
+static int epir_executor_init_(epir_executor *exec, const uint32_t n_threads, const uint32_t n_nodes) {
+	uint32_t n = n_threads;
+	if(n == 0) {
+		const long n_procs = sysconf(_SC_NPROCESSORS_ONLN);
+		n = (n_procs > 2 ? n_procs - 1 : 1);
+	}
+	exec->n_threads = 0;
+	exec->submit = epir_executor_pool_submit;
+	exec->submit_data = exec;
+	exec->head = exec->tail = NULL;
+	exec->stopping = false;
+	exec->n_nodes = n_nodes;
+	exec->n_started = 0;
+	exec->workers = epir_malloc_(sizeof(pthread_t) * (n > 0 ? n : 1));
+	if(exec->workers == NULL) return -1;
+	int ret;
+	if((ret = pthread_mutex_init(&exec->mutex, NULL)) != 0) {
+		epir_free_(exec->workers);
+		return ret;
+	}
+	if((ret = pthread_cond_init(&exec->cond, NULL)) != 0) {
+		pthread_mutex_destroy(&exec->mutex);
+		epir_free_(exec->workers);
+		return ret;
+	}
+	for(; exec->n_threads<n; exec->n_threads++) {
+		if((ret = pthread_create(&exec->workers[exec->n_threads], NULL, epir_executor_worker, exec)) != 0) {
+			epir_executor_destroy(exec);
+			return ret;
+		}
+	}
+	return 0;
+}
+
+int epir_executor_init(epir_executor *exec, const uint32_t n_threads) {
+	return epir_executor_init_(exec, n_threads, 0);
+}
+
+int epir_executor_init_numa(epir_executor *exec, const uint32_t n_threads, const uint32_t n_nodes) {
+	return epir_executor_init_(exec, n_threads, n_nodes == 0 ? epir_numa_nodes() : n_nodes);
+}
+
+int epir_executor_init_submit(epir_executor *exec, epir_executor_submit_fn submit, void *submit_data, const uint32_t n_threads) {
+	exec->n_threads = n_threads;
+	exec->submit = submit;
+	exec->submit_data = submit_data;
+	exec->workers = NULL;
+	exec->head = exec->tail = NULL;
+	exec->stopping = false;
+	exec->n_nodes = 0;
+	exec->n_started = 0;
+	int ret;
+	if((ret = pthread_mutex_init(&exec->mutex, NULL)) != 0) return ret;
+	if((ret = pthread_cond_init(&exec->cond, NULL)) != 0) {
+		pthread_mutex_destroy(&exec->mutex);
+		return ret;
+	}
+	return 0;
+}
+
+int epir_executor_destroy(epir_executor *exec) {
+	int ret;
+	if(exec->workers) {
+		pthread_mutex_lock(&exec->mutex);
+		exec->stopping = true;
+		pthread_cond_broadcast(&exec->cond);
+		pthread_mutex_unlock(&exec->mutex);
+		for(uint32_t t=0; t<exec->n_threads; t++) {
+			if((ret = pthread_join(exec->workers[t], NULL)) != 0) return ret;
+		}
+		epir_free_(exec->workers);
+		exec->workers = NULL;
+	}
+	exec->n_threads = 0;
+	if((ret = pthread_cond_destroy(&exec->cond)) != 0) return ret;
+	if((ret = pthread_mutex_destroy(&exec->mutex)) != 0) return ret;
+	return 0;
+}
+
+static epir_executor default_executor;
+static epir_executor *default_executor_ptr = NULL;
+static pthread_once_t default_executor_once = PTHREAD_ONCE_INIT;
+
+static void epir_executor_default_init() {
+	if(epir_executor_init(&default_executor, 0) == 0) default_executor_ptr = &default_executor;
+}
+
+epir_executor *epir_executor_default() {
+	pthread_once(&default_executor_once, epir_executor_default_init);
+	return default_executor_ptr;
+}
+
+uint32_t epir_executor_concurrency(const epir_executor *exec) {
+	if(exec) return exec->n_threads + 1;
+#ifdef __EMSCRIPTEN__
+	return 1;
+#else
+	return omp_get_max_threads();
+#endif
+}
+
+static void epir_executor_loop_release_(epir_executor_loop_ *loop) {
+	if(__atomic_sub_fetch(&loop->refs, 1, __ATOMIC_ACQ_REL) > 0) return;
+	pthread_cond_destroy(&loop->cond);
+	pthread_mutex_destroy(&loop->mutex);
+	free(loop);
+}
+
+/**
+ * Run the items of the own range, then steal the items of the other ranges in order.
+ */
+static void epir_executor_loop_participate_(epir_executor_loop_ *loop) {
+	const uint32_t self = __atomic_fetch_add(&loop->next_range, 1, __ATOMIC_RELAXED) % loop->n_ranges;
+	size_t done = 0;
+	for(uint32_t r=0; r<loop->n_ranges; r++) {
+		epir_executor_range_ *range = &loop->ranges[(self + r) % loop->n_ranges];
+		for(;;) {
+			const size_t i = __atomic_fetch_add(&range->next, 1, __ATOMIC_RELAXED);
+			if(i >= range->end) break;
+			loop->task(loop->task_data, i);
+			done++;
+		}
+	}
+	if(done > 0 && __atomic_add_fetch(&loop->done, done, __ATOMIC_ACQ_REL) == loop->n) {
+		pthread_mutex_lock(&loop->mutex);
+		pthread_cond_broadcast(&loop->cond);
+		pthread_mutex_unlock(&loop->mutex);
+	}
+}
+
+static void epir_executor_loop_run_(void *loop_) {
+	epir_executor_loop_ *loop = loop_;
+	epir_executor_loop_participate_(loop);
+	epir_executor_loop_release_(loop);
+}
+
+void epir_executor_parallel_for(epir_executor *exec, const size_t n, epir_executor_task_fn task, void *task_data) {
+	if(exec == NULL) {
+		#pragma omp parallel for schedule(dynamic)
+		for(size_t i=0; i<n; i++) task(task_data, i);
+		return;
+	}
+	const uint32_t n_runs = (n - 1 < exec->n_threads ? n - 1 : exec->n_threads);
+	// The loop is short-lived and cache-line aligned, thus allocated with posix_memalign() (and not accounted).
+	void *loop_ = NULL;
+	if(n > 1 && n_runs > 0 &&
+		posix_memalign(&loop_, 64, sizeof(epir_executor_loop_) + sizeof(epir_executor_range_) * (n_runs + 1)) != 0) {
+		loop_ = NULL;
+	}
+	epir_executor_loop_ *loop = loop_;
+	if(loop == NULL || pthread_mutex_init(&loop->mutex, NULL) != 0) {
+		free(loop);
+		for(size_t i=0; i<n; i++) task(task_data, i);
+		return;
+	}
+	pthread_cond_init(&loop->cond, NULL);
+	loop->task = task;
+	loop->task_data = task_data;
+	loop->n = n;
+	loop->n_ranges = n_runs + 1;
+	loop->next_range = 0;
+	loop->done = 0;
+	loop->refs = n_runs + 1;
+	for(uint32_t r=0; r<loop->n_ranges; r++) {
+		loop->ranges[r].next = n * r / loop->n_ranges;
+		loop->ranges[r].end = n * (r + 1) / loop->n_ranges;
+	}
+	for(uint32_t r=0; r<n_runs; r++) exec->submit(epir_executor_loop_run_, loop, exec->submit_data);
+	epir_executor_loop_participate_(loop);
+	// Wait for the items claimed by the others (the runs which have not started will find nothing to do).
+	pthread_mutex_lock(&loop->mutex);
+	while(__atomic_load_n(&loop->done, __ATOMIC_ACQUIRE) < n) pthread_cond_wait(&loop->cond, &loop->mutex);
+	pthread_mutex_unlock(&loop->mutex);
+	epir_executor_loop_release_(loop);
+}
@@ -58,16 +58,15 @@ int main(int argc, char *argv[]) {
 	auto cb = [](const size_t pointsComputed, void *cb_data_) {
 		cb_data_t *cb_data = (cb_data_t*)cb_data_;
 		const uint32_t mmax = cb_data->mmax;
-		if(pointsComputed == mmax || pointsComputed % (1'000'000) == 0) {
-			printf("\x1b[32m%8zd of %d points computed (%6.02f%%).\x1b[39m\n", pointsComputed, mmax, (100.0 * pointsComputed / mmax));
-		}
+		printf("\x1b[32m%8zd of %d points computed (%6.02f%%).\x1b[39m\n", pointsComputed, mmax, (100.0 * pointsComputed / mmax));
 		if(pointsComputed == mmax) {
 			printf("\x1b[32mComputation done in %.0fms.\x1b[39m\n", (microtime() - cb_data->beginCompute) / 1000.);
 			cb_data->beginSort = microtime();
 		}
 	};
 	cb_data_t cb_data = { mmax, microtime(), 0.0 };
-	DecryptionContext decCtx = DecryptionContext::generate(cb, &cb_data, mmax);
+	const epir_progress_cadence cadence = { 1'000'000, 0 };
+	DecryptionContext decCtx = DecryptionContext::generate(cb, &cb_data, mmax, &cadence);
 	printf("\x1b[32mPoints sorted in %.0fms.\x1b[39m\n", (microtime() - cb_data.beginSort) / 1000.);
 	
 	// Output to a binary file.
@@ -0,0 +1,218 @@
+/**
+ * Asynchronous jobs: the blocking functions run on an executor, completed through polling, a callback or a file descriptor.
+ */
+
+#include <unistd.h>
+
+#include "epir.h"
+
+/**
+ * A callback running on this thread. Its job is not done until the callback returns,
+ * thus the callback waits for and destroys its own job without blocking.
+ */
+typedef struct epir_job_delivery_ {
+	epir_job *job;
+	bool destroyed;
+	struct epir_job_delivery_ *prev;
+} epir_job_delivery_;
+
+/**
+ * The callbacks running on this thread (the innermost first; an inline executor nests them).
+ */
+static __thread epir_job_delivery_ *epir_job_deliveries_ = NULL;
+
+static epir_job_delivery_ *epir_job_delivery_find_(const epir_job *job) {
+	for(epir_job_delivery_ *delivery=epir_job_deliveries_; delivery; delivery=delivery->prev) {
+		if(delivery->job == job) return delivery;
+	}
+	return NULL;
+}
+
+int epir_job_init(epir_job *job, epir_executor *exec, epir_job_callback_fn cb, void *cb_data, const int fd) {
+	job->exec = exec ? exec : epir_executor_default();
+	if(job->exec == NULL) return -1;
+	job->cb = cb;
+	job->cb_data = cb_data;
+	job->fd = fd;
+	job->result = 0;
+	// Nothing is pending until submitted.
+	job->done = true;
+	job->cancelled = false;
+	job->run = NULL;
+	int ret;
+	if((ret = pthread_mutex_init(&job->mutex, NULL)) != 0) return ret;
+	if((ret = pthread_cond_init(&job->cond, NULL)) != 0) {
+		pthread_mutex_destroy(&job->mutex);
+		return ret;
+	}
+	return 0;
+}
+
+int epir_job_destroy(epir_job *job) {
+	epir_job_delivery_ *delivery = epir_job_delivery_find_(job);
+	if(delivery) {
+		delivery->destroyed = true;
+	} else {
+		epir_job_wait(job);
+	}
+	int ret;
+	if((ret = pthread_cond_destroy(&job->cond)) != 0) return ret;
+	if((ret = pthread_mutex_destroy(&job->mutex)) != 0) return ret;
+	return 0;
+}
+
+bool epir_job_poll(epir_job *job) {
+	return __atomic_load_n(&job->done, __ATOMIC_ACQUIRE);
+}
+
+void epir_job_cancel(epir_job *job) {
+	__atomic_store_n(&job->cancelled, true, __ATOMIC_RELEASE);
+}
+
+int epir_job_wait(epir_job *job) {
+	if(epir_job_delivery_find_(job)) return job->result;
+	pthread_mutex_lock(&job->mutex);
+	while(!job->done) pthread_cond_wait(&job->cond, &job->mutex);
+	pthread_mutex_unlock(&job->mutex);
+	return job->result;
+}
+
+/**
+ * Run the job, then write the file descriptor and call the callback, then mark the job done.
+ * Thus the descriptor and the data of the callback are not used after the job is waited for.
+ * The job is not touched after it is marked done (the owner may destroy it), nor after the callback destroys it.
+ */
+static void epir_job_run_(void *job_) {
+	epir_job *job = job_;
+	if(__atomic_exchange_n(&job->cancelled, false, __ATOMIC_ACQ_REL)) {
+		job->result = EPIR_JOB_CANCELLED;
+	} else {
+		job->run(job);
+	}
+	if(job->fd >= 0) {
+		const uint64_t one = 1;
+		if(write(job->fd, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+			// The counter of an eventfd is full: the completion is still visible by polling.
+		}
+	}
+	if(job->cb) {
+		epir_job_delivery_ delivery = { .job = job, .destroyed = false, .prev = epir_job_deliveries_ };
+		epir_job_deliveries_ = &delivery;
+		job->cb(job, job->result, job->cb_data);
+		epir_job_deliveries_ = delivery.prev;
+		if(delivery.destroyed) return;
+	}
+	pthread_mutex_lock(&job->mutex);
+	__atomic_store_n(&job->done, true, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&job->cond);
+	pthread_mutex_unlock(&job->mutex);
+}
+
+static int epir_job_submit_(epir_job *job, void (*run)(epir_job*)) {
+	if(!epir_job_poll(job)) return -1;
+	job->run = run;
+	job->result = 0;
+	// A cancellation of the previous submission (or of the idle job) does not cancel this one.
+	__atomic_store_n(&job->cancelled, false, __ATOMIC_RELAXED);
+	__atomic_store_n(&job->done, false, __ATOMIC_RELAXED);
+	epir_executor *exec = job->exec;
+	if(exec->submit == NULL) {
+		epir_job_run_(job);
+	} else {
+		exec->submit(epir_job_run_, job, exec->submit_data);
+	}
+	return 0;
+}
+
+static void epir_selector_create_run_(epir_job *job) {
+	epir_selector_create_ex(
+		job->args.selector_create.ciphers, job->args.selector_create.key,
+		job->args.selector_create.index_counts, job->args.selector_create.n_indexes,
+		job->args.selector_create.idx, job->args.selector_create.r, job->exec);
+}
+
+static void epir_selector_create_fast_run_(epir_job *job) {
+	epir_selector_create_fast_ex(
+		job->args.selector_create.ciphers, job->args.selector_create.key,
+		job->args.selector_create.index_counts, job->args.selector_create.n_indexes,
+		job->args.selector_create.idx, job->args.selector_create.r, job->exec);
+}
+
+static void epir_selector_create_ctx_run_(epir_job *job) {
+	epir_selector_create_ctx_ex(
+		job->args.selector_create.ciphers, job->args.selector_create.ctx,
+		job->args.selector_create.index_counts, job->args.selector_create.n_indexes,
+		job->args.selector_create.idx, job->args.selector_create.r, job->exec);
+}
+
+static int epir_selector_create_submit_(
+	epir_job *job, void (*run)(epir_job*), unsigned char *ciphers, const unsigned char *key, const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes, const uint64_t idx, const unsigned char *r) {
+	if(!epir_job_poll(job)) return -1;
+	job->args.selector_create.ciphers = ciphers;
+	job->args.selector_create.key = key;
+	job->args.selector_create.ctx = ctx;
+	job->args.selector_create.index_counts = index_counts;
+	job->args.selector_create.n_indexes = n_indexes;
+	job->args.selector_create.idx = idx;
+	job->args.selector_create.r = r;
+	return epir_job_submit_(job, run);
+}
+
+int epir_selector_create_submit(
+	epir_job *job, unsigned char *ciphers, const unsigned char *pubkey,
+	const uint64_t *index_counts, const uint8_t n_indexes, const uint64_t idx, const unsigned char *r) {
+	return epir_selector_create_submit_(
+		job, epir_selector_create_run_, ciphers, pubkey, NULL, index_counts, n_indexes, idx, r);
+}
+
+int epir_selector_create_fast_submit(
+	epir_job *job, unsigned char *ciphers, const unsigned char *privkey,
+	const uint64_t *index_counts, const uint8_t n_indexes, const uint64_t idx, const unsigned char *r) {
+	return epir_selector_create_submit_(
+		job, epir_selector_create_fast_run_, ciphers, privkey, NULL, index_counts, n_indexes, idx, r);
+}
+
+int epir_selector_create_ctx_submit(
+	epir_job *job, unsigned char *ciphers, const epir_pubkey_ctx *ctx,
+	const uint64_t *index_counts, const uint8_t n_indexes, const uint64_t idx, const unsigned char *r) {
+	return epir_selector_create_submit_(
+		job, epir_selector_create_ctx_run_, ciphers, NULL, ctx, index_counts, n_indexes, idx, r);
+}
+
+static void epir_reply_decrypt_run_(epir_job *job) {
+	job->result = epir_reply_decrypt_ex(
+		job->args.reply_decrypt.reply, job->args.reply_decrypt.reply_size, job->args.reply_decrypt.privkey,
+		job->args.reply_decrypt.dimension, job->args.reply_decrypt.packing,
+		job->args.reply_decrypt.mG, job->args.reply_decrypt.mmax, job->exec);
+}
+
+int epir_reply_decrypt_submit(
+	epir_job *job, unsigned char *reply, const size_t reply_size, const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing, const epir_mG_t *mG, const size_t mmax) {
+	if(!epir_job_poll(job)) return -1;
+	job->args.reply_decrypt.reply = reply;
+	job->args.reply_decrypt.reply_size = reply_size;
+	job->args.reply_decrypt.privkey = privkey;
+	job->args.reply_decrypt.dimension = dimension;
+	job->args.reply_decrypt.packing = packing;
+	job->args.reply_decrypt.mG = mG;
+	job->args.reply_decrypt.mmax = mmax;
+	return epir_job_submit_(job, epir_reply_decrypt_run_);
+}
+
+static void epir_mG_generate_run_(epir_job *job) {
+	epir_mG_generate_ex(
+		job->args.mG_generate.mG, job->args.mG_generate.mmax,
+		job->args.mG_generate.cb, job->args.mG_generate.cb_data, job->exec);
+}
+
+int epir_mG_generate_submit(
+	epir_job *job, epir_mG_t *mG, const size_t mmax, void (*cb)(const size_t, void*), void *cb_data) {
+	if(!epir_job_poll(job)) return -1;
+	job->args.mG_generate.mG = mG;
+	job->args.mG_generate.mmax = mmax;
+	job->args.mG_generate.cb = cb;
+	job->args.mG_generate.cb_data = cb_data;
+	return epir_job_submit_(job, epir_mG_generate_run_);
+}
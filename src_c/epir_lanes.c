@@ -0,0 +1,41 @@
+/**
+ * Runtime selection of the multi-lane Ed25519 point arithmetic backend.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "epir.h"
+#include "epir_lanes.h"
+
+static const epir_lanes_backend *lanes_backend = NULL;
+static pthread_once_t lanes_once = PTHREAD_ONCE_INIT;
+static bool lanes_enabled = true;
+
+static void epir_lanes_select() {
+#if defined(EPIR_LANES_X86)
+	if(getenv("EPIR_DISABLE_SIMD") != NULL) return;
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f")) {
+		lanes_backend = &epir_lanes_backend_avx512;
+	} else if(__builtin_cpu_supports("avx2")) {
+		lanes_backend = &epir_lanes_backend_avx2;
+	}
+	if(lanes_backend) lanes_backend->init();
+#endif
+}
+
+const epir_lanes_backend *epir_lanes_get() {
+	pthread_once(&lanes_once, epir_lanes_select);
+	return lanes_enabled ? lanes_backend : NULL;
+}
+
+size_t epir_simd_lanes() {
+	const epir_lanes_backend *lanes = epir_lanes_get();
+	return lanes ? lanes->lanes : 1;
+}
+
+void epir_simd_enable(const bool enable) {
+	lanes_enabled = enable;
+}
@@ -0,0 +1,51 @@
+/**
+ * Multi-lane Ed25519 point arithmetic backends (internal header).
+ */
+
+#ifndef EPIR_LANES_H
+#define EPIR_LANES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * The maximum number of lanes of all the backends.
+ */
+#define EPIR_LANES_MAX (8)
+
+/**
+ * A vectorized backend which computes `lanes` independent point operations at once.
+ * All the scalars passed to the backend should satisfy `scalar[31] <= 127`.
+ */
+typedef struct {
+	/** The number of points processed in a single call. */
+	size_t lanes;
+	/** Initialize the backend (called once per process). */
+	void (*init)(void);
+	/** points[i * stride] = scalars[i] * G. */
+	void (*scalarmult_base)(unsigned char *points, const size_t stride, const unsigned char *scalars);
+	/** points[i * stride] = a[i] * point + b[i] * G. */
+	void (*scalarmult_base_add)(
+		unsigned char *points, const size_t stride, const unsigned char *a, const unsigned char *point, const unsigned char *b);
+	/** Same as `epir_ecelgamal_decrypt_to_mG()` applied to `lanes` consecutive ciphertexts. */
+	void (*decrypt_to_mG)(const unsigned char *privkey, unsigned char *ciphers);
+} epir_lanes_backend;
+
+#if defined(EPIR_LANES_X86)
+extern const epir_lanes_backend epir_lanes_backend_avx2;
+extern const epir_lanes_backend epir_lanes_backend_avx512;
+#endif
+
+/**
+ * Returns the backend selected for the running CPU, or NULL if the scalar code should be used.
+ */
+const epir_lanes_backend *epir_lanes_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
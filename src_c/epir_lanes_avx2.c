@@ -0,0 +1,11 @@
+/**
+ * Multi-lane Ed25519 point arithmetic (AVX2, 4 lanes).
+ */
+
+#include <immintrin.h>
+
+#define EPIR_LANES (4)
+#define EPIR_LANES_MUL32(a, b) _mm256_mul_epi32((__m256i)(a), (__m256i)(b))
+#define EPIR_LANES_BACKEND epir_lanes_backend_avx2
+
+#include "epir_lanes_impl.h"
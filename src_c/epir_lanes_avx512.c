@@ -0,0 +1,11 @@
+/**
+ * Multi-lane Ed25519 point arithmetic (AVX-512, 8 lanes).
+ */
+
+#include <immintrin.h>
+
+#define EPIR_LANES (8)
+#define EPIR_LANES_MUL32(a, b) _mm512_mul_epi32((__m512i)(a), (__m512i)(b))
+#define EPIR_LANES_BACKEND epir_lanes_backend_avx512
+
+#include "epir_lanes_impl.h"
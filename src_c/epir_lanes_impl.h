@@ -0,0 +1,635 @@
+/**
+ * Multi-lane Ed25519 point arithmetic (kernel template).
+ *
+ * This file is included by `epir_lanes_*.c` after defining `EPIR_LANES` (the number of lanes)
+ * and `EPIR_LANES_BACKEND` (the name of the exported `epir_lanes_backend` instance).
+ * Each translation unit is compiled with its own target flags (e.g. `-mavx2`), so the lane loops below
+ * are vectorized by the compiler for the target instruction set.
+ *
+ * Field elements are kept in the radix 2^25.5 representation of ref10, with the lanes as the innermost dimension
+ * (structure of arrays). All the operations are constant-time with respect to the lane contents.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "epir_lanes.h"
+#include "epir_profile.h"
+
+#define L (EPIR_LANES)
+#define FOR_LANES(l) for(size_t l=0; l<L; l++)
+
+/* A vector of L signed 64-bit lanes. Field limbs are kept in the low (sign-extended) 32 bits of each lane. */
+typedef int64_t vec __attribute__((vector_size(8 * L)));
+typedef uint64_t uvec __attribute__((vector_size(8 * L)));
+
+/* Signed 32x32->64-bit multiplication of the low halves (EPIR_LANES_MUL32 is defined by the backend). */
+#define MUL(a, b) ((vec)EPIR_LANES_MUL32(a, b))
+
+/* Arithmetic right shift for |x| < 2^62, built from a logical shift (AVX2 has no 64-bit arithmetic shift). */
+#define SRA(x, n) ((vec)(((uvec)((x) + ((int64_t)1 << 62))) >> (n)) - ((int64_t)1 << (62 - (n))))
+
+typedef struct {
+	vec v[10];
+} fe;
+
+typedef struct {
+	fe X, Y, Z, T;
+} ge_p3;
+
+typedef struct {
+	fe YplusX, YminusX, Z2, T2d;
+} ge_cached;
+
+/* A single (non-lane) point in the cached form. Used for the base point table. */
+typedef struct {
+	int32_t YplusX[10], YminusX[10], Z2[10], T2d[10];
+} ge_cached_1;
+
+static const int32_t fe_d[10] = {
+	56195235, 13857412, 51736253, 6949390, 114729, 24766616, 60832955, 30306712, 48412415, 21499315
+};
+static const int32_t fe_d2[10] = {
+	45281625, 27714825, 36363642, 13898781, 229458, 15978800, 54557047, 27058993, 29715967, 9444199
+};
+static const int32_t fe_sqrtm1[10] = {
+	34513072, 25610706, 9377949, 3500415, 12389472, 33281959, 41962654, 31548777, 326685, 11406482
+};
+/* The Ed25519 base point (x, y) with y = 4/5. */
+static const unsigned char ge_base_bytes[32] = {
+	0x58, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+	0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66
+};
+
+static inline void fe_set(fe *h, const int32_t *c) {
+	for(size_t i=0; i<10; i++) h->v[i] = (vec){} + c[i];
+}
+
+static inline void fe_0(fe *h) {
+	for(size_t i=0; i<10; i++) h->v[i] = (vec){};
+}
+
+static inline void fe_1(fe *h) {
+	fe_0(h);
+	h->v[0] += 1;
+}
+
+/* Carry the 64-bit limbs `h` (|h[i]| < 2^62) and store them to `out`. */
+static inline void fe_carry(fe *out, vec h[10]) {
+	#define CARRY(i, bits) { \
+		const vec c = SRA(h[i] + ((int64_t)1 << ((bits) - 1)), bits); \
+		h[(i) + 1] += c; \
+		h[i] -= c << (bits); \
+	}
+	CARRY(0, 26); CARRY(4, 26);
+	CARRY(1, 25); CARRY(5, 25);
+	CARRY(2, 26); CARRY(6, 26);
+	CARRY(3, 25); CARRY(7, 25);
+	CARRY(4, 26); CARRY(8, 26);
+	{
+		const vec c = SRA(h[9] + ((int64_t)1 << 24), 25);
+		h[0] += c * 19;
+		h[9] -= c << 25;
+	}
+	CARRY(0, 26);
+	#undef CARRY
+	for(size_t i=0; i<10; i++) out->v[i] = h[i];
+}
+
+static inline void fe_add(fe *h, const fe *f, const fe *g) {
+	vec t[10];
+	for(size_t i=0; i<10; i++) t[i] = f->v[i] + g->v[i];
+	fe_carry(h, t);
+}
+
+static inline void fe_sub(fe *h, const fe *f, const fe *g) {
+	vec t[10];
+	for(size_t i=0; i<10; i++) t[i] = f->v[i] - g->v[i];
+	fe_carry(h, t);
+}
+
+static inline void fe_neg(fe *h, const fe *f) {
+	for(size_t i=0; i<10; i++) h->v[i] = -f->v[i];
+}
+
+static inline void fe_mul(fe *h, const fe *f, const fe *g) {
+	const vec f0 = f->v[0], f1 = f->v[1], f2 = f->v[2], f3 = f->v[3], f4 = f->v[4];
+	const vec f5 = f->v[5], f6 = f->v[6], f7 = f->v[7], f8 = f->v[8], f9 = f->v[9];
+	const vec g0 = g->v[0], g1 = g->v[1], g2 = g->v[2], g3 = g->v[3], g4 = g->v[4];
+	const vec g5 = g->v[5], g6 = g->v[6], g7 = g->v[7], g8 = g->v[8], g9 = g->v[9];
+	const vec g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3, g4_19 = 19 * g4, g5_19 = 19 * g5;
+	const vec g6_19 = 19 * g6, g7_19 = 19 * g7, g8_19 = 19 * g8, g9_19 = 19 * g9;
+	const vec f1_2 = 2 * f1, f3_2 = 2 * f3, f5_2 = 2 * f5, f7_2 = 2 * f7, f9_2 = 2 * f9;
+	vec t[10];
+	t[0] = MUL(f0, g0) + MUL(f1_2, g9_19) + MUL(f2, g8_19) + MUL(f3_2, g7_19) + MUL(f4, g6_19)
+		+ MUL(f5_2, g5_19) + MUL(f6, g4_19) + MUL(f7_2, g3_19) + MUL(f8, g2_19) + MUL(f9_2, g1_19);
+	t[1] = MUL(f0, g1) + MUL(f1, g0) + MUL(f2, g9_19) + MUL(f3, g8_19) + MUL(f4, g7_19)
+		+ MUL(f5, g6_19) + MUL(f6, g5_19) + MUL(f7, g4_19) + MUL(f8, g3_19) + MUL(f9, g2_19);
+	t[2] = MUL(f0, g2) + MUL(f1_2, g1) + MUL(f2, g0) + MUL(f3_2, g9_19) + MUL(f4, g8_19)
+		+ MUL(f5_2, g7_19) + MUL(f6, g6_19) + MUL(f7_2, g5_19) + MUL(f8, g4_19) + MUL(f9_2, g3_19);
+	t[3] = MUL(f0, g3) + MUL(f1, g2) + MUL(f2, g1) + MUL(f3, g0) + MUL(f4, g9_19)
+		+ MUL(f5, g8_19) + MUL(f6, g7_19) + MUL(f7, g6_19) + MUL(f8, g5_19) + MUL(f9, g4_19);
+	t[4] = MUL(f0, g4) + MUL(f1_2, g3) + MUL(f2, g2) + MUL(f3_2, g1) + MUL(f4, g0)
+		+ MUL(f5_2, g9_19) + MUL(f6, g8_19) + MUL(f7_2, g7_19) + MUL(f8, g6_19) + MUL(f9_2, g5_19);
+	t[5] = MUL(f0, g5) + MUL(f1, g4) + MUL(f2, g3) + MUL(f3, g2) + MUL(f4, g1)
+		+ MUL(f5, g0) + MUL(f6, g9_19) + MUL(f7, g8_19) + MUL(f8, g7_19) + MUL(f9, g6_19);
+	t[6] = MUL(f0, g6) + MUL(f1_2, g5) + MUL(f2, g4) + MUL(f3_2, g3) + MUL(f4, g2)
+		+ MUL(f5_2, g1) + MUL(f6, g0) + MUL(f7_2, g9_19) + MUL(f8, g8_19) + MUL(f9_2, g7_19);
+	t[7] = MUL(f0, g7) + MUL(f1, g6) + MUL(f2, g5) + MUL(f3, g4) + MUL(f4, g3)
+		+ MUL(f5, g2) + MUL(f6, g1) + MUL(f7, g0) + MUL(f8, g9_19) + MUL(f9, g8_19);
+	t[8] = MUL(f0, g8) + MUL(f1_2, g7) + MUL(f2, g6) + MUL(f3_2, g5) + MUL(f4, g4)
+		+ MUL(f5_2, g3) + MUL(f6, g2) + MUL(f7_2, g1) + MUL(f8, g0) + MUL(f9_2, g9_19);
+	t[9] = MUL(f0, g9) + MUL(f1, g8) + MUL(f2, g7) + MUL(f3, g6) + MUL(f4, g5)
+		+ MUL(f5, g4) + MUL(f6, g3) + MUL(f7, g2) + MUL(f8, g1) + MUL(f9, g0);
+	fe_carry(h, t);
+}
+
+static inline void fe_sq(fe *h, const fe *f) {
+	const vec f0 = f->v[0], f1 = f->v[1], f2 = f->v[2], f3 = f->v[3], f4 = f->v[4];
+	const vec f5 = f->v[5], f6 = f->v[6], f7 = f->v[7], f8 = f->v[8], f9 = f->v[9];
+	const vec f0_2 = 2 * f0, f1_2 = 2 * f1, f2_2 = 2 * f2, f3_2 = 2 * f3;
+	const vec f4_2 = 2 * f4, f5_2 = 2 * f5, f6_2 = 2 * f6, f7_2 = 2 * f7;
+	const vec f5_38 = 38 * f5, f6_19 = 19 * f6, f7_38 = 38 * f7, f8_19 = 19 * f8, f9_38 = 38 * f9;
+	vec t[10];
+	t[0] = MUL(f0, f0) + MUL(f1_2, f9_38) + MUL(f2_2, f8_19) + MUL(f3_2, f7_38) + MUL(f4_2, f6_19) + MUL(f5, f5_38);
+	t[1] = MUL(f0_2, f1) + MUL(f2, f9_38) + MUL(f3_2, f8_19) + MUL(f4, f7_38) + MUL(f5_2, f6_19);
+	t[2] = MUL(f0_2, f2) + MUL(f1_2, f1) + MUL(f3_2, f9_38) + MUL(f4_2, f8_19) + MUL(f5_2, f7_38) + MUL(f6, f6_19);
+	t[3] = MUL(f0_2, f3) + MUL(f1_2, f2) + MUL(f4, f9_38) + MUL(f5_2, f8_19) + MUL(f6, f7_38);
+	t[4] = MUL(f0_2, f4) + MUL(f1_2, f3_2) + MUL(f2, f2) + MUL(f5_2, f9_38) + MUL(f6_2, f8_19) + MUL(f7, f7_38);
+	t[5] = MUL(f0_2, f5) + MUL(f1_2, f4) + MUL(f2_2, f3) + MUL(f6, f9_38) + MUL(f7_2, f8_19);
+	t[6] = MUL(f0_2, f6) + MUL(f1_2, f5_2) + MUL(f2_2, f4) + MUL(f3_2, f3) + MUL(f7_2, f9_38) + MUL(f8, f8_19);
+	t[7] = MUL(f0_2, f7) + MUL(f1_2, f6) + MUL(f2_2, f5) + MUL(f3_2, f4) + MUL(f8, f9_38);
+	t[8] = MUL(f0_2, f8) + MUL(f1_2, f7_2) + MUL(f2_2, f6) + MUL(f3_2, f5_2) + MUL(f4, f4) + MUL(f9, f9_38);
+	t[9] = MUL(f0_2, f9) + MUL(f1_2, f8) + MUL(f2_2, f7) + MUL(f3_2, f6) + MUL(f4_2, f5);
+	fe_carry(h, t);
+}
+
+static inline void fe_sqn(fe *h, const fe *f, const size_t n) {
+	fe_sq(h, f);
+	for(size_t i=1; i<n; i++) fe_sq(h, h);
+}
+
+static inline void fe_mul_c(fe *h, const fe *f, const int32_t *c) {
+	fe g;
+	fe_set(&g, c);
+	fe_mul(h, f, &g);
+}
+
+/* Conditionally set `f = g` for lanes where `mask[l] == -1`. */
+static inline void fe_cmov(fe *f, const fe *g, const vec mask) {
+	for(size_t i=0; i<10; i++) f->v[i] ^= (f->v[i] ^ g->v[i]) & mask;
+}
+
+static inline uint32_t load_3(const unsigned char *in) {
+	return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16);
+}
+
+static inline uint32_t load_4(const unsigned char *in) {
+	return load_3(in) | ((uint32_t)in[3] << 24);
+}
+
+static inline void fe_frombytes(fe *h, const unsigned char *s, const size_t stride) {
+	vec t[10];
+	FOR_LANES(l) {
+		const unsigned char *sl = s + l * stride;
+		t[0][l] = load_4(sl);
+		t[1][l] = load_3(sl +  4) << 6;
+		t[2][l] = load_3(sl +  7) << 5;
+		t[3][l] = load_3(sl + 10) << 3;
+		t[4][l] = load_3(sl + 13) << 2;
+		t[5][l] = load_4(sl + 16);
+		t[6][l] = load_3(sl + 20) << 7;
+		t[7][l] = load_3(sl + 23) << 5;
+		t[8][l] = load_3(sl + 26) << 4;
+		t[9][l] = (load_3(sl + 29) & 8388607) << 2;
+	}
+	fe_carry(h, t);
+}
+
+/* Fully reduce a lane and serialize it (ref10 `fe_tobytes`). */
+static inline void fe_tobytes_lane(unsigned char *s, const fe *f, const size_t l) {
+	int32_t h[10];
+	for(size_t i=0; i<10; i++) h[i] = f->v[i][l];
+	int32_t q = (19 * h[9] + ((int32_t)1 << 24)) >> 25;
+	for(size_t i=0; i<10; i++) q = (h[i] + q) >> ((i & 1) ? 25 : 26);
+	h[0] += 19 * q;
+	for(size_t i=0; i<9; i++) {
+		const int bits = (i & 1) ? 25 : 26;
+		const int32_t c = h[i] >> bits;
+		h[i + 1] += c;
+		h[i] -= c * ((int32_t)1 << bits);
+	}
+	h[9] -= (h[9] >> 25) * ((int32_t)1 << 25);
+	s[ 0] = h[0] >> 0;
+	s[ 1] = h[0] >> 8;
+	s[ 2] = h[0] >> 16;
+	s[ 3] = (h[0] >> 24) | (h[1] * ((uint32_t)1 << 2));
+	s[ 4] = h[1] >> 6;
+	s[ 5] = h[1] >> 14;
+	s[ 6] = (h[1] >> 22) | (h[2] * ((uint32_t)1 << 3));
+	s[ 7] = h[2] >> 5;
+	s[ 8] = h[2] >> 13;
+	s[ 9] = (h[2] >> 21) | (h[3] * ((uint32_t)1 << 5));
+	s[10] = h[3] >> 3;
+	s[11] = h[3] >> 11;
+	s[12] = (h[3] >> 19) | (h[4] * ((uint32_t)1 << 6));
+	s[13] = h[4] >> 2;
+	s[14] = h[4] >> 10;
+	s[15] = h[4] >> 18;
+	s[16] = h[5] >> 0;
+	s[17] = h[5] >> 8;
+	s[18] = h[5] >> 16;
+	s[19] = (h[5] >> 24) | (h[6] * ((uint32_t)1 << 1));
+	s[20] = h[6] >> 7;
+	s[21] = h[6] >> 15;
+	s[22] = (h[6] >> 23) | (h[7] * ((uint32_t)1 << 3));
+	s[23] = h[7] >> 5;
+	s[24] = h[7] >> 13;
+	s[25] = (h[7] >> 21) | (h[8] * ((uint32_t)1 << 4));
+	s[26] = h[8] >> 4;
+	s[27] = h[8] >> 12;
+	s[28] = (h[8] >> 20) | (h[9] * ((uint32_t)1 << 6));
+	s[29] = h[9] >> 2;
+	s[30] = h[9] >> 10;
+	s[31] = h[9] >> 18;
+}
+
+/* Returns -1 in the lanes which are zero, 0 otherwise. */
+static inline vec fe_iszero(const fe *f) {
+	vec mask;
+	FOR_LANES(l) {
+		unsigned char s[32];
+		fe_tobytes_lane(s, f, l);
+		unsigned char acc = 0;
+		for(size_t i=0; i<32; i++) acc |= s[i];
+		mask[l] = -(int64_t)(((uint32_t)acc - 1) >> 31);
+	}
+	return mask;
+}
+
+/* out = z^(p-2). */
+static inline void fe_invert(fe *out, const fe *z) {
+	fe t0, t1, t2, t3;
+	fe_sq(&t0, z);
+	fe_sqn(&t1, &t0, 2);
+	fe_mul(&t1, z, &t1);
+	fe_mul(&t0, &t0, &t1);
+	fe_sq(&t2, &t0);
+	fe_mul(&t1, &t1, &t2);
+	fe_sqn(&t2, &t1, 5);
+	fe_mul(&t1, &t2, &t1);
+	fe_sqn(&t2, &t1, 10);
+	fe_mul(&t2, &t2, &t1);
+	fe_sqn(&t3, &t2, 20);
+	fe_mul(&t2, &t3, &t2);
+	fe_sqn(&t2, &t2, 10);
+	fe_mul(&t1, &t2, &t1);
+	fe_sqn(&t2, &t1, 50);
+	fe_mul(&t2, &t2, &t1);
+	fe_sqn(&t3, &t2, 100);
+	fe_mul(&t2, &t3, &t2);
+	fe_sqn(&t2, &t2, 50);
+	fe_mul(&t1, &t2, &t1);
+	fe_sqn(&t1, &t1, 5);
+	fe_mul(out, &t1, &t0);
+}
+
+/* out = z^((p-5)/8). */
+static inline void fe_pow22523(fe *out, const fe *z) {
+	fe t0, t1, t2;
+	fe_sq(&t0, z);
+	fe_sqn(&t1, &t0, 2);
+	fe_mul(&t1, z, &t1);
+	fe_mul(&t0, &t0, &t1);
+	fe_sq(&t0, &t0);
+	fe_mul(&t0, &t1, &t0);
+	fe_sqn(&t1, &t0, 5);
+	fe_mul(&t0, &t1, &t0);
+	fe_sqn(&t1, &t0, 10);
+	fe_mul(&t1, &t1, &t0);
+	fe_sqn(&t2, &t1, 20);
+	fe_mul(&t1, &t2, &t1);
+	fe_sqn(&t1, &t1, 10);
+	fe_mul(&t0, &t1, &t0);
+	fe_sqn(&t1, &t0, 50);
+	fe_mul(&t1, &t1, &t0);
+	fe_sqn(&t2, &t1, 100);
+	fe_mul(&t1, &t2, &t1);
+	fe_sqn(&t1, &t1, 50);
+	fe_mul(&t0, &t1, &t0);
+	fe_sqn(&t0, &t0, 2);
+	fe_mul(out, &t0, z);
+}
+
+static inline void ge_p3_0(ge_p3 *h) {
+	fe_0(&h->X);
+	fe_1(&h->Y);
+	fe_1(&h->Z);
+	fe_0(&h->T);
+}
+
+/**
+ * Decompress points (same semantics as libsodium's `ge25519_frombytes`).
+ * Returns -1 in the lanes decoded successfully and 0 in the lanes which are not on the curve.
+ */
+static inline vec ge_frombytes(ge_p3 *h, const unsigned char *s, const size_t stride) {
+	fe u, v, v3, vxx, m_root_check, p_root_check, x_sqrtm1, negx;
+	fe_frombytes(&h->Y, s, stride);
+	fe_1(&h->Z);
+	fe_sq(&u, &h->Y);
+	fe_mul_c(&v, &u, fe_d);
+	fe_sub(&u, &u, &h->Z);      /* u = y^2-1 */
+	fe_add(&v, &v, &h->Z);      /* v = dy^2+1 */
+	fe_sq(&v3, &v);
+	fe_mul(&v3, &v3, &v);       /* v3 = v^3 */
+	fe_sq(&h->X, &v3);
+	fe_mul(&h->X, &h->X, &v);
+	fe_mul(&h->X, &h->X, &u);   /* x = uv^7 */
+	fe_pow22523(&h->X, &h->X);  /* x = (uv^7)^((q-5)/8) */
+	fe_mul(&h->X, &h->X, &v3);
+	fe_mul(&h->X, &h->X, &u);   /* x = uv^3(uv^7)^((q-5)/8) */
+	fe_sq(&vxx, &h->X);
+	fe_mul(&vxx, &vxx, &v);
+	fe_sub(&m_root_check, &vxx, &u);
+	fe_add(&p_root_check, &vxx, &u);
+	const vec has_m_root = fe_iszero(&m_root_check);
+	const vec has_p_root = fe_iszero(&p_root_check);
+	fe_mul_c(&x_sqrtm1, &h->X, fe_sqrtm1);
+	fe_cmov(&h->X, &x_sqrtm1, ~has_m_root);
+	fe_neg(&negx, &h->X);
+	vec negate;
+	FOR_LANES(l) {
+		unsigned char x[32];
+		fe_tobytes_lane(x, &h->X, l);
+		negate[l] = -(int64_t)((x[0] & 1) ^ (s[l * stride + 31] >> 7));
+	}
+	fe_cmov(&h->X, &negx, negate);
+	fe_mul(&h->T, &h->X, &h->Y);
+	return has_m_root | has_p_root;
+}
+
+/* Compress points. */
+static inline void ge_p3_tobytes(unsigned char *s, const size_t stride, const ge_p3 *h) {
+	fe recip, x, y;
+	fe_invert(&recip, &h->Z);
+	fe_mul(&x, &h->X, &recip);
+	fe_mul(&y, &h->Y, &recip);
+	FOR_LANES(l) {
+		unsigned char xb[32];
+		fe_tobytes_lane(xb, &x, l);
+		fe_tobytes_lane(s + l * stride, &y, l);
+		s[l * stride + 31] ^= (xb[0] & 1) << 7;
+	}
+}
+
+static inline void ge_p3_to_cached(ge_cached *r, const ge_p3 *p) {
+	fe_add(&r->YplusX, &p->Y, &p->X);
+	fe_sub(&r->YminusX, &p->Y, &p->X);
+	fe_add(&r->Z2, &p->Z, &p->Z);
+	fe_mul_c(&r->T2d, &p->T, fe_d2);
+}
+
+/* r = p + q (add-2008-hwcd-3). */
+static inline void ge_add(ge_p3 *r, const ge_p3 *p, const ge_cached *q) {
+	fe a, b, c, d, e, f, g, h;
+	fe_sub(&a, &p->Y, &p->X);
+	fe_mul(&a, &a, &q->YminusX);
+	fe_add(&b, &p->Y, &p->X);
+	fe_mul(&b, &b, &q->YplusX);
+	fe_mul(&c, &p->T, &q->T2d);
+	fe_mul(&d, &p->Z, &q->Z2);
+	fe_sub(&e, &b, &a);
+	fe_sub(&f, &d, &c);
+	fe_add(&g, &d, &c);
+	fe_add(&h, &b, &a);
+	fe_mul(&r->X, &e, &f);
+	fe_mul(&r->Y, &g, &h);
+	fe_mul(&r->T, &e, &h);
+	fe_mul(&r->Z, &f, &g);
+}
+
+/* r = 2 * p (dbl-2008-hwcd). */
+static inline void ge_dbl(ge_p3 *r, const ge_p3 *p) {
+	fe a, b, c, e, f, g, h;
+	fe_sq(&a, &p->X);
+	fe_sq(&b, &p->Y);
+	fe_sq(&c, &p->Z);
+	fe_add(&c, &c, &c);
+	fe_add(&h, &p->X, &p->Y);
+	fe_sq(&h, &h);
+	fe_add(&e, &a, &b);
+	fe_sub(&e, &h, &e);   /* E = (X+Y)^2 - A - B */
+	fe_sub(&g, &b, &a);   /* G = B - A */
+	fe_sub(&f, &g, &c);   /* F = G - C */
+	fe_add(&h, &a, &b);
+	fe_neg(&h, &h);       /* H = -A - B */
+	fe_mul(&r->X, &e, &f);
+	fe_mul(&r->Y, &g, &h);
+	fe_mul(&r->T, &e, &h);
+	fe_mul(&r->Z, &f, &g);
+}
+
+static inline void ge_cached_0(ge_cached *r) {
+	fe_1(&r->YplusX);
+	fe_1(&r->YminusX);
+	fe_1(&r->Z2);
+	r->Z2.v[0] += 1;
+	fe_0(&r->T2d);
+}
+
+/* Conditionally negate the cached points in lanes where `mask[l] == -1`. */
+static inline void ge_cached_cneg(ge_cached *r, const vec mask) {
+	fe t;
+	fe_neg(&t, &r->T2d);
+	fe_cmov(&r->T2d, &t, mask);
+	for(size_t i=0; i<10; i++) {
+		const vec x = (r->YplusX.v[i] ^ r->YminusX.v[i]) & mask;
+		r->YplusX.v[i] ^= x;
+		r->YminusX.v[i] ^= x;
+	}
+}
+
+/* Recode each lane's 32-byte scalar into 64 signed radix-16 digits in [-8, 8]. Requires s[31] <= 127. */
+static inline void scalar_recode(vec e[64], const unsigned char *scalars) {
+	FOR_LANES(l) {
+		const unsigned char *a = scalars + l * 32;
+		int8_t d[64];
+		for(size_t i=0; i<32; i++) {
+			d[2 * i + 0] = (a[i] >> 0) & 15;
+			d[2 * i + 1] = (a[i] >> 4) & 15;
+		}
+		int8_t carry = 0;
+		for(size_t i=0; i<63; i++) {
+			d[i] += carry;
+			carry = (d[i] + 8) >> 4;
+			d[i] -= carry * ((int8_t)1 << 4);
+		}
+		d[63] += carry;
+		for(size_t i=0; i<64; i++) e[i][l] = d[i];
+	}
+}
+
+/* Select `table[|e|]` per lane in constant time and negate it when `e < 0`. */
+static inline void ge_select(ge_cached *t, const ge_cached table[9], const vec e) {
+	const vec neg = (vec)(e < 0);
+	const vec babs = e - ((neg & e) * 2);
+	*t = table[0];
+	for(int64_t k=1; k<=8; k++) {
+		const vec mask = (vec)(babs == k);
+		fe_cmov(&t->YplusX, &table[k].YplusX, mask);
+		fe_cmov(&t->YminusX, &table[k].YminusX, mask);
+		fe_cmov(&t->Z2, &table[k].Z2, mask);
+		fe_cmov(&t->T2d, &table[k].T2d, mask);
+	}
+	ge_cached_cneg(t, neg);
+}
+
+/* h = a * p (constant-time, per-lane scalars). */
+static inline void ge_scalarmult(ge_p3 *h, const unsigned char *scalars, const ge_p3 *p) {
+	ge_cached table[9];
+	ge_p3 t;
+	vec e[64];
+	ge_cached_0(&table[0]);
+	ge_p3_to_cached(&table[1], p);
+	t = *p;
+	for(size_t k=2; k<=8; k++) {
+		ge_add(&t, &t, &table[1]);
+		ge_p3_to_cached(&table[k], &t);
+	}
+	scalar_recode(e, scalars);
+	ge_p3_0(h);
+	for(int i=63; i>=0; i--) {
+		ge_cached sel;
+		if(i != 63) {
+			ge_dbl(h, h);
+			ge_dbl(h, h);
+			ge_dbl(h, h);
+			ge_dbl(h, h);
+		}
+		ge_select(&sel, table, e[i]);
+		ge_add(h, h, &sel);
+	}
+}
+
+/* base_table[i][k] = k * 256^i * G. Filled once by `init()`. */
+static ge_cached_1 base_table[32][9];
+
+static inline void ge_cached_1_extract(ge_cached_1 *r, const ge_cached *p) {
+	for(size_t i=0; i<10; i++) {
+		r->YplusX[i] = p->YplusX.v[i][0];
+		r->YminusX[i] = p->YminusX.v[i][0];
+		r->Z2[i] = p->Z2.v[i][0];
+		r->T2d[i] = p->T2d.v[i][0];
+	}
+}
+
+/* Select `base_table[pos][|e|]` per lane in constant time and negate it when `e < 0`. */
+static inline void ge_select_base(ge_cached *t, const size_t pos, const vec e) {
+	const vec neg = (vec)(e < 0);
+	const vec babs = e - ((neg & e) * 2);
+	for(size_t i=0; i<10; i++) {
+		t->YplusX.v[i] = t->YminusX.v[i] = t->Z2.v[i] = t->T2d.v[i] = (vec){};
+	}
+	for(int64_t k=0; k<=8; k++) {
+		const ge_cached_1 *b = &base_table[pos][k];
+		const vec mask = (vec)(babs == k);
+		for(size_t i=0; i<10; i++) {
+			t->YplusX.v[i] |= mask & b->YplusX[i];
+			t->YminusX.v[i] |= mask & b->YminusX[i];
+			t->Z2.v[i] |= mask & b->Z2[i];
+			t->T2d.v[i] |= mask & b->T2d[i];
+		}
+	}
+	ge_cached_cneg(t, neg);
+}
+
+/* h = a * G (constant-time, per-lane scalars). */
+static inline void ge_scalarmult_base(ge_p3 *h, const unsigned char *scalars) {
+	vec e[64];
+	ge_cached sel;
+	scalar_recode(e, scalars);
+	ge_p3_0(h);
+	for(size_t i=1; i<64; i+=2) {
+		ge_select_base(&sel, i / 2, e[i]);
+		ge_add(h, h, &sel);
+	}
+	ge_dbl(h, h);
+	ge_dbl(h, h);
+	ge_dbl(h, h);
+	ge_dbl(h, h);
+	for(size_t i=0; i<64; i+=2) {
+		ge_select_base(&sel, i / 2, e[i]);
+		ge_add(h, h, &sel);
+	}
+}
+
+static void init(void) {
+	ge_p3 base, t;
+	ge_cached c, tc;
+	unsigned char bytes[L][32];
+	FOR_LANES(l) memcpy(bytes[l], ge_base_bytes, 32);
+	ge_frombytes(&base, bytes[0], 32);
+	for(size_t i=0; i<32; i++) {
+		ge_cached_0(&c);
+		ge_cached_1_extract(&base_table[i][0], &c);
+		ge_p3_to_cached(&c, &base);
+		t = base;
+		for(size_t k=1; k<=8; k++) {
+			if(k > 1) ge_add(&t, &t, &c);
+			ge_p3_to_cached(&tc, &t);
+			ge_cached_1_extract(&base_table[i][k], &tc);
+		}
+		// base = 256 * base.
+		for(size_t j=0; j<8; j++) ge_dbl(&base, &base);
+	}
+}
+
+static void scalarmult_base(unsigned char *points, const size_t stride, const unsigned char *scalars) {
+	ge_p3 h;
+	ge_scalarmult_base(&h, scalars);
+	ge_p3_tobytes(points, stride, &h);
+}
+
+static void scalarmult_base_add(
+	unsigned char *points, const size_t stride, const unsigned char *a, const unsigned char *point, const unsigned char *b) {
+	unsigned char bytes[L][32];
+	ge_p3 p, h1, h2;
+	ge_cached c;
+	FOR_LANES(l) memcpy(bytes[l], point, 32);
+	ge_frombytes(&p, bytes[0], 32);
+	ge_scalarmult(&h1, a, &p);
+	ge_scalarmult_base(&h2, b);
+	ge_p3_to_cached(&c, &h2);
+	ge_add(&h1, &h1, &c);
+	ge_p3_tobytes(points, stride, &h1);
+}
+
+static void decrypt_to_mG(const unsigned char *privkey, unsigned char *ciphers) {
+	unsigned char scalars[L][32];
+	ge_p3 c1, c2;
+	ge_cached c;
+	FOR_LANES(l) memcpy(scalars[l], privkey, 32);
+	EPIR_PROFILE_BEGIN(t_decompress);
+	ge_frombytes(&c1, ciphers, 64);
+	ge_frombytes(&c2, ciphers + 32, 64);
+	EPIR_PROFILE_END(t_decompress, EPIR_PROFILE_DECOMPRESS);
+	EPIR_PROFILE_BEGIN(t_scalarmult);
+	ge_scalarmult(&c1, scalars[0], &c1);
+	ge_p3_to_cached(&c, &c1);
+	ge_cached_cneg(&c, (vec){} - 1);
+	ge_add(&c2, &c2, &c);
+	EPIR_PROFILE_END(t_scalarmult, EPIR_PROFILE_SCALARMULT);
+	EPIR_PROFILE_BEGIN(t_compress);
+	ge_p3_tobytes(ciphers, 64, &c2);
+	EPIR_PROFILE_END(t_compress, EPIR_PROFILE_COMPRESS);
+	EPIR_PROFILE_COUNT(ciphers, L);
+}
+
+const epir_lanes_backend EPIR_LANES_BACKEND = {
+	L, init, scalarmult_base, scalarmult_base_add, decrypt_to_mG
+};
+
+#undef SRA
+#undef MUL
+#undef FOR_LANES
+#undef L
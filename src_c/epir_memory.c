@@ -0,0 +1,84 @@
+/**
+ * Accounting of the heap memory allocated by the library.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "epir.h"
+#include "epir_memory.h"
+
+/**
+ * The header keeps the size of the allocation (and the alignment of `malloc()`).
+ */
+#define MEMORY_HEADER_SIZE (_Alignof(max_align_t))
+
+static size_t memory_current = 0;
+static size_t memory_peak = 0;
+
+static void epir_memory_add_(const size_t size) {
+	const size_t current = __atomic_add_fetch(&memory_current, size, __ATOMIC_RELAXED);
+	size_t peak = __atomic_load_n(&memory_peak, __ATOMIC_RELAXED);
+	while(peak < current && !__atomic_compare_exchange_n(&memory_peak, &peak, current, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void *epir_memory_track_(unsigned char *block, const size_t size) {
+	if(block == NULL) return NULL;
+	memcpy(block, &size, sizeof(size_t));
+	epir_memory_add_(size);
+	return block + MEMORY_HEADER_SIZE;
+}
+
+static size_t epir_memory_size_(const void *ptr) {
+	size_t size;
+	memcpy(&size, (const unsigned char*)ptr - MEMORY_HEADER_SIZE, sizeof(size_t));
+	return size;
+}
+
+void *epir_malloc_(const size_t size) {
+	if(size > SIZE_MAX - MEMORY_HEADER_SIZE) return NULL;
+	return epir_memory_track_(malloc(MEMORY_HEADER_SIZE + size), size);
+}
+
+void *epir_calloc_(const size_t n, const size_t size) {
+	if(size != 0 && n > (SIZE_MAX - MEMORY_HEADER_SIZE) / size) return NULL;
+	return epir_memory_track_(calloc(1, MEMORY_HEADER_SIZE + n * size), n * size);
+}
+
+void *epir_realloc_(void *ptr, const size_t size) {
+	if(ptr == NULL) return epir_malloc_(size);
+	if(size > SIZE_MAX - MEMORY_HEADER_SIZE) return NULL;
+	const size_t old_size = epir_memory_size_(ptr);
+	unsigned char *block = realloc((unsigned char*)ptr - MEMORY_HEADER_SIZE, MEMORY_HEADER_SIZE + size);
+	if(block == NULL) return NULL;
+	__atomic_sub_fetch(&memory_current, old_size, __ATOMIC_RELAXED);
+	return epir_memory_track_(block, size);
+}
+
+void epir_free_(void *ptr) {
+	if(ptr == NULL) return;
+	__atomic_sub_fetch(&memory_current, epir_memory_size_(ptr), __ATOMIC_RELAXED);
+	free((unsigned char*)ptr - MEMORY_HEADER_SIZE);
+}
+
+void *epir_mmap_(const size_t size) {
+	void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(ptr == MAP_FAILED) return NULL;
+	epir_memory_add_(size);
+	return ptr;
+}
+
+void epir_munmap_(void *ptr, const size_t size) {
+	munmap(ptr, size);
+	__atomic_sub_fetch(&memory_current, size, __ATOMIC_RELAXED);
+}
+
+void epir_memory_get(epir_memory_stats *stats) {
+	stats->current = __atomic_load_n(&memory_current, __ATOMIC_RELAXED);
+	stats->peak = __atomic_load_n(&memory_peak, __ATOMIC_RELAXED);
+}
+
+void epir_memory_reset_peak() {
+	__atomic_store_n(&memory_peak, __atomic_load_n(&memory_current, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
@@ -0,0 +1,32 @@
+/**
+ * Accounting of the heap memory allocated by the library (internal header).
+ *
+ * Every allocation of the library goes through these functions,
+ * which keep the size in a header before the returned pointer and maintain the counters read by `epir_memory_get()`.
+ */
+
+#ifndef EPIR_MEMORY_H
+#define EPIR_MEMORY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+void *epir_malloc_(const size_t size);
+void *epir_calloc_(const size_t n, const size_t size);
+void *epir_realloc_(void *ptr, const size_t size);
+void epir_free_(void *ptr);
+
+/**
+ * Map `size` bytes of anonymous memory (page aligned, for the large tables). Returns NULL on failure.
+ */
+void *epir_mmap_(const size_t size);
+void epir_munmap_(void *ptr, const size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
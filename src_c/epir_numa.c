@@ -0,0 +1,184 @@
+/**
+ * NUMA: the topology (read from sysfs), the thread binding and the placement of the mG tables.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+#include "epir.h"
+#include "epir_memory.h"
+#include "epir_numa.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define divide_up(a, b) (((a) / (b)) + (((a) % (b)) == 0 ? 0 : 1))
+
+__thread int32_t epir_numa_node_ = -1;
+
+#ifdef __linux__
+
+static pthread_once_t numa_once = PTHREAD_ONCE_INIT;
+static uint32_t numa_n_nodes = 1;
+static cpu_set_t numa_cpus[EPIR_NUMA_MAX_NODES];
+static uint8_t numa_cpu_node[CPU_SETSIZE];
+
+/**
+ * Read a sysfs list of ranges (e.g. "0-3,8-11") into `set`.
+ */
+static bool numa_read_list_(const char *path, cpu_set_t *set) {
+	CPU_ZERO(set);
+	FILE *fp = fopen(path, "r");
+	if(fp == NULL) return false;
+	char buf[4096];
+	const size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+	fclose(fp);
+	buf[len] = '\0';
+	for(char *p=buf; *p; ) {
+		char *end;
+		const long first = strtol(p, &end, 10);
+		if(end == p) break;
+		long last = first;
+		if(*end == '-') {
+			p = end + 1;
+			last = strtol(p, &end, 10);
+		}
+		for(long i=first; i<=last && i<CPU_SETSIZE; i++) CPU_SET(i, set);
+		if(*end != ',') break;
+		p = end + 1;
+	}
+	return true;
+}
+
+static void epir_numa_init_(void) {
+	cpu_set_t online;
+	if(!numa_read_list_("/sys/devices/system/node/online", &online)) return;
+	uint32_t n_nodes = 0;
+	for(uint32_t n=0; n<EPIR_NUMA_MAX_NODES; n++) {
+		if(CPU_ISSET(n, &online)) n_nodes = n + 1;
+	}
+	numa_n_nodes = (n_nodes > 0 ? n_nodes : 1);
+	for(uint32_t n=0; n<numa_n_nodes; n++) {
+		char path[64];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", n);
+		numa_read_list_(path, &numa_cpus[n]);
+		for(int cpu=0; cpu<CPU_SETSIZE; cpu++) {
+			if(CPU_ISSET(cpu, &numa_cpus[n])) numa_cpu_node[cpu] = n;
+		}
+	}
+}
+
+uint32_t epir_numa_nodes() {
+	pthread_once(&numa_once, epir_numa_init_);
+	return numa_n_nodes;
+}
+
+uint32_t epir_numa_current_node() {
+	if(epir_numa_node_ >= 0) return epir_numa_node_;
+	pthread_once(&numa_once, epir_numa_init_);
+	const int cpu = sched_getcpu();
+	return (cpu >= 0 && cpu < CPU_SETSIZE ? numa_cpu_node[cpu] : 0);
+}
+
+void epir_numa_bind_thread_(const uint32_t node) {
+	epir_numa_node_ = node;
+	pthread_once(&numa_once, epir_numa_init_);
+	if(node < numa_n_nodes && CPU_COUNT(&numa_cpus[node]) > 0) {
+		sched_setaffinity(0, sizeof(cpu_set_t), &numa_cpus[node]);
+	}
+}
+
+/**
+ * Set the memory policy of the pages of [addr, addr + len) to `mode` over the nodes [first, last).
+ * Best effort: the nodes which do not exist are ignored (and nothing is done on a single node).
+ */
+static void numa_mbind_(void *addr, const size_t len, const int mode, const uint32_t first, const uint32_t last) {
+	if(epir_numa_nodes() < 2) return;
+	unsigned long mask[EPIR_NUMA_MAX_NODES / (8 * sizeof(unsigned long))];
+	memset(mask, 0, sizeof(mask));
+	bool any = false;
+	for(uint32_t n=first; n<min(last, numa_n_nodes); n++) {
+		mask[n / (8 * sizeof(unsigned long))] |= 1UL << (n % (8 * sizeof(unsigned long)));
+		any = true;
+	}
+	if(any) syscall(SYS_mbind, addr, len, mode, mask, EPIR_NUMA_MAX_NODES + 1, 0);
+}
+
+#else
+
+uint32_t epir_numa_nodes() {
+	return 1;
+}
+
+uint32_t epir_numa_current_node() {
+	return (epir_numa_node_ >= 0 ? epir_numa_node_ : 0);
+}
+
+void epir_numa_bind_thread_(const uint32_t node) {
+	epir_numa_node_ = node;
+}
+
+#endif
+
+int epir_mG_table_init(epir_mG_table *table, const size_t mmax, const epir_numa_policy policy, const uint32_t n_nodes) {
+	memset(table, 0, sizeof(epir_mG_table));
+	table->policy = policy;
+	table->mmax = (mmax == 0 ? EPIR_DEFAULT_MG_MAX : mmax);
+	table->n_nodes = min(n_nodes == 0 ? epir_numa_nodes() : n_nodes, EPIR_NUMA_MAX_NODES);
+	table->n_replicas = (policy == EPIR_NUMA_REPLICATE ? table->n_nodes : 1);
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+	table->map_size = divide_up(sizeof(epir_mG_t) * table->mmax, page_size) * page_size;
+	for(uint32_t r=0; r<table->n_replicas; r++) {
+		// The policy is set before the first touch, thus the pages are placed on the first write.
+		table->replicas[r] = epir_mmap_(table->map_size);
+		if(table->replicas[r] == NULL) {
+			epir_mG_table_destroy(table);
+			return -1;
+		}
+#ifdef __linux__
+		if(policy == EPIR_NUMA_INTERLEAVE) {
+			numa_mbind_(table->replicas[r], table->map_size, MPOL_INTERLEAVE, 0, table->n_nodes);
+		} else if(policy == EPIR_NUMA_REPLICATE) {
+			// Preferred (not bound): the replica falls back to the other nodes when its node is out of memory.
+			numa_mbind_(table->replicas[r], table->map_size, MPOL_PREFERRED, r, r + 1);
+		}
+#endif
+	}
+	return 0;
+}
+
+int epir_mG_table_destroy(epir_mG_table *table) {
+	for(uint32_t r=0; r<table->n_replicas; r++) {
+		if(table->replicas[r]) epir_munmap_(table->replicas[r], table->map_size);
+		table->replicas[r] = NULL;
+	}
+	return 0;
+}
+
+size_t epir_mG_table_load(epir_mG_table *table, const char *path) {
+	const size_t loaded = epir_mG_load(table->replicas[0], table->mmax, path);
+	epir_mG_table_replicate(table);
+	return loaded;
+}
+
+void epir_mG_table_replicate(epir_mG_table *table) {
+	for(uint32_t r=1; r<table->n_replicas; r++) {
+		memcpy(table->replicas[r], table->replicas[0], sizeof(epir_mG_t) * table->mmax);
+	}
+}
+
+const epir_mG_t *epir_mG_table_local(const epir_mG_table *table) {
+	if(table->n_replicas == 1) return table->replicas[0];
+	return table->replicas[epir_numa_current_node() % table->n_replicas];
+}
+
+void epir_mG_table_memory_usage(const epir_mG_table *table, epir_memory_usage *usage) {
+	usage->resident = usage->reserved = table->map_size * table->n_replicas;
+}
@@ -0,0 +1,29 @@
+/**
+ * NUMA topology and thread binding (internal header).
+ */
+
+#ifndef EPIR_NUMA_H
+#define EPIR_NUMA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "epir.h"
+
+/**
+ * The node the calling thread is bound to by `epir_numa_bind_thread_()`, or negative if not bound.
+ */
+extern __thread int32_t epir_numa_node_;
+
+/**
+ * Bind the calling thread to `node`: pin it to the CPUs of the node (if the node exists)
+ * and use the replicas of the node in `epir_mG_table_local()`.
+ */
+void epir_numa_bind_thread_(const uint32_t node);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
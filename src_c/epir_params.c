@@ -0,0 +1,192 @@
+/**
+ * PIR parameter optimizer: the Pareto-optimal (index_counts, dimension, packing) for a given database.
+ */
+
+#include <math.h>
+#include <time.h>
+
+#include "epir.h"
+#include "epir_memory.h"
+#include "common.h"
+
+#define divide_up(a, b) (((a) / (b)) + (((a) % (b)) == 0 ? 0 : 1))
+
+/**
+ * The number of ciphers used to calibrate each cost.
+ */
+#define CALIBRATE_COUNT (256)
+
+void epir_cost_model_calibrate(epir_cost_model *model) {
+	unsigned char privkey[EPIR_SCALAR_SIZE];
+	epir_create_privkey(privkey);
+	uint64_t messages[CALIBRATE_COUNT];
+	for(size_t i=0; i<CALIBRATE_COUNT; i++) messages[i] = i;
+	unsigned char ciphers[CALIBRATE_COUNT * EPIR_CIPHER_SIZE];
+	// Client: encryption and decryption (to the points mG, excluding the search in the mG table).
+	// The costs are per thread, thus the encryption runs on the calling thread.
+	double begin = microtime();
+	epir_ecelgamal_encrypt_bulk_fast_ex(ciphers, privkey, messages, CALIBRATE_COUNT, NULL, EPIR_EXECUTOR_INLINE);
+	model->encrypt_seconds = (microtime() - begin) / 1e6 / CALIBRATE_COUNT;
+	begin = microtime();
+	epir_ecelgamal_decrypt_to_mG_batch(privkey, ciphers, CALIBRATE_COUNT);
+	model->decrypt_seconds = (microtime() - begin) / 1e6 / CALIBRATE_COUNT;
+	// Server: multiplying both points of a cipher by a message (of 1 and 4 bytes) and accumulating them.
+	ge25519_p3 point, acc;
+	ge25519_frombytes(&point, &ciphers[EPIR_POINT_SIZE]);
+	ge25519_p3_0(&acc);
+	unsigned char zero[EPIR_SCALAR_SIZE];
+	memset(zero, 0, EPIR_SCALAR_SIZE);
+	double elapsed[2];
+	const size_t bytes[2] = { 1, 4 };
+	for(size_t t=0; t<2; t++) {
+		begin = microtime();
+		for(size_t i=0; i<CALIBRATE_COUNT; i++) {
+			unsigned char m[EPIR_SCALAR_SIZE];
+			memset(m, 0, EPIR_SCALAR_SIZE);
+			for(size_t j=0; j<bytes[t]; j++) m[j] = 0xff - i - j;
+			for(size_t p=0; p<2; p++) {
+				ge25519_p2 mul;
+				ge25519_p3 mul3;
+				ge25519_p1p1 sum;
+				ge25519_cached cached;
+				ge25519_double_scalarmult_vartime(&mul, m, &point, zero);
+				fe25519_mul(mul3.X, mul.X, mul.Z);
+				fe25519_mul(mul3.Y, mul.Y, mul.Z);
+				fe25519_sq(mul3.Z, mul.Z);
+				fe25519_mul(mul3.T, mul.X, mul.Y);
+				ge25519_p3_to_cached(&cached, &mul3);
+				ge25519_add(&sum, &acc, &cached);
+				ge25519_p1p1_to_p3(&acc, &sum);
+			}
+		}
+		elapsed[t] = (microtime() - begin) / 1e6 / CALIBRATE_COUNT;
+	}
+	model->server_seconds_per_bit = (elapsed[1] - elapsed[0]) / (8 * (bytes[1] - bytes[0]));
+	if(model->server_seconds_per_bit < 0) model->server_seconds_per_bit = 0;
+	model->server_seconds_base = elapsed[0] - 8 * bytes[0] * model->server_seconds_per_bit;
+	if(model->server_seconds_base < 0) model->server_seconds_base = 0;
+}
+
+/**
+ * Fill the sizes and the costs of `params` from its `index_counts` and `packing`.
+ */
+static void epir_params_evaluate_(epir_params *params, const size_t elem_size, const epir_cost_model *model) {
+	const uint8_t n_indexes = params->n_indexes;
+	params->selector_size = EPIR_CIPHER_SIZE * epir_selector_ciphers_count(params->index_counts, n_indexes);
+	params->reply_size = epir_reply_size(n_indexes, params->packing, elem_size);
+	// Server: each phase multiplies the remaining elements (split into messages) by the ciphers of the selector.
+	double server_ops = 0;
+	uint64_t elements = epir_selector_elements_count(params->index_counts, n_indexes);
+	size_t size = elem_size;
+	for(uint8_t d=0; d<n_indexes; d++) {
+		const size_t n_messages = divide_up(size, params->packing);
+		server_ops += (double)elements * n_messages;
+		elements /= params->index_counts[d];
+		size = EPIR_CIPHER_SIZE * n_messages;
+	}
+	params->server_seconds = server_ops * (model->server_seconds_base + 8 * params->packing * model->server_seconds_per_bit);
+	// Client: encrypting the selector and decrypting the reply phase by phase (as `epir_reply_decrypt()`).
+	double decrypt_ciphers = 0;
+	size_t mid_count = params->reply_size / EPIR_CIPHER_SIZE;
+	for(uint8_t d=0; d<n_indexes; d++) {
+		decrypt_ciphers += mid_count;
+		mid_count = mid_count * params->packing / EPIR_CIPHER_SIZE;
+	}
+	params->client_seconds =
+		(params->selector_size / EPIR_CIPHER_SIZE) * model->encrypt_seconds + decrypt_ciphers * model->decrypt_seconds;
+}
+
+/**
+ * Returns true if `c^n >= n_elements` (without overflowing).
+ */
+static bool epir_params_pow_ge_(const uint64_t c, const uint8_t n, const uint64_t n_elements) {
+	uint64_t prod = 1;
+	for(uint8_t i=0; i<n; i++) {
+		if(prod >= n_elements) return true;
+		if(prod > UINT64_MAX / c) return true;
+		prod *= c;
+	}
+	return prod >= n_elements;
+}
+
+/**
+ * Returns the smallest `c` such that `c^n >= n_elements` (the integer n-th root rounded up).
+ */
+static uint64_t epir_params_balanced_(const uint64_t n_elements, const uint8_t n) {
+	if(n == 0 || n_elements <= 1) return 1;
+	if(n == 1) return n_elements;
+	// Estimate by pow() and fix up its rounding error.
+	uint64_t c = (uint64_t)ceil(pow((double)n_elements, 1.0 / n));
+	if(c < 1) c = 1;
+	while(c > 1 && epir_params_pow_ge_(c - 1, n, n_elements)) c--;
+	while(!epir_params_pow_ge_(c, n, n_elements)) c++;
+	return c;
+}
+
+static bool epir_params_dominates_(const epir_params *a, const epir_params *b) {
+	const uint64_t bw_a = a->selector_size + a->reply_size;
+	const uint64_t bw_b = b->selector_size + b->reply_size;
+	if(bw_a > bw_b || a->client_seconds > b->client_seconds || a->server_seconds > b->server_seconds) return false;
+	return bw_a < bw_b || a->client_seconds < b->client_seconds || a->server_seconds < b->server_seconds;
+}
+
+static int epir_params_compare_(const void *a_, const void *b_) {
+	const epir_params *a = a_, *b = b_;
+	const uint64_t bw_a = a->selector_size + a->reply_size;
+	const uint64_t bw_b = b->selector_size + b->reply_size;
+	if(bw_a != bw_b) return bw_a < bw_b ? -1 : 1;
+	return a->client_seconds < b->client_seconds ? -1 : a->client_seconds > b->client_seconds ? 1 : 0;
+}
+
+size_t epir_params_optimize(
+	epir_params *params, const size_t max_params,
+	const uint64_t n_elements, const size_t elem_size, const size_t mmax, const epir_cost_model *model) {
+	// The decrypted messages (of `packing` bytes) should be found in the mG table.
+	uint8_t max_packing = 0;
+	while(max_packing < 8 && ((uint64_t)1 << (8 * (max_packing + 1))) <= mmax) max_packing++;
+	if(n_elements == 0 || elem_size == 0 || max_packing == 0) return 0;
+	// Enumerate the candidates: the first dimension grows geometrically from the balanced shape,
+	// and the remaining dimensions are balanced (a larger first dimension lowers the later server phases).
+	size_t n_candidates = 0, candidates_capacity = 256;
+	epir_params *candidates = epir_malloc_(sizeof(epir_params) * candidates_capacity);
+	if(candidates == NULL) return 0;
+	for(uint8_t n_indexes=1; n_indexes<=EPIR_PARAMS_MAX_INDEXES; n_indexes++) {
+		for(uint64_t first=epir_params_balanced_(n_elements, n_indexes); ; first*=2) {
+			const uint64_t rest_elements = divide_up(n_elements, first);
+			if(n_indexes > 1 && rest_elements == 1) break;
+			const uint64_t rest = epir_params_balanced_(rest_elements, n_indexes - 1);
+			for(uint8_t packing=1; packing<=max_packing; packing++) {
+				if(n_candidates == candidates_capacity) {
+					candidates_capacity *= 2;
+					epir_params *resized = epir_realloc_(candidates, sizeof(epir_params) * candidates_capacity);
+					if(resized == NULL) {
+						epir_free_(candidates);
+						return 0;
+					}
+					candidates = resized;
+				}
+				epir_params *c = &candidates[n_candidates++];
+				memset(c, 0, sizeof(*c));
+				c->n_indexes = n_indexes;
+				c->index_counts[0] = first;
+				for(uint8_t i=1; i<n_indexes; i++) c->index_counts[i] = rest;
+				c->packing = packing;
+				epir_params_evaluate_(c, elem_size, model);
+			}
+			if(n_indexes == 1 || first >= n_elements) break;
+		}
+	}
+	// Keep the candidates not dominated by any other.
+	size_t n_optimal = 0;
+	for(size_t i=0; i<n_candidates; i++) {
+		bool dominated = false;
+		for(size_t j=0; j<n_candidates && !dominated; j++) {
+			dominated = epir_params_dominates_(&candidates[j], &candidates[i]);
+		}
+		if(!dominated) candidates[n_optimal++] = candidates[i];
+	}
+	qsort(candidates, n_optimal, sizeof(epir_params), epir_params_compare_);
+	if(max_params > 0) memcpy(params, candidates, sizeof(epir_params) * (n_optimal < max_params ? n_optimal : max_params));
+	epir_free_(candidates);
+	return n_optimal;
+}
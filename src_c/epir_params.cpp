@@ -0,0 +1,66 @@
+/**
+ * Find the Pareto-optimal PIR parameters (index_counts, dimension and packing) for a database.
+ * The cost model is calibrated on this machine unless it is given.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "epir.hpp"
+
+using namespace EllipticPIR;
+
+int main(int argc, char *argv[]) {
+	
+	if(argc >= 2 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help")) {
+		printf("usage: %s N_ELEMENTS ELEM_SIZE [M_MAX_MOD=24 [ENCRYPT_SEC DECRYPT_SEC SERVER_BASE_SEC SERVER_PER_BIT_SEC]]\n", argv[0]);
+		return 0;
+	}
+	if(argc < 3 || (argc > 3 && argc != 4 && argc != 8)) {
+		fprintf(stderr, "usage: %s N_ELEMENTS ELEM_SIZE [M_MAX_MOD=24 [ENCRYPT_SEC DECRYPT_SEC SERVER_BASE_SEC SERVER_PER_BIT_SEC]]\n", argv[0]);
+		return 1;
+	}
+	
+	const uint64_t nElements = strtoull(argv[1], NULL, 10);
+	const size_t elemSize = strtoull(argv[2], NULL, 10);
+	// The scalars of mG are 32-bit, and a packing of one byte needs 2^8 points.
+	const long mmaxMod = (argc > 3 ? strtol(argv[3], NULL, 10) : 24);
+	if(mmaxMod < 8 || mmaxMod > 32) {
+		fprintf(stderr, "M_MAX_MOD should be between 8 and 32.\n");
+		return 1;
+	}
+	const size_t mmax = ((size_t)1 << mmaxMod);
+	
+	epir_cost_model model;
+	if(argc == 8) {
+		model.encrypt_seconds = atof(argv[4]);
+		model.decrypt_seconds = atof(argv[5]);
+		model.server_seconds_base = atof(argv[6]);
+		model.server_seconds_per_bit = atof(argv[7]);
+	} else {
+		model = costModelCalibrate();
+	}
+	printf("Cost model: encrypt=%.3gs, decrypt=%.3gs, server=%.3gs+%.3gs/bit (per cipher).\n",
+		model.encrypt_seconds, model.decrypt_seconds, model.server_seconds_base, model.server_seconds_per_bit);
+	
+	const std::vector<epir_params> params = paramsOptimize(nElements, elemSize, model, mmax);
+	if(params.empty()) {
+		printf("No parameters found.\n");
+		return 1;
+	}
+	printf("%-32s %9s %7s %14s %14s %12s %12s\n",
+		"index_counts", "dimension", "packing", "selector_size", "reply_size", "client_sec", "server_sec");
+	for(const epir_params &p: params) {
+		std::string indexCounts;
+		for(uint8_t i=0; i<p.n_indexes; i++) {
+			indexCounts += (i > 0 ? "," : "") + std::to_string(p.index_counts[i]);
+		}
+		printf("%-32s %9d %7d %14lu %14lu %12.3f %12.3f\n",
+			indexCounts.c_str(), p.n_indexes, p.packing, p.selector_size, p.reply_size, p.client_seconds, p.server_seconds);
+	}
+	
+	return 0;
+	
+}
@@ -0,0 +1,116 @@
+/**
+ * Fixed-base tables of arbitrary points (the public keys of `epir_pubkey_ctx`).
+ *
+ * The scalar is recoded to signed `w`-bit digits e_i in [-2^(w-1), 2^(w-1)] so that a = sum(e_i * 2^(w*i)).
+ * The table holds [1..2^(w-1)] * 2^(w*i) * P for every window i, thus a * P needs
+ * ceil(256 / w) point additions and no doublings.
+ * The scalars are secret (the randomness), thus each lookup scans the whole row of its window
+ * with masked moves and negates the selected point by a masked move, as `ge25519_scalarmult_base()` does.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epir.h"
+#include "epir_point_table.h"
+
+#define divide_up(a, b) (((a) / (b)) + (((a) % (b)) == 0 ? 0 : 1))
+
+void epir_scalar_recode(int16_t *e, const unsigned char *a, const uint8_t w) {
+	const size_t windows = divide_up(256, w);
+	const uint32_t half = (uint32_t)1 << (w - 1);
+	const uint32_t mask = ((uint32_t)1 << w) - 1;
+	uint32_t carry = 0;
+	for(size_t i=0; i<windows; i++) {
+		// Load the w bits beginning at i * w (w + 7 <= 24, thus 3 bytes are enough).
+		const size_t bit = i * w;
+		uint32_t v = 0;
+		for(size_t k=0; k<3 && bit/8+k<EPIR_SCALAR_SIZE; k++) {
+			v |= (uint32_t)a[bit/8+k] << (8 * k);
+		}
+		v = ((v >> (bit % 8)) & mask) + carry;
+		// carry = (v > half) without a branch (v <= 2^w).
+		carry = (half - v) >> 31;
+		e[i] = (int16_t)(v - (carry << w));
+	}
+}
+
+/**
+ * Returns 1 if b == c, otherwise 0 (b, c < 2^31).
+ */
+static inline unsigned char ct_equal_(const uint32_t b, const uint32_t c) {
+	return (unsigned char)(((b ^ c) - 1) >> 31);
+}
+
+/**
+ * Returns 1 if e < 0, otherwise 0.
+ */
+static inline unsigned char ct_negative_(const int16_t e) {
+	return (unsigned char)((uint32_t)(int32_t)e >> 31);
+}
+
+/**
+ * Returns |e|.
+ */
+static inline uint32_t ct_abs_(const int16_t e) {
+	const int32_t m = (int32_t)e >> 31;
+	return (uint32_t)((e ^ m) - m);
+}
+
+/**
+ * Set t = e * row[0] (row[j] = (j + 1) * B, |e| <= n) in constant time.
+ */
+static void cached_select_(ge25519_cached *t, const ge25519_cached *row, const size_t n, const int16_t e) {
+	const uint32_t e_abs = ct_abs_(e);
+	fe25519_1(t->YplusX);
+	fe25519_1(t->YminusX);
+	fe25519_1(t->Z);
+	fe25519_0(t->T2d);
+	for(size_t j=0; j<n; j++) {
+		const unsigned int b = ct_equal_(e_abs, (uint32_t)j + 1);
+		fe25519_cmov(t->YplusX, row[j].YplusX, b);
+		fe25519_cmov(t->YminusX, row[j].YminusX, b);
+		fe25519_cmov(t->Z, row[j].Z, b);
+		fe25519_cmov(t->T2d, row[j].T2d, b);
+	}
+	ge25519_cached neg;
+	fe25519_copy(neg.YplusX, t->YminusX);
+	fe25519_copy(neg.YminusX, t->YplusX);
+	fe25519_neg(neg.T2d, t->T2d);
+	const unsigned int negative = ct_negative_(e);
+	fe25519_cmov(t->YplusX, neg.YplusX, negative);
+	fe25519_cmov(t->YminusX, neg.YminusX, negative);
+	fe25519_cmov(t->T2d, neg.T2d, negative);
+}
+
+void epir_point_table_init(ge25519_cached *table, const ge25519_p3 *p) {
+	ge25519_p3 base = *p;
+	for(size_t i=0; i<EPIR_POINT_TABLE_WINDOWS; i++) {
+		// table[i][j] = (j + 1) * 16^i * P.
+		ge25519_cached *row = &table[i * EPIR_POINT_TABLE_HALF];
+		ge25519_p3 point = base;
+		ge25519_p1p1 t;
+		ge25519_p3_to_cached(&row[0], &base);
+		for(size_t j=1; j<EPIR_POINT_TABLE_HALF; j++) {
+			ge25519_add(&t, &point, &row[0]);
+			ge25519_p1p1_to_p3(&point, &t);
+			ge25519_p3_to_cached(&row[j], &point);
+		}
+		// base = 16^(i+1) * P = 2 * (8 * 16^i * P).
+		ge25519_add(&t, &point, &row[EPIR_POINT_TABLE_HALF - 1]);
+		ge25519_p1p1_to_p3(&base, &t);
+	}
+}
+
+void epir_point_table_scalarmult(ge25519_p3 *h, const ge25519_cached *table, const unsigned char *a) {
+	int16_t e[EPIR_SCALAR_RECODE_MAX_DIGITS];
+	epir_scalar_recode(e, a, EPIR_POINT_TABLE_BITS);
+	ge25519_p3_0(h);
+	ge25519_p1p1 t;
+	for(size_t i=0; i<EPIR_POINT_TABLE_WINDOWS; i++) {
+		ge25519_cached c;
+		cached_select_(&c, &table[i * EPIR_POINT_TABLE_HALF], EPIR_POINT_TABLE_HALF, e[i]);
+		ge25519_add(&t, h, &c);
+		ge25519_p1p1_to_p3(h, &t);
+	}
+}
@@ -0,0 +1,55 @@
+/**
+ * Fixed-base tables of arbitrary points (internal header).
+ */
+
+#ifndef EPIR_POINT_TABLE_H
+#define EPIR_POINT_TABLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "common.h"
+
+/**
+ * The maximum number of digits `epir_scalar_recode()` outputs.
+ */
+#define EPIR_SCALAR_RECODE_MAX_DIGITS (64)
+
+/**
+ * Recode a scalar to `ceil(256 / w)` signed digits e[i] in [-2^(w-1), 2^(w-1)] so that a = sum(e[i] * 2^(w*i)).
+ * `a[31]` should be less than or equal to 127.
+ */
+void epir_scalar_recode(int16_t *e, const unsigned char *a, const uint8_t w);
+
+/**
+ * Reduce the scalar `a` modulo L in place (thus `a[31]` is less than or equal to 127).
+ */
+static inline void epir_scalar_reduce_(unsigned char *a) {
+	unsigned char wide[64];
+	memcpy(wide, a, 32);
+	memset(&wide[32], 0, 32);
+	sc25519_reduce(wide);
+	memcpy(a, wide, 32);
+}
+
+/**
+ * Build the fixed-base table of an arbitrary point P for `epir_point_table_scalarmult()`.
+ * The table should have `EPIR_POINT_TABLE_WINDOWS * EPIR_POINT_TABLE_HALF` entries.
+ */
+void epir_point_table_init(ge25519_cached *table, const ge25519_p3 *p);
+
+/**
+ * Compute h = a * P using the table built by `epir_point_table_init()` (constant-time).
+ * `a` should be reduced (see `epir_scalar_reduce_()`).
+ */
+void epir_point_table_scalarmult(ge25519_p3 *h, const ge25519_cached *table, const unsigned char *a);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
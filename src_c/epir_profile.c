@@ -0,0 +1,108 @@
+/**
+ * Phase timers and counters of the reply decryption: registry of the per-thread counters and aggregation.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epir.h"
+#include "epir_memory.h"
+#include "epir_profile.h"
+
+#ifdef EPIR_ENABLE_PROFILING
+
+__thread epir_profile_thread_ *epir_profile_self_ = NULL;
+__thread uint8_t epir_profile_phase_ = 0;
+
+static pthread_mutex_t profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+static epir_profile_thread_ *profile_threads = NULL;
+/** The counters of the exited threads. */
+static epir_profile_stats profile_retired;
+/** The statistics at the last `epir_profile_reset()`. */
+static epir_profile_stats profile_baseline;
+static pthread_key_t profile_key;
+static pthread_once_t profile_key_once = PTHREAD_ONCE_INIT;
+
+#define PROFILE_COUNTERS (sizeof(epir_profile_stats) / sizeof(uint64_t))
+
+static void epir_profile_accumulate_(epir_profile_stats *dst, const epir_profile_stats *src) {
+	uint64_t *d = (uint64_t*)dst;
+	const uint64_t *s = (const uint64_t*)src;
+	for(size_t i=0; i<PROFILE_COUNTERS; i++) d[i] += __atomic_load_n(&s[i], __ATOMIC_RELAXED);
+}
+
+/**
+ * Fold the counters of an exiting thread into `profile_retired`.
+ */
+static void epir_profile_unregister_(void *self_) {
+	epir_profile_thread_ *self = self_;
+	pthread_mutex_lock(&profile_mutex);
+	epir_profile_accumulate_(&profile_retired, &self->stats);
+	if(self->prev) {
+		self->prev->next = self->next;
+	} else {
+		profile_threads = self->next;
+	}
+	if(self->next) self->next->prev = self->prev;
+	pthread_mutex_unlock(&profile_mutex);
+	epir_profile_self_ = NULL;
+	epir_free_(self);
+}
+
+static void epir_profile_key_init_() {
+	pthread_key_create(&profile_key, epir_profile_unregister_);
+}
+
+epir_profile_thread_ *epir_profile_register_(void) {
+	pthread_once(&profile_key_once, epir_profile_key_init_);
+	epir_profile_thread_ *self = epir_calloc_(1, sizeof(epir_profile_thread_));
+	if(self == NULL) return NULL;
+	pthread_mutex_lock(&profile_mutex);
+	self->next = profile_threads;
+	if(profile_threads) profile_threads->prev = self;
+	profile_threads = self;
+	pthread_mutex_unlock(&profile_mutex);
+	pthread_setspecific(profile_key, self);
+	epir_profile_self_ = self;
+	return self;
+}
+
+static void epir_profile_total_(epir_profile_stats *stats) {
+	memcpy(stats, &profile_retired, sizeof(epir_profile_stats));
+	for(epir_profile_thread_ *t=profile_threads; t; t=t->next) epir_profile_accumulate_(stats, &t->stats);
+}
+
+bool epir_profile_enabled() {
+	return true;
+}
+
+void epir_profile_get(epir_profile_stats *stats) {
+	pthread_mutex_lock(&profile_mutex);
+	epir_profile_total_(stats);
+	uint64_t *s = (uint64_t*)stats;
+	const uint64_t *b = (const uint64_t*)&profile_baseline;
+	for(size_t i=0; i<PROFILE_COUNTERS; i++) s[i] -= b[i];
+	pthread_mutex_unlock(&profile_mutex);
+}
+
+void epir_profile_reset() {
+	// The counters are written by their threads only: the reset is a new baseline.
+	pthread_mutex_lock(&profile_mutex);
+	epir_profile_total_(&profile_baseline);
+	pthread_mutex_unlock(&profile_mutex);
+}
+
+#else
+
+bool epir_profile_enabled() {
+	return false;
+}
+
+void epir_profile_get(epir_profile_stats *stats) {
+	memset(stats, 0, sizeof(epir_profile_stats));
+}
+
+void epir_profile_reset() {
+}
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * Phase timers and counters of the reply decryption (internal header).
+ *
+ * The macros below compile to nothing unless the library is built with `EPIR_ENABLE_PROFILING`.
+ * Each thread accumulates into its own counters (written with relaxed atomics by the owner only),
+ * which are aggregated by `epir_profile_get()`.
+ */
+
+#ifndef EPIR_PROFILE_H
+#define EPIR_PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "epir.h"
+
+#ifdef EPIR_ENABLE_PROFILING
+
+#include <stddef.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+typedef struct epir_profile_thread_ epir_profile_thread_;
+
+struct epir_profile_thread_ {
+	epir_profile_stats stats;
+	epir_profile_thread_ *prev;
+	epir_profile_thread_ *next;
+};
+
+extern __thread epir_profile_thread_ *epir_profile_self_;
+extern __thread uint8_t epir_profile_phase_;
+
+/**
+ * Allocate and register the counters of the calling thread (NULL on the allocation failure).
+ */
+epir_profile_thread_ *epir_profile_register_(void);
+
+static inline uint64_t epir_profile_now_(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static inline epir_profile_stats *epir_profile_stats_(void) {
+	epir_profile_thread_ *self = epir_profile_self_;
+	if(self == NULL) self = epir_profile_register_();
+	return self ? &self->stats : NULL;
+}
+
+static inline void epir_profile_add_(uint64_t *counter, const uint64_t value) {
+	__atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+static inline void epir_profile_end_(const epir_profile_stage stage, const uint64_t begin) {
+	epir_profile_stats *stats = epir_profile_stats_();
+	if(stats) epir_profile_add_(&stats->cycles[epir_profile_phase_][stage], epir_profile_now_() - begin);
+}
+
+static inline void epir_profile_count_(const size_t offset, const uint64_t n) {
+	epir_profile_stats *stats = epir_profile_stats_();
+	if(stats) epir_profile_add_(&((uint64_t*)((char*)stats + offset))[epir_profile_phase_], n);
+}
+
+#define EPIR_PROFILE_BEGIN(t) const uint64_t t = epir_profile_now_()
+#define EPIR_PROFILE_END(t, stage) epir_profile_end_((stage), (t))
+#define EPIR_PROFILE_COUNT(field, n) epir_profile_count_(offsetof(epir_profile_stats, field), (n))
+#define EPIR_PROFILE_SET_PHASE(phase) \
+	(epir_profile_phase_ = ((phase) < EPIR_PROFILE_MAX_PHASES ? (phase) : EPIR_PROFILE_MAX_PHASES - 1))
+
+#else
+
+#define EPIR_PROFILE_BEGIN(t) ((void)0)
+#define EPIR_PROFILE_END(t, stage) ((void)0)
+#define EPIR_PROFILE_COUNT(field, n) ((void)0)
+#define EPIR_PROFILE_SET_PHASE(phase) ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
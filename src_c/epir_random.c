@@ -0,0 +1,78 @@
+/**
+ * Buffered per-thread scalar generator and seed-expanded randomness.
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include <sodium/crypto_stream_chacha20.h>
+
+#include "epir.h"
+#include "common.h"
+
+/**
+ * The number of scalars generated at once by a single ChaCha20 call.
+ */
+#define RANDOM_BUFFER_SCALARS (64)
+/**
+ * The number of random bytes reduced to a scalar (to make the bias negligible).
+ */
+#define RANDOM_SCALAR_BYTES (64)
+
+typedef struct {
+	unsigned char key[crypto_stream_chacha20_KEYBYTES];
+	unsigned char buf[RANDOM_BUFFER_SCALARS * RANDOM_SCALAR_BYTES];
+	size_t remaining;
+	uint64_t generation;
+} epir_random_state;
+
+static _Thread_local epir_random_state random_state = { .remaining = 0, .generation = 0 };
+// Incremented in the child process after fork(), so that the child never reuses the parent's stream.
+static uint64_t random_generation = 1;
+static pthread_once_t random_once = PTHREAD_ONCE_INIT;
+
+static void epir_random_atfork_child() {
+	__atomic_add_fetch(&random_generation, 1, __ATOMIC_RELAXED);
+}
+
+static void epir_random_register_atfork() {
+	pthread_atfork(NULL, NULL, epir_random_atfork_child);
+}
+
+static void epir_random_refill(epir_random_state *state) {
+	const uint64_t generation = __atomic_load_n(&random_generation, __ATOMIC_RELAXED);
+	if(state->generation != generation) {
+		pthread_once(&random_once, epir_random_register_atfork);
+		randombytes_buf(state->key, sizeof(state->key));
+		state->generation = generation;
+	}
+	// Fast key erasure: the first bytes of the stream become the next key.
+	static const unsigned char nonce[crypto_stream_chacha20_NONCEBYTES] = { 0 };
+	unsigned char stream[sizeof(state->key) + sizeof(state->buf)];
+	crypto_stream_chacha20(stream, sizeof(stream), nonce, state->key);
+	memcpy(state->key, stream, sizeof(state->key));
+	memcpy(state->buf, stream + sizeof(state->key), sizeof(state->buf));
+	memset(stream, 0, sizeof(stream));
+	state->remaining = RANDOM_BUFFER_SCALARS;
+}
+
+void epir_scalar_random(unsigned char *s) {
+	epir_random_state *state = &random_state;
+	if(state->remaining == 0 || state->generation != __atomic_load_n(&random_generation, __ATOMIC_RELAXED)) {
+		epir_random_refill(state);
+	}
+	state->remaining--;
+	unsigned char *bytes = &state->buf[state->remaining * RANDOM_SCALAR_BYTES];
+	crypto_core_ed25519_scalar_reduce(s, bytes);
+	memset(bytes, 0, RANDOM_SCALAR_BYTES);
+}
+
+void epir_scalar_from_seed(unsigned char *s, const unsigned char *seed, const uint64_t counter) {
+	unsigned char nonce[crypto_stream_chacha20_NONCEBYTES];
+	for(size_t i=0; i<sizeof(nonce); i++) {
+		nonce[i] = (counter >> (8 * i)) & 0xFF;
+	}
+	unsigned char bytes[RANDOM_SCALAR_BYTES];
+	crypto_stream_chacha20(bytes, sizeof(bytes), nonce, seed);
+	crypto_core_ed25519_scalar_reduce(s, bytes);
+}
@@ -1,5 +1,6 @@
 
 #include "epir.h"
+#include "epir_memory.h"
 
 #define divide_up(a, b) (((a) / (b)) + (((a) % (b)) == 0 ? 0 : 1 ))
 
@@ -21,36 +22,77 @@ size_t epir_reply_r_count(const uint8_t dimension, const uint8_t packing, const
 	return r_count;
 }
 
+inline size_t epir_reply_mock_workspace_size(const uint8_t dimension, const uint8_t packing, const size_t elem_size) {
+	return epir_reply_size(dimension, packing, elem_size);
+}
+
+typedef struct {
+	unsigned char *midstate;
+	const unsigned char *reply;
+	size_t reply_size;
+	const unsigned char *key;
+	uint8_t packing;
+	const unsigned char *r;
+	const unsigned char *seed;
+	size_t r_offset;
+	epir_ecelgamal_encrypt_fn *encrypt;
+} reply_mock_data;
+
+static void reply_mock_task(void *data_, const size_t i) {
+	const reply_mock_data *data = data_;
+	uint64_t msg = 0;
+	for(size_t j=0; (j<data->packing)&&(i*data->packing+j<data->reply_size); j++) {
+		msg |= data->reply[i * data->packing + j] << (8 * j);
+	}
+	unsigned char rr[EPIR_SCALAR_SIZE];
+	if(data->seed) epir_scalar_from_seed(rr, data->seed, data->r_offset + i);
+	data->encrypt(
+		&data->midstate[i * EPIR_CIPHER_SIZE], data->key, msg,
+		data->r ? &data->r[(data->r_offset + i) * EPIR_SCALAR_SIZE] : data->seed ? rr : NULL);
+}
+
 /**
- * Generates a sample server reply.
+ * Generates a sample server reply, run by the executor `exec`.
+ * The randomness of the i-th cipher is `r[i]`, expanded from `seed` or randomly chosen if both are NULL.
+ * `midstate` is a buffer of `epir_reply_mock_workspace_size()` bytes.
  */
 static inline void epir_reply_mock_(
 	unsigned char *reply,
 	const unsigned char *key,
 	const uint8_t dimension, const uint8_t packing,
-	const uint8_t *elem, const size_t elem_size, const unsigned char *r,
-	epir_ecelgamal_encrypt_fn encrypt) {
-	const size_t reply_size_final = epir_reply_size(dimension, packing, elem_size);
-	unsigned char *midstate = (unsigned char*)malloc(reply_size_final);
+	const uint8_t *elem, const size_t elem_size, const unsigned char *r, const unsigned char *seed,
+	epir_ecelgamal_encrypt_fn encrypt, unsigned char *midstate, epir_executor *exec) {
 	memcpy(reply, elem, elem_size);
 	size_t reply_size = elem_size;
 	size_t r_offset = 0;
 	for(size_t d=0; d<dimension; d++) {
-		const size_t midstate_size = EPIR_CIPHER_SIZE * divide_up(reply_size, packing);
-		#pragma omp parallel for
-		for(size_t i=0; i<divide_up(reply_size, packing); i++) {
-			uint64_t msg = 0;
-			for(size_t j=0; (j<packing)&&(i*packing+j<reply_size); j++) {
-				msg |= reply[i * packing + j] << (8 * j);
-			}
-			encrypt(
-				&midstate[i * EPIR_CIPHER_SIZE], key, msg,
-				r ? &r[(r_offset++) * EPIR_SCALAR_SIZE] : NULL);
-		}
+		const size_t n_ciphers = divide_up(reply_size, packing);
+		const size_t midstate_size = EPIR_CIPHER_SIZE * n_ciphers;
+		reply_mock_data data = { midstate, reply, reply_size, key, packing, r, seed, r_offset, encrypt };
+		epir_executor_parallel_for(exec, n_ciphers, reply_mock_task, &data);
+		r_offset += n_ciphers;
 		memcpy(reply, midstate, midstate_size);
 		reply_size = midstate_size;
 	}
-	free(midstate);
+}
+
+/**
+ * The same as `epir_reply_mock_()`, but allocates the midstate buffer.
+ * If it cannot be allocated, the reply is zero-filled (rather than left uninitialized).
+ */
+static inline void epir_reply_mock_alloc_(
+	unsigned char *reply,
+	const unsigned char *key,
+	const uint8_t dimension, const uint8_t packing,
+	const uint8_t *elem, const size_t elem_size, const unsigned char *r, const unsigned char *seed,
+	epir_ecelgamal_encrypt_fn encrypt, epir_executor *exec) {
+	unsigned char *midstate = (unsigned char*)epir_malloc_(epir_reply_mock_workspace_size(dimension, packing, elem_size));
+	if(!midstate) {
+		memset(reply, 0, epir_reply_size(dimension, packing, elem_size));
+		return;
+	}
+	epir_reply_mock_(reply, key, dimension, packing, elem, elem_size, r, seed, encrypt, midstate, exec);
+	epir_free_(midstate);
 }
 
 void epir_reply_mock(
@@ -58,7 +100,7 @@ void epir_reply_mock(
 	const unsigned char *pubkey,
 	const uint8_t dimension, const uint8_t packing,
 	const uint8_t *elem, const size_t elem_size, const unsigned char *r) {
-	epir_reply_mock_(reply, pubkey, dimension, packing, elem, elem_size, r, epir_ecelgamal_encrypt);
+	epir_reply_mock_alloc_(reply, pubkey, dimension, packing, elem, elem_size, r, NULL, epir_ecelgamal_encrypt, NULL);
 }
 
 void epir_reply_mock_fast(
@@ -66,6 +108,69 @@ void epir_reply_mock_fast(
 	const unsigned char *privkey,
 	const uint8_t dimension, const uint8_t packing,
 	const uint8_t *elem, const size_t elem_size, const unsigned char *r) {
-	epir_reply_mock_(reply, privkey, dimension, packing, elem, elem_size, r, epir_ecelgamal_encrypt_fast);
+	epir_reply_mock_alloc_(reply, privkey, dimension, packing, elem, elem_size, r, NULL, epir_ecelgamal_encrypt_fast, NULL);
 }
 
+void epir_reply_mock_ex(
+	unsigned char *reply,
+	const unsigned char *pubkey,
+	const uint8_t dimension, const uint8_t packing,
+	const uint8_t *elem, const size_t elem_size, const unsigned char *r, epir_executor *exec) {
+	epir_reply_mock_alloc_(reply, pubkey, dimension, packing, elem, elem_size, r, NULL, epir_ecelgamal_encrypt, exec);
+}
+
+void epir_reply_mock_fast_ex(
+	unsigned char *reply,
+	const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing,
+	const uint8_t *elem, const size_t elem_size, const unsigned char *r, epir_executor *exec) {
+	epir_reply_mock_alloc_(reply, privkey, dimension, packing, elem, elem_size, r, NULL, epir_ecelgamal_encrypt_fast, exec);
+}
+
+void epir_reply_mock_seeded(
+	unsigned char *reply,
+	const unsigned char *pubkey,
+	const uint8_t dimension, const uint8_t packing,
+	const uint8_t *elem, const size_t elem_size, const unsigned char *seed) {
+	epir_reply_mock_alloc_(reply, pubkey, dimension, packing, elem, elem_size, NULL, seed, epir_ecelgamal_encrypt, NULL);
+}
+
+void epir_reply_mock_fast_seeded(
+	unsigned char *reply,
+	const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing,
+	const uint8_t *elem, const size_t elem_size, const unsigned char *seed) {
+	epir_reply_mock_alloc_(reply, privkey, dimension, packing, elem, elem_size, NULL, seed, epir_ecelgamal_encrypt_fast, NULL);
+}
+
+void epir_reply_mock_workspace(
+	unsigned char *reply,
+	const unsigned char *pubkey,
+	const uint8_t dimension, const uint8_t packing,
+	const uint8_t *elem, const size_t elem_size, const unsigned char *r, unsigned char *workspace) {
+	epir_reply_mock_(reply, pubkey, dimension, packing, elem, elem_size, r, NULL, epir_ecelgamal_encrypt, workspace, NULL);
+}
+
+void epir_reply_mock_fast_workspace(
+	unsigned char *reply,
+	const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing,
+	const uint8_t *elem, const size_t elem_size, const unsigned char *r, unsigned char *workspace) {
+	epir_reply_mock_(reply, privkey, dimension, packing, elem, elem_size, r, NULL, epir_ecelgamal_encrypt_fast, workspace, NULL);
+}
+
+void epir_reply_mock_seeded_workspace(
+	unsigned char *reply,
+	const unsigned char *pubkey,
+	const uint8_t dimension, const uint8_t packing,
+	const uint8_t *elem, const size_t elem_size, const unsigned char *seed, unsigned char *workspace) {
+	epir_reply_mock_(reply, pubkey, dimension, packing, elem, elem_size, NULL, seed, epir_ecelgamal_encrypt, workspace, NULL);
+}
+
+void epir_reply_mock_fast_seeded_workspace(
+	unsigned char *reply,
+	const unsigned char *privkey,
+	const uint8_t dimension, const uint8_t packing,
+	const uint8_t *elem, const size_t elem_size, const unsigned char *seed, unsigned char *workspace) {
+	epir_reply_mock_(reply, privkey, dimension, packing, elem, elem_size, NULL, seed, epir_ecelgamal_encrypt_fast, workspace, NULL);
+}
@@ -1,71 +1,377 @@
 
+#include <sched.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sodium/crypto_hash_sha256.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#ifndef __EMSCRIPTEN__
+#include <omp.h>
+#endif
+
 #include "epir.h"
+#include "epir_memory.h"
+#include "epir_trace.h"
+#include "common.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define divide_up(a, b) (((a) / (b)) + (((a) % (b)) == 0 ? 0 : 1))
+
+/**
+ * The number of ciphers encrypted (in a thread-local batch) and published at once.
+ */
+#define FILL_BLOCK_SIZE (64)
+
+/**
+ * Reserve up to `n` free slots. Returns the number of slots reserved (possibly zero).
+ */
+static uint64_t ring_reserve_write(epir_selector_factory_ring *ring, const uint32_t capacity, const uint64_t n, uint64_t *begin) {
+	uint64_t reserved = __atomic_load_n(&ring->write_reserved, __ATOMIC_RELAXED);
+	for(;;) {
+		const uint64_t read_committed = __atomic_load_n(&ring->read_committed, __ATOMIC_ACQUIRE);
+		if(reserved < read_committed) {
+			// `reserved` is stale (the readers have consumed beyond it): reload it rather than underflow.
+			reserved = __atomic_load_n(&ring->write_reserved, __ATOMIC_RELAXED);
+			continue;
+		}
+		const uint64_t used = reserved - read_committed;
+		const uint64_t count = (used >= capacity ? 0 : min(n, capacity - used));
+		if(count == 0) return 0;
+		if(__atomic_compare_exchange_n(
+			&ring->write_reserved, &reserved, reserved + count, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+			*begin = reserved;
+			return count;
+		}
+	}
+}
+
+/**
+ * Reserve exactly `n` ciphers. Returns false (and reserves nothing) if not enough ciphers are available.
+ */
+static bool ring_reserve_read(epir_selector_factory_ring *ring, const uint64_t n, uint64_t *begin) {
+	uint64_t reserved = __atomic_load_n(&ring->read_reserved, __ATOMIC_RELAXED);
+	for(;;) {
+		const uint64_t committed = __atomic_load_n(&ring->write_committed, __ATOMIC_ACQUIRE);
+		if(committed < reserved || committed - reserved < n) return false;
+		if(__atomic_compare_exchange_n(
+			&ring->read_reserved, &reserved, reserved + n, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+			*begin = reserved;
+			return true;
+		}
+	}
+}
 
+/**
+ * Publish the reserved range [begin, begin + n) after all the preceding ranges are published.
+ * Returns the time (in nanoseconds) spent waiting for them.
+ */
+static uint64_t ring_commit(uint64_t *committed, const uint64_t begin, const uint64_t n) {
+	uint64_t wait_ns = 0;
+	if(__atomic_load_n(committed, __ATOMIC_ACQUIRE) != begin) {
+		const double begin_time = microtime();
+		while(__atomic_load_n(committed, __ATOMIC_ACQUIRE) != begin) {
+			sched_yield();
+		}
+		wait_ns = (microtime() - begin_time) * 1000;
+	}
+	__atomic_store_n(committed, begin + n, __ATOMIC_RELEASE);
+	return wait_ns;
+}
+
+#define count_(ctx, counter, n) __atomic_add_fetch(&(ctx)->counters.counter, (n), __ATOMIC_RELAXED)
+
+/**
+ * The alignment of the ciphers in the workspace (the pubkey context precedes them).
+ */
+#define WORKSPACE_ALIGNMENT (64)
+
+inline size_t epir_selector_factory_ctx_workspace_size(const bool is_fast, const uint32_t capacity_zero, const uint32_t capacity_one) {
+	const size_t pubkey_ctx_size = is_fast ? 0 : divide_up(sizeof(epir_pubkey_ctx), WORKSPACE_ALIGNMENT) * WORKSPACE_ALIGNMENT;
+	return pubkey_ctx_size + EPIR_CIPHER_SIZE * ((size_t)capacity_zero + capacity_one);
+}
+
+/**
+ * Free the buffers allocated by `epir_selector_factory_ctx_init_()` (if not in a workspace).
+ */
+static void epir_selector_factory_ctx_free_buffers_(epir_selector_factory_ctx *ctx) {
+	if(!ctx->owns_buffers) return;
+	epir_free_(ctx->pubkey_ctx);
+	epir_free_(ctx->ciphers);
+	ctx->pubkey_ctx = NULL;
+	ctx->ciphers = NULL;
+}
+
+/**
+ * Place the pubkey context and the ciphers in `workspace`, or allocate them if it is NULL.
+ * Nothing is left allocated on failure.
+ */
 static inline int epir_selector_factory_ctx_init_(
 	epir_selector_factory_ctx *ctx,
-	const bool is_fast, const unsigned char *key, const uint32_t capacity_zero, const uint32_t capacity_one) {
+	const bool is_fast, const unsigned char *key, const uint32_t capacity_zero, const uint32_t capacity_one,
+	unsigned char *workspace) {
 	ctx->is_fast = is_fast;
 	memcpy(ctx->key, key, 32);
-	ctx->capacities[0] = capacity_zero;
-	ctx->capacities[1] = capacity_one;
-	ctx->ciphers[0] = malloc(sizeof(unsigned char) * EPIR_CIPHER_SIZE * capacity_zero);
-	if(ctx->ciphers[0] == NULL) return -1;
-	ctx->ciphers[1] = malloc(sizeof(unsigned char) * EPIR_CIPHER_SIZE * capacity_one);
-	if(ctx->ciphers[1] == NULL) return -1;
-	ctx->idx[0] = ctx->idx[1] = -1;
+	ctx->owns_buffers = (workspace == NULL);
+	ctx->pubkey_ctx = NULL;
+	ctx->ciphers = NULL;
+	if(!is_fast) {
+		ctx->pubkey_ctx = workspace ? (epir_pubkey_ctx*)workspace : epir_malloc_(sizeof(epir_pubkey_ctx));
+		if(ctx->pubkey_ctx == NULL || epir_pubkey_ctx_init(ctx->pubkey_ctx, key) != 0) {
+			epir_selector_factory_ctx_free_buffers_(ctx);
+			return -1;
+		}
+	}
+	// Ones are derived from zeros on demand, thus a single pool of zeros is kept.
+	ctx->capacity = capacity_zero + capacity_one;
+	if(ctx->capacity > 0) {
+		ctx->ciphers = workspace ?
+			workspace + epir_selector_factory_ctx_workspace_size(is_fast, 0, 0) :
+			epir_malloc_(sizeof(unsigned char) * EPIR_CIPHER_SIZE * ctx->capacity);
+		if(ctx->ciphers == NULL) {
+			epir_selector_factory_ctx_free_buffers_(ctx);
+			return -1;
+		}
+	}
+	memset(&ctx->ring, 0, sizeof(ctx->ring));
+	memset(&ctx->counters, 0, sizeof(ctx->counters));
+	ctx->replenishing = ctx->stopping = false;
+	ctx->executor = NULL;
 	int ret;
-	if((ret = pthread_mutex_init(&ctx->mutex, NULL)) != 0) return ret;
+	if((ret = pthread_mutex_init(&ctx->mutex, NULL)) != 0) {
+		epir_selector_factory_ctx_free_buffers_(ctx);
+		return ret;
+	}
+	if((ret = pthread_cond_init(&ctx->cond, NULL)) != 0) {
+		pthread_mutex_destroy(&ctx->mutex);
+		epir_selector_factory_ctx_free_buffers_(ctx);
+		return ret;
+	}
 	return 0;
 }
 
 int epir_selector_factory_ctx_init(
 	epir_selector_factory_ctx *ctx,
 	const unsigned char *pubkey, const uint32_t capacity_zero, const uint32_t capacity_one) {
-	return epir_selector_factory_ctx_init_(ctx, false, pubkey, capacity_zero, capacity_one);
+	return epir_selector_factory_ctx_init_(ctx, false, pubkey, capacity_zero, capacity_one, NULL);
 }
 
 int epir_selector_factory_ctx_init_fast(
 	epir_selector_factory_ctx *ctx,
 	const unsigned char *privkey, const uint32_t capacity_zero, const uint32_t capacity_one) {
-	return epir_selector_factory_ctx_init_(ctx, true, privkey, capacity_zero, capacity_one);
+	return epir_selector_factory_ctx_init_(ctx, true, privkey, capacity_zero, capacity_one, NULL);
+}
+
+int epir_selector_factory_ctx_init_workspace(
+	epir_selector_factory_ctx *ctx,
+	const unsigned char *pubkey, const uint32_t capacity_zero, const uint32_t capacity_one, unsigned char *workspace) {
+	if(workspace == NULL) return -1;
+	return epir_selector_factory_ctx_init_(ctx, false, pubkey, capacity_zero, capacity_one, workspace);
+}
+
+int epir_selector_factory_ctx_init_fast_workspace(
+	epir_selector_factory_ctx *ctx,
+	const unsigned char *privkey, const uint32_t capacity_zero, const uint32_t capacity_one, unsigned char *workspace) {
+	if(workspace == NULL) return -1;
+	return epir_selector_factory_ctx_init_(ctx, true, privkey, capacity_zero, capacity_one, workspace);
 }
 
 int epir_selector_factory_ctx_destroy(epir_selector_factory_ctx *ctx) {
-	free(ctx->ciphers[0]);
-	free(ctx->ciphers[1]);
+	if(ctx->replenishing) epir_selector_factory_stop_replenisher(ctx);
+	epir_selector_factory_ctx_free_buffers_(ctx);
 	int ret;
+	if((ret = pthread_cond_destroy(&ctx->cond)) != 0) return ret;
 	if((ret = pthread_mutex_destroy(&ctx->mutex)) != 0) return ret;
 	return 0;
 }
 
-int epir_selector_factory_fill_sync(epir_selector_factory_ctx *ctx) {
-	epir_ecelgamal_encrypt_fn *encrypt = ctx->is_fast ? epir_ecelgamal_encrypt_fast : epir_ecelgamal_encrypt;
+void epir_selector_factory_set_executor(epir_selector_factory_ctx *ctx, epir_executor *exec) {
+	ctx->executor = exec;
+}
+
+uint32_t epir_selector_factory_available(epir_selector_factory_ctx *ctx) {
+	epir_selector_factory_ring *ring = &ctx->ring;
+	const uint64_t reserved = __atomic_load_n(&ring->read_reserved, __ATOMIC_ACQUIRE);
+	const uint64_t committed = __atomic_load_n(&ring->write_committed, __ATOMIC_ACQUIRE);
+	return committed > reserved ? committed - reserved : 0;
+}
+
+/**
+ * Copy `n` ciphers between a contiguous buffer and the ring slots beginning at `begin`.
+ */
+static void ring_copy(
+	unsigned char *ring_ciphers, const uint32_t capacity, const uint64_t begin, unsigned char *buf, const uint64_t n,
+	const bool to_ring) {
+	const uint64_t slot = begin % capacity;
+	const uint64_t first = min(n, capacity - slot);
+	unsigned char *dst[2] = { &ring_ciphers[slot * EPIR_CIPHER_SIZE], ring_ciphers };
+	unsigned char *src[2] = { buf, &buf[first * EPIR_CIPHER_SIZE] };
+	const uint64_t len[2] = { first, n - first };
+	for(size_t i=0; i<2; i++) {
+		if(len[i] == 0) continue;
+		if(to_ring) {
+			memcpy(dst[i], src[i], len[i] * EPIR_CIPHER_SIZE);
+		} else {
+			memcpy(src[i], dst[i], len[i] * EPIR_CIPHER_SIZE);
+		}
+	}
+}
+
+static uint32_t epir_selector_factory_used_(epir_selector_factory_ctx *ctx) {
+	epir_selector_factory_ring *ring = &ctx->ring;
+	return __atomic_load_n(&ring->write_reserved, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->read_committed, __ATOMIC_ACQUIRE);
+}
+
+typedef struct {
+	epir_selector_factory_ctx *ctx;
+	int64_t needs;
+	/** Set if some ciphers did not fit in the ring. */
+	bool discarded;
+} fill_data;
+
+static void fill_task(void *data_, const size_t b) {
+	fill_data *data = data_;
+	epir_selector_factory_ctx *ctx = data->ctx;
+	epir_selector_factory_ring *ring = &ctx->ring;
+	const uint64_t count = min(FILL_BLOCK_SIZE, data->needs - b * FILL_BLOCK_SIZE);
+	uint64_t messages[FILL_BLOCK_SIZE];
+	memset(messages, 0, sizeof(messages));
+	unsigned char ciphers[FILL_BLOCK_SIZE * EPIR_CIPHER_SIZE];
+	if(ctx->is_fast) {
+		epir_ecelgamal_encrypt_bulk_fast_ex(ciphers, ctx->key, messages, count, NULL, EPIR_EXECUTOR_INLINE);
+	} else {
+		epir_ecelgamal_encrypt_bulk_ctx_ex(ciphers, ctx->pubkey_ctx, messages, count, NULL, EPIR_EXECUTOR_INLINE);
+	}
+	// Publish the batch (the ciphers which do not fit, when the ring is filled concurrently, are discarded).
+	uint64_t begin;
+	const uint64_t reserved = ring_reserve_write(ring, ctx->capacity, count, &begin);
+	if(reserved < count) __atomic_store_n(&data->discarded, true, __ATOMIC_RELAXED);
+	if(reserved == 0) return;
+	ring_copy(ctx->ciphers, ctx->capacity, begin, ciphers, reserved, true);
+	count_(ctx, commit_wait_ns, ring_commit(&ring->write_committed, begin, reserved));
+	count_(ctx, produced, reserved);
+}
+
+/**
+ * Fill the pool up to `target`.
+ * Without `rate_limit`, makes a single pass. Otherwise, encrypts in chunks of about 100ms
+ * until the target is reached (or the replenisher is stopped).
+ * Returns 2 if some ciphers were discarded because the pool was filled concurrently, otherwise zero.
+ */
+static int epir_selector_factory_fill_(epir_selector_factory_ctx *ctx, const uint32_t target, const uint32_t rate_limit) {
 	int ret = 0;
-	for(size_t msg=0; msg<2; msg++) {
-		int32_t needs = ctx->capacities[msg] - ctx->idx[msg] - 1;
-		#pragma omp parallel for
-		for(int32_t i=0; i<needs; i++) {
-			unsigned char cipher[EPIR_CIPHER_SIZE];
-			encrypt(cipher, ctx->key, msg, NULL);
-			if(pthread_mutex_lock(&ctx->mutex) != 0) {
-				ret = 1;
-				continue;
-			}
-			const int32_t idx = ++ctx->idx[msg];
-			if(idx >= (int32_t)ctx->capacities[msg]) {
-				ret = 2;
-				continue;
-			}
-			memcpy(&ctx->ciphers[msg][idx * EPIR_CIPHER_SIZE], cipher, EPIR_CIPHER_SIZE);
-			if(pthread_mutex_unlock(&ctx->mutex) != 0) {
-				ret = 3;
-				continue;
-			}
+	for(;;) {
+		const uint32_t used = epir_selector_factory_used_(ctx);
+		if(used >= target) break;
+		int64_t needs = target - used;
+		if(rate_limit) needs = min(needs, (int64_t)(rate_limit / 10 > FILL_BLOCK_SIZE ? rate_limit / 10 : FILL_BLOCK_SIZE));
+		const double begin_time = microtime();
+		EPIR_TRACE_BEGIN(span, selector_factory_fill, needs);
+		fill_data data = { ctx, needs, false };
+		epir_executor_parallel_for(ctx->executor, divide_up(needs, FILL_BLOCK_SIZE), fill_task, &data);
+		EPIR_TRACE_END(span, selector_factory_fill);
+		if(data.discarded) ret = 2;
+		const double elapsed = microtime() - begin_time;
+		count_(ctx, fill_ns, (uint64_t)(elapsed * 1000));
+		size_t bucket = 0;
+		while(bucket < EPIR_SELECTOR_FACTORY_LATENCY_BUCKETS - 1 && ((uint64_t)2 << bucket) <= elapsed) bucket++;
+		count_(ctx, refill_latency[bucket], 1);
+		if(!rate_limit) break;
+		const double wait = 1e6 * needs / rate_limit - elapsed;
+		if(wait > 0) {
+			const struct timespec ts = { (time_t)(wait / 1e6), (long)(((uint64_t)wait % 1000000) * 1000) };
+			nanosleep(&ts, NULL);
 		}
+		if(__atomic_load_n(&ctx->stopping, __ATOMIC_RELAXED)) break;
 	}
 	return ret;
 }
 
+int epir_selector_factory_fill_sync(epir_selector_factory_ctx *ctx) {
+	return epir_selector_factory_fill_(ctx, ctx->capacity, 0);
+}
+
+/**
+ * The watermarks are compared with the slots in use, as the fill targets them
+ * (otherwise the ciphers being read keep the pool below the low watermark, and the replenisher spins).
+ */
+static bool epir_selector_factory_below_low_(epir_selector_factory_ctx *ctx) {
+	return epir_selector_factory_used_(ctx) < ctx->replenisher_config.low_watermark;
+}
+
+/**
+ * Wake up the replenisher if the pool dropped below the low watermark.
+ */
+static void epir_selector_factory_notify_(epir_selector_factory_ctx *ctx) {
+	if(!__atomic_load_n(&ctx->replenishing, __ATOMIC_ACQUIRE)) return;
+	if(!epir_selector_factory_below_low_(ctx)) return;
+	pthread_mutex_lock(&ctx->mutex);
+	pthread_cond_signal(&ctx->cond);
+	pthread_mutex_unlock(&ctx->mutex);
+}
+
+static void *epir_selector_factory_replenisher(void *ctx_) {
+	epir_selector_factory_ctx *ctx = ctx_;
+	const epir_selector_factory_replenisher_config *config = &ctx->replenisher_config;
+#ifdef __linux__
+	// Threads created from here (i.e. the OpenMP threads) inherit the nice value.
+	if(config->nice != 0) setpriority(PRIO_PROCESS, syscall(SYS_gettid), config->nice);
+#endif
+#ifndef __EMSCRIPTEN__
+	if(config->n_threads > 0) omp_set_num_threads(config->n_threads);
+#endif
+	pthread_mutex_lock(&ctx->mutex);
+	while(!ctx->stopping) {
+		if(!epir_selector_factory_below_low_(ctx)) {
+			pthread_cond_wait(&ctx->cond, &ctx->mutex);
+			continue;
+		}
+		pthread_mutex_unlock(&ctx->mutex);
+		epir_selector_factory_fill_(ctx, config->high_watermark, config->rate_limit);
+		pthread_mutex_lock(&ctx->mutex);
+	}
+	pthread_mutex_unlock(&ctx->mutex);
+	return NULL;
+}
+
+int epir_selector_factory_start_replenisher(
+	epir_selector_factory_ctx *ctx, const epir_selector_factory_replenisher_config *config) {
+	if(ctx->replenishing) return -1;
+	if(config) {
+		ctx->replenisher_config = *config;
+	} else {
+		memset(&ctx->replenisher_config, 0, sizeof(ctx->replenisher_config));
+	}
+	uint32_t *high = &ctx->replenisher_config.high_watermark;
+	uint32_t *low = &ctx->replenisher_config.low_watermark;
+	if(*high == 0 || *high > ctx->capacity) *high = ctx->capacity;
+	if(*low == 0 || *low > *high) *low = *high / 2;
+	ctx->stopping = false;
+	int ret;
+	if((ret = pthread_create(&ctx->replenisher_thread, NULL, epir_selector_factory_replenisher, ctx)) != 0) return ret;
+	__atomic_store_n(&ctx->replenishing, true, __ATOMIC_RELEASE);
+	// Fill the pool right away if it is below the low watermark.
+	epir_selector_factory_notify_(ctx);
+	return 0;
+}
+
+int epir_selector_factory_stop_replenisher(epir_selector_factory_ctx *ctx) {
+	if(!ctx->replenishing) return -1;
+	pthread_mutex_lock(&ctx->mutex);
+	__atomic_store_n(&ctx->stopping, true, __ATOMIC_RELAXED);
+	pthread_cond_signal(&ctx->cond);
+	pthread_mutex_unlock(&ctx->mutex);
+	int ret;
+	if((ret = pthread_join(ctx->replenisher_thread, NULL)) != 0) return ret;
+	__atomic_store_n(&ctx->replenishing, false, __ATOMIC_RELEASE);
+	return 0;
+}
+
 static void *epir_selector_factory_thread(void *ctx_) {
 	epir_selector_factory_ctx *ctx = ctx_;
 	epir_selector_factory_fill_sync(ctx);
@@ -78,20 +384,578 @@ int epir_selector_factory_fill(epir_selector_factory_ctx *ctx) {
 	return 0;
 }
 
+static ge25519_precomp base_precomp;
+static pthread_once_t base_precomp_once = PTHREAD_ONCE_INIT;
+
+static void epir_selector_factory_base_precomp_init() {
+	ge25519_p3 base_p3;
+	unsigned char one_c[EPIR_SCALAR_SIZE];
+	memset(one_c, 0, EPIR_SCALAR_SIZE);
+	one_c[0] = 1;
+	ge25519_scalarmult_base(&base_p3, one_c);
+	ge25519_p3_to_precomp(&base_precomp, &base_p3);
+}
+
+/**
+ * Turn Enc(m) into Enc(m + 1) = Enc(m) + (O, G).
+ */
+static void epir_selector_factory_add_one_(unsigned char *cipher) {
+	pthread_once(&base_precomp_once, epir_selector_factory_base_precomp_init);
+	ge25519_p3 c2;
+	ge25519_frombytes(&c2, cipher + EPIR_POINT_SIZE);
+	ge25519_add_p3_precomp(&c2, &c2, &base_precomp);
+	ge25519_p3_tobytes(cipher + EPIR_POINT_SIZE, &c2);
+}
+
 int epir_selector_factory_create_selector(
 	unsigned char *ciphers, epir_selector_factory_ctx *ctx,
 	const uint64_t *index_counts, const uint8_t n_indexes, const uint64_t idx) {
 	uint64_t n_ciphers = epir_selector_ciphers_count(index_counts, n_indexes);
 	epir_selector_create_choice(ciphers, EPIR_CIPHER_SIZE, index_counts, n_indexes, idx);
-	int ret;
-	if((ret = pthread_mutex_lock(&ctx->mutex)) != 0) return ret;
+	uint64_t begin;
+	if(!ring_reserve_read(&ctx->ring, n_ciphers, &begin)) {
+		count_(ctx, misses, 1);
+		if(epir_selector_factory_available(ctx) == 0) count_(ctx, empties, 1);
+		epir_selector_factory_notify_(ctx);
+		return -1;
+	}
 	for(size_t i=0; i<n_ciphers; i++) {
-		uint8_t choice = ciphers[i * EPIR_CIPHER_SIZE];
-		if(ctx->idx[choice] < 0) return -1;
-		memcpy(&ciphers[i * EPIR_CIPHER_SIZE], &ctx->ciphers[choice][ctx->idx[choice] * EPIR_CIPHER_SIZE], EPIR_CIPHER_SIZE);
-		ctx->idx[choice]--;
+		const uint8_t choice = ciphers[i * EPIR_CIPHER_SIZE];
+		const uint64_t slot = (begin + i) % ctx->capacity;
+		memcpy(&ciphers[i * EPIR_CIPHER_SIZE], &ctx->ciphers[slot * EPIR_CIPHER_SIZE], EPIR_CIPHER_SIZE);
+		if(choice) epir_selector_factory_add_one_(&ciphers[i * EPIR_CIPHER_SIZE]);
+	}
+	count_(ctx, commit_wait_ns, ring_commit(&ctx->ring.read_committed, begin, n_ciphers));
+	count_(ctx, hits, 1);
+	if(epir_selector_factory_available(ctx) == 0) count_(ctx, empties, 1);
+	epir_selector_factory_notify_(ctx);
+	return 0;
+}
+
+/**
+ * Returns the upper bound (in seconds) of the histogram bucket containing the `p`-th percentile.
+ */
+static double epir_selector_factory_percentile_(const uint64_t *histogram, const uint64_t total, const double p) {
+	if(total == 0) return 0;
+	uint64_t count = 0;
+	for(size_t b=0; b<EPIR_SELECTOR_FACTORY_LATENCY_BUCKETS; b++) {
+		count += histogram[b];
+		if(count >= p * total) return ((uint64_t)2 << b) / 1e6;
+	}
+	return ((uint64_t)2 << (EPIR_SELECTOR_FACTORY_LATENCY_BUCKETS - 1)) / 1e6;
+}
+
+void epir_selector_factory_memory_usage(epir_selector_factory_ctx *ctx, epir_memory_usage *usage) {
+	const size_t pubkey_ctx_size = ctx->pubkey_ctx ? sizeof(epir_pubkey_ctx) : 0;
+	usage->resident = pubkey_ctx_size + (size_t)EPIR_CIPHER_SIZE * epir_selector_factory_available(ctx);
+	usage->reserved = pubkey_ctx_size + (size_t)EPIR_CIPHER_SIZE * ctx->capacity;
+}
+
+void epir_selector_factory_get_stats(epir_selector_factory_ctx *ctx, epir_selector_factory_stats *stats) {
+	epir_selector_factory_counters counters;
+	uint64_t *src = (uint64_t*)&ctx->counters;
+	uint64_t *dst = (uint64_t*)&counters;
+	for(size_t i=0; i<sizeof(counters)/sizeof(uint64_t); i++) {
+		dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+	}
+	stats->hits = counters.hits;
+	stats->misses = counters.misses;
+	stats->empties = counters.empties;
+	stats->depth = epir_selector_factory_available(ctx);
+	stats->capacity = ctx->capacity;
+	stats->produced = counters.produced;
+	stats->produced_per_second = (counters.fill_ns == 0 ? 0 : counters.produced / (counters.fill_ns / 1e9));
+	stats->commit_wait_seconds = counters.commit_wait_ns / 1e9;
+	uint64_t total = 0;
+	for(size_t b=0; b<EPIR_SELECTOR_FACTORY_LATENCY_BUCKETS; b++) total += counters.refill_latency[b];
+	stats->refill_latency_p50 = epir_selector_factory_percentile_(counters.refill_latency, total, 0.50);
+	stats->refill_latency_p90 = epir_selector_factory_percentile_(counters.refill_latency, total, 0.90);
+	stats->refill_latency_p99 = epir_selector_factory_percentile_(counters.refill_latency, total, 0.99);
+}
+
+#define POOL_FILE_MAGIC ("EPIRPOOL")
+#define POOL_FILE_VERSION (2)
+
+/**
+ * The header of the pool file, followed by `count` ciphers of zero.
+ * The ciphers before `cursor` are already consumed.
+ */
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t is_fast;
+	unsigned char key_hash[crypto_hash_sha256_BYTES];
+	uint64_t count;
+	uint64_t cursor;
+} epir_selector_factory_pool_header;
+
+static void epir_selector_factory_key_hash_(epir_selector_factory_ctx *ctx, unsigned char *hash) {
+	crypto_hash_sha256(hash, ctx->key, sizeof(ctx->key));
+}
+
+/**
+ * Lock `path`.lock exclusively and return its descriptor (-1 on failure); the lock is kept while it is open.
+ * The saves and loads of the same path are serialized by this lock.
+ */
+static int epir_selector_factory_lock_(const char *path) {
+	const size_t lock_len = strlen(path) + 6;
+	char lock_path[lock_len];
+	snprintf(lock_path, lock_len, "%s.lock", path);
+	const int lock_fd = open(lock_path, O_CREAT | O_RDWR | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if(lock_fd < 0) return -1;
+	if(flock(lock_fd, LOCK_EX) != 0) {
+		close(lock_fd);
+		return -1;
+	}
+	return lock_fd;
+}
+
+/**
+ * Create the temporary file of `epir_selector_factory_save()` exclusively, holding the lock of `path` in `*lock_fd`.
+ */
+static FILE *epir_selector_factory_save_open_(const char *path, const char *tmp_path, int *lock_fd) {
+	*lock_fd = epir_selector_factory_lock_(path);
+	if(*lock_fd < 0) return NULL;
+	// Holding the lock, a temporary file left is of a crashed save.
+	unlink(tmp_path);
+	const int fd = open(tmp_path, O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0600);
+	FILE *fp = (fd < 0 ? NULL : fdopen(fd, "w"));
+	if(fp == NULL) {
+		if(fd >= 0) {
+			close(fd);
+			unlink(tmp_path);
+		}
+		close(*lock_fd);
+		return NULL;
+	}
+	return fp;
+}
+
+int64_t epir_selector_factory_save(epir_selector_factory_ctx *ctx, const char *path) {
+	const size_t tmp_len = strlen(path) + 5;
+	char tmp_path[tmp_len];
+	snprintf(tmp_path, tmp_len, "%s.tmp", path);
+	int lock_fd;
+	FILE *fp = epir_selector_factory_save_open_(path, tmp_path, &lock_fd);
+	if(fp == NULL) return -1;
+	epir_selector_factory_pool_header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, POOL_FILE_MAGIC, sizeof(header.magic));
+	header.version = POOL_FILE_VERSION;
+	header.is_fast = ctx->is_fast;
+	epir_selector_factory_key_hash_(ctx, header.key_hash);
+	// Take all the available ciphers out of the ring.
+	uint64_t begin;
+	do {
+		header.count = epir_selector_factory_available(ctx);
+	} while(!ring_reserve_read(&ctx->ring, header.count, &begin));
+	bool success = (fwrite(&header, sizeof(header), 1, fp) == 1);
+	unsigned char buf[FILL_BLOCK_SIZE * EPIR_CIPHER_SIZE];
+	for(uint64_t i=0; i<header.count; i+=FILL_BLOCK_SIZE) {
+		const uint64_t n = min(FILL_BLOCK_SIZE, header.count - i);
+		ring_copy(ctx->ciphers, ctx->capacity, begin + i, buf, n, false);
+		success = success && (fwrite(buf, EPIR_CIPHER_SIZE, n, fp) == n);
+	}
+	count_(ctx, commit_wait_ns, ring_commit(&ctx->ring.read_committed, begin, header.count));
+	success = success && (fflush(fp) == 0) && (fsync(fileno(fp)) == 0);
+	success = (fclose(fp) == 0) && success;
+	if(!success || rename(tmp_path, path) != 0) {
+		unlink(tmp_path);
+		close(lock_fd);
+		return -1;
+	}
+	close(lock_fd);
+	return header.count;
+}
+
+int64_t epir_selector_factory_load(epir_selector_factory_ctx *ctx, const char *path) {
+	// The cursor is read, advanced and synced under the lock, thus concurrent loads never take the same ciphers.
+	const int lock_fd = epir_selector_factory_lock_(path);
+	if(lock_fd < 0) return -1;
+	const int fd = open(path, O_RDWR | O_CLOEXEC);
+	if(fd < 0) {
+		close(lock_fd);
+		return -1;
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0) {
+		close(fd);
+		close(lock_fd);
+		return -1;
+	}
+	if((size_t)st.st_size < sizeof(epir_selector_factory_pool_header)) {
+		close(fd);
+		close(lock_fd);
+		return -2;
+	}
+	unsigned char *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED) {
+		close(lock_fd);
+		return -1;
+	}
+	epir_selector_factory_pool_header *header = (epir_selector_factory_pool_header*)map;
+	unsigned char key_hash[crypto_hash_sha256_BYTES];
+	epir_selector_factory_key_hash_(ctx, key_hash);
+	if(memcmp(header->magic, POOL_FILE_MAGIC, sizeof(header->magic)) != 0 || header->version != POOL_FILE_VERSION ||
+		header->is_fast != ctx->is_fast || memcmp(header->key_hash, key_hash, sizeof(key_hash)) != 0 ||
+		sizeof(*header) + EPIR_CIPHER_SIZE * header->count != (uint64_t)st.st_size || header->cursor > header->count) {
+		munmap(map, st.st_size);
+		close(lock_fd);
+		return -2;
+	}
+	// Mark the ciphers which fit in the ring as consumed durably before using them.
+	const uint32_t used = epir_selector_factory_used_(ctx);
+	const uint64_t n_free = (used >= ctx->capacity ? 0 : ctx->capacity - used);
+	const uint64_t cursor = header->cursor;
+	const uint64_t n = min(n_free, header->count - header->cursor);
+	header->cursor += n;
+	if(msync(map, sizeof(*header), MS_SYNC) != 0) {
+		munmap(map, st.st_size);
+		close(lock_fd);
+		return -1;
+	}
+	close(lock_fd);
+	// Copy them to the ring (the ciphers which do not fit, when the ring is filled concurrently, are discarded).
+	uint64_t begin;
+	const uint64_t reserved = ring_reserve_write(&ctx->ring, ctx->capacity, n, &begin);
+	if(reserved > 0) {
+		ring_copy(ctx->ciphers, ctx->capacity, begin, map + sizeof(*header) + cursor * EPIR_CIPHER_SIZE, reserved, true);
+		count_(ctx, commit_wait_ns, ring_commit(&ctx->ring.write_committed, begin, reserved));
+	}
+	munmap(map, st.st_size);
+	return reserved;
+}
+
+/**
+ * The interval (in seconds) of updating the consumption rates and distributing the memory budget.
+ */
+#define POOL_TICK_INTERVAL (0.1)
+
+/**
+ * The time constant (in seconds) of the moving average of the consumption rates.
+ */
+#define POOL_RATE_TIME_CONSTANT (10.0)
+
+/**
+ * A key keeps the ciphers for this period (in seconds) of its consumption at most.
+ */
+#define POOL_HORIZON (60.0)
+
+/**
+ * The keys consuming less ciphers per second than this are considered idle.
+ */
+#define POOL_IDLE_RATE (0.01)
+
+/**
+ * The number of ciphers a worker encrypts for a key before choosing the next key.
+ */
+#define POOL_FILL_CHUNK (1024)
+
+/**
+ * Resize the cache of the entry to `capacity`, keeping as many available ciphers as fit.
+ * The caller should hold the write lock of the entry.
+ */
+static int epir_selector_factory_pool_resize_(epir_selector_factory_pool_entry *entry, const uint32_t capacity) {
+	epir_selector_factory_ctx *ctx = &entry->factory;
+	unsigned char *ciphers = NULL;
+	if(capacity > 0) {
+		ciphers = epir_malloc_(sizeof(unsigned char) * EPIR_CIPHER_SIZE * capacity);
+		if(ciphers == NULL) return -1;
+	}
+	const uint64_t n = min(epir_selector_factory_available(ctx), capacity);
+	if(n > 0) ring_copy(ctx->ciphers, ctx->capacity, ctx->ring.read_committed, ciphers, n, false);
+	epir_free_(ctx->ciphers);
+	ctx->ciphers = ciphers;
+	ctx->capacity = capacity;
+	ctx->ring.write_reserved = ctx->ring.write_committed = n;
+	ctx->ring.read_reserved = ctx->ring.read_committed = 0;
+	return 0;
+}
+
+/**
+ * Update the consumption rates and distribute the memory budget by them.
+ * The caller should hold the mutex of the pool.
+ */
+static void epir_selector_factory_pool_tick_(epir_selector_factory_pool *pool) {
+	const double now = microtime();
+	const double dt = (now - pool->last_tick) / 1e6;
+	if(dt < POOL_TICK_INTERVAL) return;
+	pool->last_tick = now;
+	const double alpha = dt / (POOL_RATE_TIME_CONSTANT + dt);
+	double rate_sum = 0;
+	for(size_t k=0; k<pool->config.max_keys; k++) {
+		epir_selector_factory_pool_entry *entry = pool->entries[k];
+		if(entry == NULL) continue;
+		const uint64_t demand = __atomic_exchange_n(&entry->demand, 0, __ATOMIC_RELAXED);
+		entry->rate += alpha * (demand / dt - entry->rate);
+		if(entry->rate < POOL_IDLE_RATE) entry->rate = 0;
+		rate_sum += entry->rate;
+	}
+	// Shrink first to make room for growing.
+	const uint64_t budget = pool->config.memory_budget / EPIR_CIPHER_SIZE;
+	for(int grow=0; grow<2; grow++) {
+		for(size_t k=0; k<pool->config.max_keys; k++) {
+			epir_selector_factory_pool_entry *entry = pool->entries[k];
+			if(entry == NULL) continue;
+			uint64_t target = 0;
+			if(entry->rate > 0) {
+				target = min((uint64_t)(budget * (entry->rate / rate_sum)), (uint64_t)(entry->rate * POOL_HORIZON));
+				// A cache smaller than a selector holds memory it never serves.
+				const uint64_t selector_ciphers = __atomic_load_n(&entry->selector_ciphers, __ATOMIC_RELAXED);
+				if(target < selector_ciphers) target = selector_ciphers;
+				target = min(divide_up(target, FILL_BLOCK_SIZE) * FILL_BLOCK_SIZE, UINT32_MAX / FILL_BLOCK_SIZE * FILL_BLOCK_SIZE);
+			}
+			const uint32_t capacity = entry->factory.capacity;
+			// Resize only on large changes to avoid reallocating on every tick.
+			if(grow ? (target <= capacity + capacity / 2 || pool->allocated - capacity + target > budget) :
+				!(target < capacity / 2 || (target == 0 && capacity > 0))) continue;
+			if(pthread_rwlock_trywrlock(&entry->lock) != 0) continue;
+			if(epir_selector_factory_pool_resize_(entry, target) == 0) {
+				pool->allocated = pool->allocated - capacity + target;
+			}
+			pthread_rwlock_unlock(&entry->lock);
+		}
+	}
+}
+
+/**
+ * Choose the hottest key which needs refilling and is not being refilled by another worker.
+ * The caller should hold the mutex of the pool.
+ */
+static epir_selector_factory_pool_entry *epir_selector_factory_pool_pick_(epir_selector_factory_pool *pool) {
+	epir_selector_factory_pool_entry *best = NULL;
+	for(size_t k=0; k<pool->config.max_keys; k++) {
+		epir_selector_factory_pool_entry *entry = pool->entries[k];
+		if(entry == NULL || entry->busy) continue;
+		const uint32_t capacity = entry->factory.capacity;
+		if(capacity == 0) continue;
+		// Start refilling below a half of the capacity, and continue until the cache is full.
+		if(epir_selector_factory_available(&entry->factory) < capacity / 2) __atomic_store_n(&entry->refilling, true, __ATOMIC_RELAXED);
+		if(!entry->refilling) continue;
+		if(best == NULL || entry->rate > best->rate) best = entry;
+	}
+	return best;
+}
+
+static void *epir_selector_factory_pool_worker(void *pool_) {
+	epir_selector_factory_pool *pool = pool_;
+#ifdef __linux__
+	if(pool->config.nice != 0) setpriority(PRIO_PROCESS, syscall(SYS_gettid), pool->config.nice);
+#endif
+	pthread_mutex_lock(&pool->mutex);
+	while(!pool->stopping) {
+		epir_selector_factory_pool_tick_(pool);
+		epir_selector_factory_pool_entry *entry = epir_selector_factory_pool_pick_(pool);
+		if(entry == NULL) {
+			// Sleep until the next tick (on CLOCK_REALTIME, as `microtime()`).
+			const double wake = (pool->last_tick / 1e6) + POOL_TICK_INTERVAL;
+			struct timespec ts = { (time_t)wake, (long)((wake - (time_t)wake) * 1e9) };
+			pthread_cond_timedwait(&pool->cond, &pool->mutex, &ts);
+			continue;
+		}
+		entry->busy = true;
+		// Locked before the mutex is released, thus the entry is not freed while it is refilled.
+		pthread_rwlock_rdlock(&entry->lock);
+		pthread_mutex_unlock(&pool->mutex);
+		epir_selector_factory_ctx *ctx = &entry->factory;
+		const uint32_t used = epir_selector_factory_used_(ctx);
+		epir_selector_factory_fill_(ctx, min((uint64_t)used + POOL_FILL_CHUNK, ctx->capacity), 0);
+		const bool full = (epir_selector_factory_used_(ctx) >= ctx->capacity);
+		pthread_rwlock_unlock(&entry->lock);
+		pthread_mutex_lock(&pool->mutex);
+		if(full) __atomic_store_n(&entry->refilling, false, __ATOMIC_RELAXED);
+		entry->busy = false;
+	}
+	pthread_mutex_unlock(&pool->mutex);
+	return NULL;
+}
+
+int epir_selector_factory_pool_init(epir_selector_factory_pool *pool, const epir_selector_factory_pool_config *config) {
+	pool->config = *config;
+	if(pool->config.n_workers == 0) pool->config.n_workers = sysconf(_SC_NPROCESSORS_ONLN);
+	pool->entries = epir_calloc_(pool->config.max_keys, sizeof(epir_selector_factory_pool_entry*));
+	pool->workers = epir_calloc_(pool->config.n_workers, sizeof(pthread_t));
+	if(pool->entries == NULL || pool->workers == NULL) {
+		epir_free_(pool->entries);
+		epir_free_(pool->workers);
+		return -1;
+	}
+	pool->allocated = 0;
+	pool->last_tick = microtime();
+	pool->stopping = false;
+	int ret;
+	if((ret = pthread_mutex_init(&pool->mutex, NULL)) != 0) {
+		epir_free_(pool->entries);
+		epir_free_(pool->workers);
+		return ret;
+	}
+	if((ret = pthread_cond_init(&pool->cond, NULL)) != 0) {
+		pthread_mutex_destroy(&pool->mutex);
+		epir_free_(pool->entries);
+		epir_free_(pool->workers);
+		return ret;
+	}
+	for(size_t w=0; w<pool->config.n_workers; w++) {
+		if((ret = pthread_create(&pool->workers[w], NULL, epir_selector_factory_pool_worker, pool)) != 0) {
+			// Stop and join the workers already started, then free everything.
+			pool->config.n_workers = w;
+			epir_selector_factory_pool_destroy(pool);
+			return ret;
+		}
 	}
-	if((ret = pthread_mutex_unlock(&ctx->mutex)) != 0) return ret;
 	return 0;
 }
 
+int epir_selector_factory_pool_destroy(epir_selector_factory_pool *pool) {
+	pthread_mutex_lock(&pool->mutex);
+	pool->stopping = true;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->mutex);
+	int ret;
+	for(size_t w=0; w<pool->config.n_workers; w++) {
+		if((ret = pthread_join(pool->workers[w], NULL)) != 0) return ret;
+	}
+	for(size_t k=0; k<pool->config.max_keys; k++) {
+		if(pool->entries[k]) epir_selector_factory_pool_remove_key(pool, k);
+	}
+	epir_free_(pool->entries);
+	epir_free_(pool->workers);
+	if((ret = pthread_cond_destroy(&pool->cond)) != 0) return ret;
+	if((ret = pthread_mutex_destroy(&pool->mutex)) != 0) return ret;
+	return 0;
+}
+
+static int64_t epir_selector_factory_pool_add_key_(epir_selector_factory_pool *pool, const bool is_fast, const unsigned char *key) {
+	epir_selector_factory_pool_entry *entry = epir_malloc_(sizeof(epir_selector_factory_pool_entry));
+	if(entry == NULL) return -1;
+	if(epir_selector_factory_ctx_init_(&entry->factory, is_fast, key, 0, 0, NULL) != 0) {
+		epir_free_(entry);
+		return -1;
+	}
+	if(pthread_rwlock_init(&entry->lock, NULL) != 0) {
+		epir_selector_factory_ctx_destroy(&entry->factory);
+		epir_free_(entry);
+		return -1;
+	}
+	// The workers themselves are the parallelism: fill each key on the worker only.
+	entry->factory.executor = EPIR_EXECUTOR_INLINE;
+	entry->demand = 0;
+	entry->selector_ciphers = 0;
+	entry->rate = 0;
+	entry->refilling = entry->busy = false;
+	pthread_mutex_lock(&pool->mutex);
+	int64_t key_id = -1;
+	for(size_t k=0; k<pool->config.max_keys; k++) {
+		if(pool->entries[k] != NULL) continue;
+		pool->entries[k] = entry;
+		key_id = k;
+		break;
+	}
+	pthread_mutex_unlock(&pool->mutex);
+	if(key_id < 0) {
+		pthread_rwlock_destroy(&entry->lock);
+		epir_selector_factory_ctx_destroy(&entry->factory);
+		epir_free_(entry);
+	}
+	return key_id;
+}
+
+int64_t epir_selector_factory_pool_add_key(epir_selector_factory_pool *pool, const unsigned char *pubkey) {
+	return epir_selector_factory_pool_add_key_(pool, false, pubkey);
+}
+
+int64_t epir_selector_factory_pool_add_key_fast(epir_selector_factory_pool *pool, const unsigned char *privkey) {
+	return epir_selector_factory_pool_add_key_(pool, true, privkey);
+}
+
+/**
+ * Look up the entry of the key and lock it for reading (NULL if the key ID is invalid or removed).
+ * The entry is locked before the mutex of the pool is released,
+ * thus `epir_selector_factory_pool_remove_key()` waits for the caller to unlock it before freeing it.
+ */
+static epir_selector_factory_pool_entry *epir_selector_factory_pool_lock_entry_(
+	epir_selector_factory_pool *pool, const uint32_t key_id) {
+	if(key_id >= pool->config.max_keys) return NULL;
+	pthread_mutex_lock(&pool->mutex);
+	epir_selector_factory_pool_entry *entry = pool->entries[key_id];
+	if(entry) pthread_rwlock_rdlock(&entry->lock);
+	pthread_mutex_unlock(&pool->mutex);
+	return entry;
+}
+
+int epir_selector_factory_pool_remove_key(epir_selector_factory_pool *pool, const uint32_t key_id) {
+	if(key_id >= pool->config.max_keys) return -1;
+	pthread_mutex_lock(&pool->mutex);
+	epir_selector_factory_pool_entry *entry = pool->entries[key_id];
+	if(entry == NULL) {
+		pthread_mutex_unlock(&pool->mutex);
+		return -1;
+	}
+	pool->entries[key_id] = NULL;
+	pool->allocated -= entry->factory.capacity;
+	pthread_mutex_unlock(&pool->mutex);
+	// Wait for the users which looked up the entry before it is removed (including the worker refilling it).
+	pthread_rwlock_wrlock(&entry->lock);
+	pthread_rwlock_unlock(&entry->lock);
+	pthread_rwlock_destroy(&entry->lock);
+	const int ret = epir_selector_factory_ctx_destroy(&entry->factory);
+	epir_free_(entry);
+	return ret;
+}
+
+int epir_selector_factory_pool_get_stats(
+	epir_selector_factory_pool *pool, const uint32_t key_id, epir_selector_factory_stats *stats) {
+	epir_selector_factory_pool_entry *entry = epir_selector_factory_pool_lock_entry_(pool, key_id);
+	if(entry == NULL) return -1;
+	epir_selector_factory_get_stats(&entry->factory, stats);
+	pthread_rwlock_unlock(&entry->lock);
+	return 0;
+}
+
+void epir_selector_factory_pool_memory_usage(epir_selector_factory_pool *pool, epir_memory_usage *usage) {
+	const size_t tables_size =
+		sizeof(epir_selector_factory_pool_entry*) * pool->config.max_keys + sizeof(pthread_t) * pool->config.n_workers;
+	usage->resident = usage->reserved = tables_size;
+	// The caches are resized only under the mutex.
+	pthread_mutex_lock(&pool->mutex);
+	for(size_t k=0; k<pool->config.max_keys; k++) {
+		epir_selector_factory_pool_entry *entry = pool->entries[k];
+		if(entry == NULL) continue;
+		epir_memory_usage entry_usage;
+		epir_selector_factory_memory_usage(&entry->factory, &entry_usage);
+		usage->resident += sizeof(epir_selector_factory_pool_entry) + entry_usage.resident;
+		usage->reserved += sizeof(epir_selector_factory_pool_entry) + entry_usage.reserved;
+	}
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+uint32_t epir_selector_factory_pool_available(epir_selector_factory_pool *pool, const uint32_t key_id) {
+	epir_selector_factory_pool_entry *entry = epir_selector_factory_pool_lock_entry_(pool, key_id);
+	if(entry == NULL) return 0;
+	const uint32_t available = epir_selector_factory_available(&entry->factory);
+	pthread_rwlock_unlock(&entry->lock);
+	return available;
+}
+
+int epir_selector_factory_pool_create_selector(
+	unsigned char *ciphers, epir_selector_factory_pool *pool, const uint32_t key_id,
+	const uint64_t *index_counts, const uint8_t n_indexes, const uint64_t idx) {
+	epir_selector_factory_pool_entry *entry = epir_selector_factory_pool_lock_entry_(pool, key_id);
+	if(entry == NULL) return -1;
+	const uint64_t selector_ciphers = epir_selector_ciphers_count(index_counts, n_indexes);
+	__atomic_add_fetch(&entry->demand, selector_ciphers, __ATOMIC_RELAXED);
+	__atomic_store_n(&entry->selector_ciphers, selector_ciphers, __ATOMIC_RELAXED);
+	const int ret = epir_selector_factory_create_selector(ciphers, &entry->factory, index_counts, n_indexes, idx);
+	// Read the entry while it is locked; it may be removed and freed as soon as it is unlocked.
+	const bool low = (epir_selector_factory_available(&entry->factory) < entry->factory.capacity / 2);
+	const bool refilling = __atomic_load_n(&entry->refilling, __ATOMIC_RELAXED);
+	pthread_rwlock_unlock(&entry->lock);
+	// Wake up a worker if the cache needs refilling.
+	if(low && !refilling) {
+		pthread_mutex_lock(&pool->mutex);
+		pthread_cond_signal(&pool->cond);
+		pthread_mutex_unlock(&pool->mutex);
+	}
+	return ret;
+}
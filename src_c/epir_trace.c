@@ -0,0 +1,82 @@
+/**
+ * Begin and end markers of the library operations: the Chrome trace event writer.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "epir.h"
+#include "epir_trace.h"
+
+#ifdef EPIR_ENABLE_TRACING
+
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static FILE *trace_fp = NULL;
+/** True after the closing bracket is written (at the exit), guarded by the lock of `trace_fp`. */
+static bool trace_closed = false;
+static __thread long trace_tid = 0;
+
+static long epir_trace_tid_(void) {
+	if(trace_tid == 0) {
+#ifdef __linux__
+		trace_tid = syscall(SYS_gettid);
+#else
+		trace_tid = (long)(uintptr_t)pthread_self();
+#endif
+	}
+	return trace_tid;
+}
+
+static void epir_trace_close_(void) {
+	flockfile(trace_fp);
+	fputs("\n]\n", trace_fp);
+	fflush(trace_fp);
+	trace_closed = true;
+	funlockfile(trace_fp);
+}
+
+static void epir_trace_open_(void) {
+	const char *path = getenv("EPIR_TRACE");
+	if(path == NULL || path[0] == '\0') return;
+	FILE *fp = fopen(path, "w");
+	if(fp == NULL) return;
+	// The JSON array format: each event is appended after a comma, thus the first one marks the start of the trace.
+	fprintf(fp, "[\n{\"name\":\"epir_trace\",\"cat\":\"epir\",\"ph\":\"i\",\"s\":\"p\",\"pid\":%d,\"tid\":%ld,\"ts\":%.3f}",
+		(int)getpid(), epir_trace_tid_(), epir_trace_now_());
+	trace_fp = fp;
+	atexit(epir_trace_close_);
+}
+
+bool epir_trace_enabled_(void) {
+	pthread_once(&trace_once, epir_trace_open_);
+	return trace_fp != NULL;
+}
+
+void epir_trace_end_(const char *name, const epir_trace_span_ *span) {
+	const double end = epir_trace_now_();
+	flockfile(trace_fp);
+	if(!trace_closed) {
+		fprintf(trace_fp,
+			",\n{\"name\":\"%s\",\"cat\":\"epir\",\"ph\":\"X\",\"pid\":%d,\"tid\":%ld,\"ts\":%.3f,\"dur\":%.3f,"
+			"\"args\":{\"size\":%" PRIu64 "}}",
+			name, (int)getpid(), epir_trace_tid_(), span->begin, end - span->begin, span->size);
+	}
+	funlockfile(trace_fp);
+}
+
+void epir_trace_flush() {
+	if(!epir_trace_enabled_()) return;
+	fflush(trace_fp);
+}
+
+#else
+
+void epir_trace_flush() {
+}
+
+#endif
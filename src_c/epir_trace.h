@@ -0,0 +1,73 @@
+/**
+ * Begin and end markers of the library operations (internal header).
+ *
+ * The macros below compile to nothing unless the library is built with `EPIR_ENABLE_TRACING`.
+ * Otherwise, each span fires the USDT probes `epir:<name>_begin` and `epir:<name>_end` (with the size as the argument)
+ * if <sys/sdt.h> is available, and is written as a Chrome trace event to the file named by
+ * the `EPIR_TRACE` environment variable (if set at the first span).
+ */
+
+#ifndef EPIR_TRACE_H
+#define EPIR_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "epir.h"
+
+#ifdef EPIR_ENABLE_TRACING
+
+#include <time.h>
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define EPIR_TRACE_PROBE_(name, n) STAP_PROBE1(epir, name, (n))
+#endif
+#endif
+#ifndef EPIR_TRACE_PROBE_
+#define EPIR_TRACE_PROBE_(name, n) ((void)0)
+#endif
+
+typedef struct {
+	/** The timestamp (in microseconds) or negative if the trace file is not written. */
+	double begin;
+	uint64_t size;
+} epir_trace_span_;
+
+/**
+ * Returns true if the trace file is written (opens it at the first call).
+ */
+bool epir_trace_enabled_(void);
+
+/**
+ * Append the complete event of the span ending now to the trace file.
+ */
+void epir_trace_end_(const char *name, const epir_trace_span_ *span);
+
+static inline double epir_trace_now_(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+#define EPIR_TRACE_BEGIN(span, name, n) \
+	const epir_trace_span_ span = { epir_trace_enabled_() ? epir_trace_now_() : -1, (uint64_t)(n) }; \
+	EPIR_TRACE_PROBE_(name##_begin, span.size)
+#define EPIR_TRACE_END(span, name) do { \
+	EPIR_TRACE_PROBE_(name##_end, span.size); \
+	if(span.begin >= 0) epir_trace_end_(#name, &span); \
+} while(0)
+
+#else
+
+#define EPIR_TRACE_BEGIN(span, name, n) ((void)0)
+#define EPIR_TRACE_END(span, name) ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+#include <future>
+
+#include <gtest/gtest.h>
+
+#include "../epir.hpp"
+
+#include "test_common.hpp"
+
+#ifdef EPIR_HAS_COROUTINES
+
+using namespace EllipticPIR;
+
+/**
+ * A coroutine which starts eagerly and passes its value (or exception) to a future.
+ */
+template<typename T>
+struct Task {
+	struct promise_type {
+		std::promise<T> promise;
+		Task get_return_object() {
+			return Task{ this->promise.get_future() };
+		}
+		std::suspend_never initial_suspend() noexcept {
+			return {};
+		}
+		std::suspend_never final_suspend() noexcept {
+			return {};
+		}
+		void return_value(T value) {
+			this->promise.set_value(std::move(value));
+		}
+		void unhandled_exception() {
+			this->promise.set_exception(std::current_exception());
+		}
+	};
+	std::future<T> future;
+};
+
+Task<Selector> createSelector(const PrivateKey &privkey, const IndexCounts &indexCounts, const uint64_t idx, std::stop_token stopToken = {}) {
+	co_return co_await privkey.createSelectorAsync(indexCounts, idx, NULL, stopToken);
+}
+
+Task<int> awaitJob(std::function<int(epir_job*)> submit) {
+	co_return co_await JobAwaitable<int>(std::move(submit), [](const int result) {
+		return result;
+	});
+}
+
+TEST(CoroutineTest, create_selector_async) {
+	const PrivateKey privkey(::privkey);
+	std::vector<uint64_t> ic(index_counts, index_counts + n_indexes);
+	const IndexCounts indexCounts(ic);
+	const Selector selector = createSelector(privkey, indexCounts, idx).future.get();
+	ASSERT_EQ(selector.size(), ciphers_count * EPIR_CIPHER_SIZE);
+	// The ciphers encrypt the choices.
+	std::vector<epir_mG_t> mG(2);
+	epir_mG_generate(mG.data(), mG.size(), NULL, NULL);
+	std::vector<unsigned char> choices(ciphers_count);
+	epir_selector_create_choice(choices.data(), 1, index_counts, n_indexes, idx);
+	for(size_t i=0; i<ciphers_count; i++) {
+		ASSERT_EQ(epir_ecelgamal_decrypt(::privkey, selector.data() + i * EPIR_CIPHER_SIZE, mG.data(), mG.size()), (int32_t)choices[i]);
+	}
+}
+
+TEST(CoroutineTest, create_selector_async_stopped) {
+	const PrivateKey privkey(::privkey);
+	std::vector<uint64_t> ic(index_counts, index_counts + n_indexes);
+	const IndexCounts indexCounts(ic);
+	// A stop requested before the submission cancels the job.
+	std::stop_source stopSource;
+	stopSource.request_stop();
+	auto future = createSelector(privkey, indexCounts, idx, stopSource.get_token()).future;
+	ASSERT_THROW(future.get(), const char*);
+}
+
+TEST(CoroutineTest, submit_failure) {
+	// A failed submission throws (and does not resume with a result of zero).
+	auto future = awaitJob([](epir_job*) {
+		return -1;
+	}).future;
+	ASSERT_THROW(future.get(), const char*);
+}
+
+#endif
@@ -1,6 +1,8 @@
 
 #include <fstream>
 #include <filesystem>
+#include <memory>
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 
@@ -33,6 +35,61 @@ TEST(ECElGamalTest, encrypt_fast) {
 	ASSERT_PRED2(SameCipher, cipher_test, cipher);
 }
 
+TEST(ECElGamalTest, encrypt_ctx) {
+	auto ctx = std::make_unique<epir_pubkey_ctx>();
+	ASSERT_EQ(epir_pubkey_ctx_init(ctx.get(), pubkey), 0);
+	unsigned char cipher_test[EPIR_CIPHER_SIZE];
+	epir_ecelgamal_encrypt_ctx(cipher_test, ctx.get(), msg, r);
+	ASSERT_PRED2(SameCipher, cipher_test, cipher);
+	for(const uint64_t message: {0, 1, 2, 0xFFFFFF}) {
+		unsigned char cipher_ref[EPIR_CIPHER_SIZE];
+		epir_ecelgamal_encrypt(cipher_ref, pubkey, message, r);
+		epir_ecelgamal_encrypt_ctx(cipher_test, ctx.get(), message, r);
+		EXPECT_PRED2(SameCipher, cipher_test, cipher_ref);
+	}
+}
+
+TEST(ECElGamalTest, encrypt_bulk) {
+	const size_t n = 100;
+	std::vector<uint64_t> messages(n);
+	std::vector<unsigned char> rs(n * EPIR_SCALAR_SIZE);
+	for(size_t i=0; i<n; i++) {
+		messages[i] = i % 3;
+		memcpy(&rs[i * EPIR_SCALAR_SIZE], r, EPIR_SCALAR_SIZE);
+		rs[i * EPIR_SCALAR_SIZE] ^= i;
+	}
+	std::vector<unsigned char> ciphers_ref(n * EPIR_CIPHER_SIZE);
+	for(size_t i=0; i<n; i++) {
+		epir_ecelgamal_encrypt(&ciphers_ref[i * EPIR_CIPHER_SIZE], pubkey, messages[i], &rs[i * EPIR_SCALAR_SIZE]);
+	}
+	std::vector<unsigned char> ciphers_test(n * EPIR_CIPHER_SIZE);
+	epir_ecelgamal_encrypt_bulk(ciphers_test.data(), pubkey, messages.data(), n, rs.data());
+	ASSERT_EQ(ciphers_test, ciphers_ref);
+	epir_ecelgamal_encrypt_bulk_fast(ciphers_test.data(), privkey, messages.data(), n, rs.data());
+	ASSERT_EQ(ciphers_test, ciphers_ref);
+}
+
+TEST(ECElGamalTest, decrypt_to_mG_batch) {
+	const size_t n = 17;
+	std::vector<unsigned char> ciphers(n * EPIR_CIPHER_SIZE);
+	for(size_t i=0; i<n; i++) {
+		epir_ecelgamal_encrypt_fast(&ciphers[i * EPIR_CIPHER_SIZE], privkey, i, NULL);
+	}
+	std::vector<unsigned char> ciphers_scalar = ciphers;
+	for(size_t i=0; i<n; i++) {
+		epir_ecelgamal_decrypt_to_mG(privkey, &ciphers_scalar[i * EPIR_CIPHER_SIZE]);
+	}
+	for(const bool enable: {true, false}) {
+		epir_simd_enable(enable);
+		std::vector<unsigned char> ciphers_test = ciphers;
+		epir_ecelgamal_decrypt_to_mG_batch(privkey, ciphers_test.data(), n);
+		for(size_t i=0; i<n; i++) {
+			EXPECT_PRED2(SamePoint, &ciphers_test[i * EPIR_CIPHER_SIZE], &ciphers_scalar[i * EPIR_CIPHER_SIZE]);
+		}
+	}
+	epir_simd_enable(true);
+}
+
 #ifdef TEST_USING_MG
 static std::vector<epir_mG_t> mG_test(MG_SMALL_MMAX);
 
@@ -40,9 +97,31 @@ TEST(ECElGamalTest, mG_generate_no_sort) {
 	size_t points_computed = 0;
 	epir_mG_generate_no_sort(mG_test.data(), mG_test.size(), [](const size_t points_computed_test, void *data) {
 		size_t *points_computed = (size_t*)data;
-		(*points_computed)++;
-		EXPECT_EQ(points_computed_test, *points_computed);
+		EXPECT_GT(points_computed_test, *points_computed);
+		*points_computed = points_computed_test;
 	}, &points_computed);
+	ASSERT_EQ(points_computed, mG_test.size());
+}
+
+TEST(ECElGamalTest, mG_generate_no_sort_cadence) {
+	typedef struct {
+		size_t points_computed;
+		size_t callbacks;
+	} progress_t;
+	progress_t progress = { 0, 0 };
+	const epir_progress_cadence cadence = { 10000, 0 };
+	epir_executor pool;
+	ASSERT_EQ(epir_executor_init(&pool, 4), 0);
+	epir_mG_generate_no_sort_cadence_ex(mG_test.data(), mG_test.size(), [](const size_t points_computed_test, void *data) {
+		progress_t *progress = (progress_t*)data;
+		if(points_computed_test < MG_SMALL_MMAX) EXPECT_GE(points_computed_test, progress->points_computed + 10000);
+		EXPECT_GT(points_computed_test, progress->points_computed);
+		progress->points_computed = points_computed_test;
+		progress->callbacks++;
+	}, &progress, &cadence, &pool);
+	ASSERT_EQ(epir_executor_destroy(&pool), 0);
+	ASSERT_EQ(progress.points_computed, mG_test.size());
+	ASSERT_LE(progress.callbacks, mG_test.size() / 10000 + 1);
 }
 
 TEST(ECElGamalTest, mG_generate_sort) {
@@ -50,6 +129,22 @@ TEST(ECElGamalTest, mG_generate_sort) {
 	ASSERT_PRED2(SameHash<epir_mG_t>, mG_test, mG_hash_small);
 }
 
+TEST(ECElGamalTest, mG_generate_sort_ex) {
+	epir_mG_generate_no_sort(mG_test.data(), mG_test.size(), NULL, NULL);
+	epir_executor pool;
+	ASSERT_EQ(epir_executor_init(&pool, 3), 0);
+	epir_mG_sort_ex(mG_test.data(), mG_test.size(), &pool);
+	ASSERT_EQ(epir_executor_destroy(&pool), 0);
+	ASSERT_PRED2(SameHash<epir_mG_t>, mG_test, mG_hash_small);
+}
+
+TEST(ECElGamalTest, mG_generate_sort_workspace) {
+	epir_mG_generate_no_sort(mG_test.data(), mG_test.size(), NULL, NULL);
+	std::vector<uint8_t> workspace(epir_mG_sort_workspace_size(mG_test.size()));
+	epir_mG_sort_workspace_ex(mG_test.data(), mG_test.size(), workspace.data(), NULL);
+	ASSERT_PRED2(SameHash<epir_mG_t>, mG_test, mG_hash_small);
+}
+
 TEST(ECElGamalTest, mG_generate) {
 	epir_mG_generate(mG_test.data(), mG_test.size(), NULL, NULL);
 	ASSERT_PRED2(SameHash<epir_mG_t>, mG_test, mG_hash_small);
@@ -86,6 +181,85 @@ TEST(ECElGamalTest, mG_load_default) {
 	EXPECT_TRUE(std::filesystem::remove(path));
 }
 
+TEST(ECElGamalTest, mG_table_replicate) {
+	// Two nodes are forced, thus the replicas are tested even on a single node machine.
+	epir_mG_table table;
+	ASSERT_EQ(epir_mG_table_init(&table, MG_SMALL_MMAX, EPIR_NUMA_REPLICATE, 2), 0);
+	ASSERT_EQ(table.n_replicas, (uint32_t)2);
+	epir_mG_generate(table.replicas[0], MG_SMALL_MMAX, NULL, NULL);
+	epir_mG_table_replicate(&table);
+	ASSERT_NE(table.replicas[0], table.replicas[1]);
+	ASSERT_PRED3(SameBuffer, (const unsigned char*)table.replicas[1], (const unsigned char*)table.replicas[0], sizeof(epir_mG_t) * MG_SMALL_MMAX);
+	epir_memory_usage usage;
+	epir_mG_table_memory_usage(&table, &usage);
+	ASSERT_GE(usage.reserved, 2 * sizeof(epir_mG_t) * MG_SMALL_MMAX);
+	epir_executor pool;
+	ASSERT_EQ(epir_executor_init_numa(&pool, 3, 2), 0);
+	// Each worker (bound to the nodes 0, 1, 0 in the order of their start) finds the replica of its node.
+	// The runs wait for each other, thus each of them runs on a different worker.
+	struct {
+		epir_mG_table *table;
+		uint32_t started;
+		uint32_t finished;
+		uint32_t nodes[3];
+		const epir_mG_t *locals[3];
+	} lookups = { &table, 0, 0, {}, {} };
+	for(size_t w=0; w<3; w++) {
+		pool.submit([](void *lookups_) {
+			auto lookups = (decltype(&lookups))lookups_;
+			const uint32_t w = __atomic_fetch_add(&lookups->started, 1, __ATOMIC_ACQ_REL);
+			for(size_t i=0; i<6000 && __atomic_load_n(&lookups->started, __ATOMIC_ACQUIRE) < 3; i++) usleep(10'000);
+			lookups->nodes[w] = epir_numa_current_node();
+			lookups->locals[w] = epir_mG_table_local(lookups->table);
+			__atomic_add_fetch(&lookups->finished, 1, __ATOMIC_ACQ_REL);
+		}, &lookups, pool.submit_data);
+	}
+	for(size_t i=0; i<6000 && __atomic_load_n(&lookups.finished, __ATOMIC_ACQUIRE) < 3; i++) usleep(10'000);
+	ASSERT_EQ(__atomic_load_n(&lookups.finished, __ATOMIC_ACQUIRE), (uint32_t)3);
+	uint32_t on_node[2] = { 0, 0 };
+	for(size_t w=0; w<3; w++) {
+		ASSERT_LT(lookups.nodes[w], (uint32_t)2);
+		on_node[lookups.nodes[w]]++;
+		EXPECT_EQ(lookups.locals[w], table.replicas[lookups.nodes[w]]);
+	}
+	EXPECT_EQ(on_node[0], (uint32_t)2);
+	EXPECT_EQ(on_node[1], (uint32_t)1);
+	// The packing of one byte fits the small table.
+	std::vector<uint8_t> elem(ELEM_SIZE);
+	for(size_t i=0; i<ELEM_SIZE; i++) elem[i] = i * 7;
+	std::vector<uint8_t> reply(epir_reply_size(2, 1, ELEM_SIZE));
+	epir_reply_mock_fast(reply.data(), privkey, 2, 1, elem.data(), ELEM_SIZE, NULL);
+	const int data_len = epir_reply_decrypt_table_ex(reply.data(), reply.size(), privkey, 2, 1, &table, &pool);
+	ASSERT_EQ(epir_executor_destroy(&pool), 0);
+	ASSERT_EQ(epir_mG_table_destroy(&table), 0);
+	ASSERT_GE(data_len, (int)ELEM_SIZE);
+	ASSERT_PRED3(SameBuffer, reply.data(), elem.data(), ELEM_SIZE);
+}
+
+TEST(ECElGamalTest, mG_table_interleave) {
+	// A single table is shared by all the nodes.
+	epir_mG_table table;
+	ASSERT_EQ(epir_mG_table_init(&table, MG_SMALL_MMAX, EPIR_NUMA_INTERLEAVE, 2), 0);
+	ASSERT_EQ(table.n_replicas, (uint32_t)1);
+	epir_mG_generate(table.replicas[0], MG_SMALL_MMAX, NULL, NULL);
+	ASSERT_EQ(epir_mG_table_local(&table), table.replicas[0]);
+	epir_memory_usage usage;
+	epir_mG_table_memory_usage(&table, &usage);
+	ASSERT_GE(usage.reserved, sizeof(epir_mG_t) * MG_SMALL_MMAX);
+	ASSERT_LT(usage.reserved, 2 * sizeof(epir_mG_t) * MG_SMALL_MMAX);
+	std::vector<uint8_t> elem(ELEM_SIZE);
+	for(size_t i=0; i<ELEM_SIZE; i++) elem[i] = i * 11;
+	std::vector<uint8_t> reply(epir_reply_size(2, 1, ELEM_SIZE));
+	epir_reply_mock_fast(reply.data(), privkey, 2, 1, elem.data(), ELEM_SIZE, NULL);
+	epir_executor pool;
+	ASSERT_EQ(epir_executor_init_numa(&pool, 3, 2), 0);
+	const int data_len = epir_reply_decrypt_table_ex(reply.data(), reply.size(), privkey, 2, 1, &table, &pool);
+	ASSERT_EQ(epir_executor_destroy(&pool), 0);
+	ASSERT_EQ(epir_mG_table_destroy(&table), 0);
+	ASSERT_GE(data_len, (int)ELEM_SIZE);
+	ASSERT_PRED3(SameBuffer, reply.data(), elem.data(), ELEM_SIZE);
+}
+
 TEST(ECElGamalTest, decrypt_success) {
 	const int32_t decrypted = epir_ecelgamal_decrypt(privkey, cipher, mG.data(), EPIR_DEFAULT_MG_MAX);
 	ASSERT_EQ(decrypted, (int32_t)msg);
@@ -1,4 +1,10 @@
 
+#include <fstream>
+#include <memory>
+#include <regex>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
 #include <gtest/gtest.h>
 
 #include "../epir.h"
@@ -53,6 +59,217 @@ TEST(SelectorTest, selector_create_fast) {
 	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
 }
 
+TEST(SelectorTest, selector_create_ctx) {
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	auto ctx = std::make_unique<epir_pubkey_ctx>();
+	ASSERT_EQ(epir_pubkey_ctx_init(ctx.get(), pubkey), 0);
+	epir_selector_create_ctx(selector_test.data(), ctx.get(), index_counts, n_indexes, idx, selector_r().data());
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+}
+
+TEST(SelectorTest, selector_create_seeded) {
+	unsigned char seed[EPIR_SEED_SIZE];
+	memset(seed, 0x5a, EPIR_SEED_SIZE);
+	std::vector<unsigned char> r(ciphers_count * EPIR_SCALAR_SIZE);
+	for(size_t i=0; i<ciphers_count; i++) {
+		epir_scalar_from_seed(&r[i * EPIR_SCALAR_SIZE], seed, i);
+	}
+	std::vector<unsigned char> selector_ref(ciphers_count * EPIR_CIPHER_SIZE);
+	epir_selector_create_fast(selector_ref.data(), privkey, index_counts, n_indexes, idx, r.data());
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	epir_selector_create_fast_seeded(selector_test.data(), privkey, index_counts, n_indexes, idx, seed);
+	ASSERT_EQ(selector_test, selector_ref);
+	epir_selector_create_seeded(selector_test.data(), pubkey, index_counts, n_indexes, idx, seed);
+	ASSERT_EQ(selector_test, selector_ref);
+}
+
+TEST(SelectorTest, selector_create_ex) {
+	const std::vector<unsigned char> r = selector_r();
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	// A persistent pool.
+	epir_executor pool;
+	ASSERT_EQ(epir_executor_init(&pool, 3), 0);
+	epir_selector_create_fast_ex(selector_test.data(), privkey, index_counts, n_indexes, idx, r.data(), &pool);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	epir_selector_create_ex(selector_test.data(), pubkey, index_counts, n_indexes, idx, r.data(), &pool);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	ASSERT_EQ(epir_executor_destroy(&pool), 0);
+	// A submission callback which never runs the tasks until the loop returns (the caller runs all the items).
+	std::vector<std::pair<void (*)(void*), void*>> runs;
+	epir_executor deferred;
+	ASSERT_EQ(epir_executor_init_submit(&deferred, [](void (*run)(void*), void *run_data, void *runs) {
+		((std::vector<std::pair<void (*)(void*), void*>>*)runs)->push_back({ run, run_data });
+	}, &runs, 4), 0);
+	auto ctx = std::make_unique<epir_pubkey_ctx>();
+	ASSERT_EQ(epir_pubkey_ctx_init(ctx.get(), pubkey), 0);
+	epir_selector_create_ctx_ex(selector_test.data(), ctx.get(), index_counts, n_indexes, idx, r.data(), &deferred);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	ASSERT_EQ(runs.size(), (size_t)4);
+	for(auto &run: runs) run.first(run.second);
+	ASSERT_EQ(epir_executor_destroy(&deferred), 0);
+	epir_selector_create_fast_ex(selector_test.data(), privkey, index_counts, n_indexes, idx, r.data(), EPIR_EXECUTOR_INLINE);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+}
+
+TEST(SelectorTest, selector_create_submit) {
+	const std::vector<unsigned char> r = selector_r();
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	// Completion by the eventfd and the callback.
+	const int fd = eventfd(0, 0);
+	ASSERT_GE(fd, 0);
+	size_t called = 0;
+	epir_job job;
+	ASSERT_EQ(epir_job_init(&job, NULL, [](epir_job*, const int result, void *called) {
+		EXPECT_EQ(result, 0);
+		(*(size_t*)called)++;
+	}, &called, fd), 0);
+	ASSERT_EQ(epir_selector_create_submit(&job, selector_test.data(), pubkey, index_counts, n_indexes, idx, r.data()), 0);
+	uint64_t completed;
+	ASSERT_EQ(read(fd, &completed, sizeof(completed)), (ssize_t)sizeof(completed));
+	ASSERT_EQ(completed, (uint64_t)1);
+	// The job is done after the callback returns.
+	ASSERT_EQ(epir_job_wait(&job), 0);
+	ASSERT_TRUE(epir_job_poll(&job));
+	ASSERT_EQ(called, (size_t)1);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	// Completion by waiting (the job is reusable after the completion).
+	ASSERT_EQ(epir_selector_create_fast_submit(&job, selector_test.data(), privkey, index_counts, n_indexes, idx, r.data()), 0);
+	ASSERT_EQ(epir_job_wait(&job), 0);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	ASSERT_EQ(called, (size_t)2);
+	ASSERT_EQ(epir_job_destroy(&job), 0);
+	close(fd);
+}
+
+TEST(SelectorTest, selector_create_submit_destroy_in_callback) {
+	const std::vector<unsigned char> r = selector_r();
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	// The callback waits for and frees its own job (the inline executor completes it in the submission).
+	bool freed = false;
+	epir_job *job = new epir_job;
+	ASSERT_EQ(epir_job_init(job, EPIR_EXECUTOR_INLINE, [](epir_job *job, const int result, void *freed) {
+		EXPECT_EQ(result, 0);
+		EXPECT_EQ(epir_job_wait(job), 0);
+		EXPECT_EQ(epir_job_destroy(job), 0);
+		delete job;
+		*(bool*)freed = true;
+	}, &freed, -1), 0);
+	ASSERT_EQ(epir_selector_create_fast_submit(job, selector_test.data(), privkey, index_counts, n_indexes, idx, r.data()), 0);
+	ASSERT_TRUE(freed);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+}
+
+TEST(SelectorTest, selector_create_submit_cancel) {
+	const std::vector<unsigned char> r = selector_r();
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	// The submitted tasks wait until they are run here.
+	std::vector<std::pair<void (*)(void*), void*>> runs;
+	epir_executor deferred;
+	ASSERT_EQ(epir_executor_init_submit(&deferred, [](void (*run)(void*), void *run_data, void *runs) {
+		((std::vector<std::pair<void (*)(void*), void*>>*)runs)->push_back({ run, run_data });
+	}, &runs, 1), 0);
+	const auto run_all = [&runs]() {
+		while(!runs.empty()) {
+			const auto run = runs.back();
+			runs.pop_back();
+			run.first(run.second);
+		}
+	};
+	epir_job job;
+	ASSERT_EQ(epir_job_init(&job, &deferred, NULL, NULL, -1), 0);
+	// A pending job is cancelled.
+	ASSERT_EQ(epir_selector_create_fast_submit(&job, selector_test.data(), privkey, index_counts, n_indexes, idx, r.data()), 0);
+	epir_job_cancel(&job);
+	run_all();
+	ASSERT_EQ(epir_job_wait(&job), EPIR_JOB_CANCELLED);
+	// Cancelling the idle job does not cancel the next submission.
+	epir_job_cancel(&job);
+	ASSERT_EQ(epir_selector_create_fast_submit(&job, selector_test.data(), privkey, index_counts, n_indexes, idx, r.data()), 0);
+	run_all();
+	ASSERT_EQ(epir_job_wait(&job), 0);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	ASSERT_EQ(epir_job_destroy(&job), 0);
+	ASSERT_EQ(epir_executor_destroy(&deferred), 0);
+}
+
+static int selector_sink(const unsigned char *ciphers, const uint64_t offset, const size_t n, void *sink_data) {
+	std::vector<unsigned char> *selector = (std::vector<unsigned char>*)sink_data;
+	// The chunks are passed in order.
+	if(selector->size() != offset * EPIR_CIPHER_SIZE) return -2;
+	selector->insert(selector->end(), ciphers, ciphers + n * EPIR_CIPHER_SIZE);
+	return 0;
+}
+
+TEST(SelectorTest, selector_create_stream) {
+	const std::vector<unsigned char> r = selector_r();
+	std::vector<unsigned char> selector_test;
+	ASSERT_EQ(epir_selector_create_stream_fast(
+		privkey, index_counts, n_indexes, idx, r.data(), 100, selector_sink, &selector_test), 0);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	selector_test.clear();
+	ASSERT_EQ(epir_selector_create_stream(
+		pubkey, index_counts, n_indexes, idx, r.data(), 0, selector_sink, &selector_test), 0);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	// The streaming is aborted by the sink.
+	size_t chunks = 0;
+	auto abort_sink = [](const unsigned char*, const uint64_t, const size_t, void *chunks) {
+		return (++*(size_t*)chunks == 2 ? 1 : 0);
+	};
+	ASSERT_EQ(epir_selector_create_stream_fast(
+		privkey, index_counts, n_indexes, idx, NULL, 64, abort_sink, &chunks), 1);
+	ASSERT_EQ(chunks, (size_t)2);
+}
+
+TEST(SelectorTest, selector_create_stream_ex) {
+	const std::vector<unsigned char> r = selector_r();
+	std::vector<unsigned char> selector_test;
+	epir_executor pool;
+	ASSERT_EQ(epir_executor_init(&pool, 3), 0);
+	ASSERT_EQ(epir_selector_create_stream_fast_ex(
+		privkey, index_counts, n_indexes, idx, r.data(), 100, selector_sink, &selector_test, &pool), 0);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	selector_test.clear();
+	ASSERT_EQ(epir_selector_create_stream_ex(
+		pubkey, index_counts, n_indexes, idx, r.data(), 0, selector_sink, &selector_test, &pool), 0);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	selector_test.clear();
+	auto ctx = std::make_unique<epir_pubkey_ctx>();
+	ASSERT_EQ(epir_pubkey_ctx_init(ctx.get(), pubkey), 0);
+	ASSERT_EQ(epir_selector_create_stream_ctx_ex(
+		ctx.get(), index_counts, n_indexes, idx, r.data(), 1000, selector_sink, &selector_test, EPIR_EXECUTOR_INLINE), 0);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	// The streaming is aborted by the sink.
+	size_t chunks = 0;
+	auto abort_sink = [](const unsigned char*, const uint64_t, const size_t, void *chunks) {
+		return (++*(size_t*)chunks == 2 ? 1 : 0);
+	};
+	ASSERT_EQ(epir_selector_create_stream_fast_ex(
+		privkey, index_counts, n_indexes, idx, NULL, 64, abort_sink, &chunks, &pool), 1);
+	ASSERT_EQ(chunks, (size_t)2);
+	ASSERT_EQ(epir_executor_destroy(&pool), 0);
+}
+
+TEST(SelectorTest, scalar_random) {
+	unsigned char s1[EPIR_SCALAR_SIZE], s2[EPIR_SCALAR_SIZE];
+	for(size_t i=0; i<1000; i++) {
+		epir_scalar_random(s1);
+		epir_scalar_random(s2);
+		ASSERT_NE(memcmp(s1, s2, EPIR_SCALAR_SIZE), 0);
+		// Reduced modulo L.
+		ASSERT_LE(s1[EPIR_SCALAR_SIZE - 1], 0x10);
+	}
+}
+
+TEST(SelectorTest, selector_create_no_simd) {
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	epir_simd_enable(false);
+	epir_selector_create(selector_test.data(), pubkey, index_counts, n_indexes, idx, selector_r().data());
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+	epir_selector_create_fast(selector_test.data(), privkey, index_counts, n_indexes, idx, selector_r().data());
+	epir_simd_enable(true);
+	ASSERT_PRED2(SameHash<unsigned char>, selector_test, selector_hash);
+}
+
 TEST(ReplyMockTest, reply_size) {
 	const size_t reply_size = epir_reply_size(DIMENSION, PACKING, ELEM_SIZE);
 	ASSERT_EQ(reply_size, 320896ULL);
@@ -63,6 +280,144 @@ TEST(ReplyMockTest, reply_r_count) {
 	ASSERT_EQ(reply_r_count, 5260ULL);
 }
 
+TEST(ReplyMockTest, reply_mock_seeded) {
+	unsigned char seed[EPIR_SEED_SIZE];
+	memset(seed, 0xa5, EPIR_SEED_SIZE);
+	std::vector<uint8_t> elem(ELEM_SIZE, 0x42);
+	const size_t reply_size = epir_reply_size(DIMENSION, PACKING, ELEM_SIZE);
+	std::vector<uint8_t> reply_fast(reply_size), reply_normal(reply_size);
+	epir_reply_mock_fast_seeded(reply_fast.data(), privkey, DIMENSION, PACKING, elem.data(), ELEM_SIZE, seed);
+	epir_reply_mock_seeded(reply_normal.data(), pubkey, DIMENSION, PACKING, elem.data(), ELEM_SIZE, seed);
+	ASSERT_EQ(reply_fast, reply_normal);
+}
+
+TEST(ReplyMockTest, reply_mock_workspace) {
+	unsigned char seed[EPIR_SEED_SIZE];
+	memset(seed, 0xa5, EPIR_SEED_SIZE);
+	std::vector<uint8_t> elem(ELEM_SIZE, 0x42);
+	const size_t reply_size = epir_reply_size(DIMENSION, PACKING, ELEM_SIZE);
+	std::vector<uint8_t> reply(reply_size), reply_workspace(reply_size);
+	std::vector<unsigned char> workspace(epir_reply_mock_workspace_size(DIMENSION, PACKING, ELEM_SIZE));
+	epir_reply_mock_fast_seeded(reply.data(), privkey, DIMENSION, PACKING, elem.data(), ELEM_SIZE, seed);
+	epir_reply_mock_fast_seeded_workspace(
+		reply_workspace.data(), privkey, DIMENSION, PACKING, elem.data(), ELEM_SIZE, seed, workspace.data());
+	ASSERT_EQ(reply, reply_workspace);
+}
+
+TEST(ReplyMockTest, reply_mock_ex) {
+	std::vector<uint8_t> elem(ELEM_SIZE, 0x42);
+	const size_t reply_size = epir_reply_size(DIMENSION, PACKING, ELEM_SIZE);
+	std::vector<unsigned char> r(epir_reply_r_count(DIMENSION, PACKING, ELEM_SIZE) * EPIR_SCALAR_SIZE);
+	for(size_t i=0; i<r.size(); i+=EPIR_SCALAR_SIZE) epir_scalar_random(&r[i]);
+	std::vector<uint8_t> reply(reply_size), reply_ex(reply_size);
+	epir_reply_mock_fast(reply.data(), privkey, DIMENSION, PACKING, elem.data(), ELEM_SIZE, r.data());
+	epir_executor pool;
+	ASSERT_EQ(epir_executor_init(&pool, 3), 0);
+	epir_reply_mock_fast_ex(reply_ex.data(), privkey, DIMENSION, PACKING, elem.data(), ELEM_SIZE, r.data(), &pool);
+	ASSERT_EQ(reply_ex, reply);
+	epir_reply_mock_ex(reply_ex.data(), pubkey, DIMENSION, PACKING, elem.data(), ELEM_SIZE, r.data(), &pool);
+	ASSERT_EQ(reply_ex, reply);
+	ASSERT_EQ(epir_executor_destroy(&pool), 0);
+}
+
+TEST(MemoryTest, transient) {
+	std::vector<uint8_t> elem(ELEM_SIZE, 0x42);
+	const size_t reply_size = epir_reply_size(DIMENSION, PACKING, ELEM_SIZE);
+	std::vector<uint8_t> reply(reply_size);
+	// The first call initializes the state kept for the process lifetime.
+	epir_reply_mock_fast(reply.data(), privkey, DIMENSION, PACKING, elem.data(), ELEM_SIZE, NULL);
+	epir_memory_stats before, after;
+	epir_memory_reset_peak();
+	epir_memory_get(&before);
+	epir_reply_mock_fast(reply.data(), privkey, DIMENSION, PACKING, elem.data(), ELEM_SIZE, NULL);
+	epir_memory_get(&after);
+	ASSERT_EQ(after.current, before.current);
+	ASSERT_GE(after.peak, before.current + epir_reply_mock_workspace_size(DIMENSION, PACKING, ELEM_SIZE));
+}
+
+#define BATCH_N_ELEMENTS (10'000)
+#define BATCH_SIZE (20)
+
+std::vector<uint64_t> batch_idxs() {
+	std::vector<uint64_t> idxs(BATCH_SIZE);
+	for(size_t i=0; i<BATCH_SIZE; i++) {
+		idxs[i] = (i * 7919) % BATCH_N_ELEMENTS;
+	}
+	return idxs;
+}
+
+TEST(BatchTest, assign) {
+	epir_batch_ctx ctx;
+	ASSERT_EQ(epir_batch_ctx_init(&ctx, BATCH_N_ELEMENTS, BATCH_SIZE, 2, 0), 0);
+	// The server processes the database `EPIR_BATCH_HASHES` times (instead of `BATCH_SIZE` times),
+	// and the client sends less ciphers than the individual selectors.
+	ASSERT_LE(ctx.offsets[ctx.n_buckets], (uint64_t)(EPIR_BATCH_HASHES * BATCH_N_ELEMENTS));
+	const uint64_t single_index_counts[] = {100, 100};
+	ASSERT_LT(epir_batch_ciphers_count(&ctx), BATCH_SIZE * epir_selector_ciphers_count(single_index_counts, 2));
+	const std::vector<uint64_t> idxs = batch_idxs();
+	std::vector<uint32_t> buckets(BATCH_SIZE);
+	ASSERT_EQ(epir_batch_assign(&ctx, buckets.data(), idxs.data(), BATCH_SIZE), 0);
+	for(size_t i=0; i<BATCH_SIZE; i++) {
+		ASSERT_GE(epir_batch_position(&ctx, buckets[i], idxs[i]), 0);
+		for(size_t j=0; j<i; j++) {
+			ASSERT_NE(buckets[i], buckets[j]);
+		}
+	}
+	ASSERT_EQ(epir_batch_position(&ctx, ctx.n_buckets, idxs[0]), -1);
+	const uint64_t out_of_range = BATCH_N_ELEMENTS;
+	ASSERT_EQ(epir_batch_assign(&ctx, buckets.data(), &out_of_range, 1), -1);
+	epir_batch_ctx_destroy(&ctx);
+}
+
+TEST(BatchTest, selector_create) {
+	epir_batch_ctx ctx;
+	ASSERT_EQ(epir_batch_ctx_init(&ctx, BATCH_N_ELEMENTS, BATCH_SIZE, 2, 0), 0);
+	const std::vector<uint64_t> idxs = batch_idxs();
+	std::vector<uint32_t> buckets(BATCH_SIZE);
+	std::vector<unsigned char> selector(epir_batch_ciphers_count(&ctx) * EPIR_CIPHER_SIZE);
+	ASSERT_EQ(epir_batch_selector_create_fast(selector.data(), privkey, &ctx, buckets.data(), idxs.data(), BATCH_SIZE), 0);
+	// The selector of each assigned bucket chooses the position of the index.
+	const uint64_t bucket_ciphers = epir_selector_ciphers_count(ctx.index_counts, ctx.n_indexes);
+	std::vector<unsigned char> choices(bucket_ciphers);
+	for(size_t i=0; i<BATCH_SIZE; i++) {
+		const int64_t position = epir_batch_position(&ctx, buckets[i], idxs[i]);
+		epir_selector_create_choice(choices.data(), 1, ctx.index_counts, ctx.n_indexes, position);
+		#pragma omp parallel for
+		for(size_t c=0; c<bucket_ciphers; c++) {
+			const int32_t decrypted = epir_ecelgamal_decrypt(
+				privkey, &selector[(buckets[i] * bucket_ciphers + c) * EPIR_CIPHER_SIZE], mG.data(), EPIR_DEFAULT_MG_MAX);
+			EXPECT_EQ(decrypted, choices[c]);
+		}
+	}
+	epir_batch_ctx_destroy(&ctx);
+}
+
+TEST(ParamsTest, optimize) {
+	const epir_cost_model model = { 40e-6, 30e-6, 20e-6, 1e-6 };
+	const size_t n_params = epir_params_optimize(NULL, 0, 1000'000'000ULL, ELEM_SIZE, EPIR_DEFAULT_MG_MAX, &model);
+	ASSERT_GT(n_params, (size_t)0);
+	std::vector<epir_params> params(n_params);
+	ASSERT_EQ(epir_params_optimize(params.data(), n_params, 1000'000'000ULL, ELEM_SIZE, EPIR_DEFAULT_MG_MAX, &model), n_params);
+	for(size_t i=0; i<n_params; i++) {
+		const epir_params &p = params[i];
+		ASSERT_GE(epir_selector_elements_count(p.index_counts, p.n_indexes), 1000'000'000ULL);
+		ASSERT_LE(p.packing, 3);
+		ASSERT_EQ(p.selector_size, EPIR_CIPHER_SIZE * epir_selector_ciphers_count(p.index_counts, p.n_indexes));
+		ASSERT_EQ(p.reply_size, epir_reply_size(p.n_indexes, p.packing, ELEM_SIZE));
+		// In ascending order of bandwidth, and no parameter set dominates another.
+		for(size_t j=0; j<i; j++) {
+			const epir_params &q = params[j];
+			ASSERT_LE(q.selector_size + q.reply_size, p.selector_size + p.reply_size);
+			ASSERT_FALSE(q.client_seconds <= p.client_seconds && q.server_seconds <= p.server_seconds &&
+				q.selector_size + q.reply_size < p.selector_size + p.reply_size);
+		}
+	}
+	// The parameters used in the other tests (1000x1000x1000, packing 3) minimize the bandwidth.
+	ASSERT_EQ(params[0].n_indexes, n_indexes);
+	ASSERT_EQ(params[0].index_counts[0], index_counts[0]);
+	ASSERT_EQ(params[0].packing, PACKING);
+}
+
 #ifdef TEST_USING_MG
 std::array<uint8_t, ELEM_SIZE> generateElem() {
 	xorshift_init();
@@ -101,6 +456,39 @@ void replyTestFail(const bool isFast) {
 	ASSERT_EQ(data_len, -1);
 }
 
+TEST(ReplyTest, batch_decrypt) {
+	epir_batch_ctx ctx;
+	ASSERT_EQ(epir_batch_ctx_init(&ctx, BATCH_N_ELEMENTS, BATCH_SIZE, 2, 0), 0);
+	const std::vector<uint64_t> idxs = batch_idxs();
+	std::vector<uint32_t> buckets(BATCH_SIZE);
+	ASSERT_EQ(epir_batch_assign(&ctx, buckets.data(), idxs.data(), BATCH_SIZE), 0);
+	// Mock the replies of all the buckets (the element of `idx` is filled with the bytes of `idx`).
+	const size_t elem_size = sizeof(uint64_t);
+	const size_t bucket_reply_size = epir_reply_size(DIMENSION, PACKING, elem_size);
+	std::vector<uint8_t> reply(ctx.n_buckets * bucket_reply_size);
+	for(uint32_t b=0; b<ctx.n_buckets; b++) {
+		uint64_t elem = 0;
+		for(size_t i=0; i<BATCH_SIZE; i++) {
+			if(buckets[i] == b) elem = idxs[i];
+		}
+		epir_reply_mock_fast(&reply[b * bucket_reply_size], privkey, DIMENSION, PACKING, (uint8_t*)&elem, elem_size, NULL);
+	}
+	std::vector<uint64_t> elems(BATCH_SIZE);
+	// A truncated reply and a bucket which does not exist (even after a valid one) are rejected before any bucket is decrypted.
+	ASSERT_EQ(epir_batch_reply_decrypt(
+		(unsigned char*)elems.data(), elem_size, reply.data(), reply.size() - 1,
+		privkey, DIMENSION, PACKING, mG.data(), EPIR_DEFAULT_MG_MAX, &ctx, buckets.data(), BATCH_SIZE), -1);
+	const uint32_t out_of_range[2] = { buckets[0], ctx.n_buckets };
+	ASSERT_EQ(epir_batch_reply_decrypt(
+		(unsigned char*)elems.data(), elem_size, reply.data(), reply.size(),
+		privkey, DIMENSION, PACKING, mG.data(), EPIR_DEFAULT_MG_MAX, &ctx, out_of_range, 2), -1);
+	ASSERT_EQ(epir_batch_reply_decrypt(
+		(unsigned char*)elems.data(), elem_size, reply.data(), reply.size(),
+		privkey, DIMENSION, PACKING, mG.data(), EPIR_DEFAULT_MG_MAX, &ctx, buckets.data(), BATCH_SIZE), 0);
+	ASSERT_EQ(elems, idxs);
+	epir_batch_ctx_destroy(&ctx);
+}
+
 TEST(ReplyTest, decrypt_normal_success) {
 	replyTestSuccess(false);
 }
@@ -116,6 +504,54 @@ TEST(ReplyTest, decrypt_fast_success) {
 TEST(ReplyTest, decrypt_fast_fail) {
 	replyTestFail(true);
 }
+
+TEST(ReplyTest, decrypt_submit) {
+	const std::array<uint8_t, ELEM_SIZE> elem = generateElem();
+	std::vector<uint8_t> reply = generateReply(true, elem);
+	epir_job job;
+	ASSERT_EQ(epir_job_init(&job, NULL, NULL, NULL, -1), 0);
+	ASSERT_EQ(epir_reply_decrypt_submit(
+		&job, reply.data(), reply.size(), privkey, DIMENSION, PACKING, mG.data(), EPIR_DEFAULT_MG_MAX), 0);
+	const int data_len = epir_job_wait(&job);
+	ASSERT_EQ(epir_job_destroy(&job), 0);
+	ASSERT_GE(data_len, (int)ELEM_SIZE);
+	ASSERT_PRED3(SameBuffer, reply.data(), elem.data(), ELEM_SIZE);
+}
+
+TEST(ReplyTest, decrypt_ex) {
+	const std::array<uint8_t, ELEM_SIZE> elem = generateElem();
+	std::vector<uint8_t> reply = generateReply(true, elem);
+	epir_executor pool;
+	ASSERT_EQ(epir_executor_init(&pool, 0), 0);
+	const int data_len = epir_reply_decrypt_ex(
+		reply.data(), reply.size(), privkey, DIMENSION, PACKING, mG.data(), EPIR_DEFAULT_MG_MAX, &pool);
+	ASSERT_EQ(epir_executor_destroy(&pool), 0);
+	ASSERT_GE(data_len, (int)ELEM_SIZE);
+	ASSERT_PRED3(SameBuffer, reply.data(), elem.data(), ELEM_SIZE);
+}
+
+TEST(ReplyTest, profile) {
+	const std::array<uint8_t, ELEM_SIZE> elem = generateElem();
+	std::vector<uint8_t> reply = generateReply(true, elem);
+	const size_t ciphers = reply.size() / EPIR_CIPHER_SIZE;
+	epir_profile_reset();
+	const int data_len = epir_reply_decrypt(reply.data(), reply.size(), privkey, DIMENSION, PACKING, mG.data(), EPIR_DEFAULT_MG_MAX);
+	ASSERT_GE(data_len, (int)ELEM_SIZE);
+	epir_profile_stats stats;
+	epir_profile_get(&stats);
+	if(!epir_profile_enabled()) {
+		ASSERT_EQ(stats.ciphers[0], 0U);
+		return;
+	}
+	ASSERT_EQ(stats.ciphers[0], ciphers);
+	ASSERT_GE(stats.probes[0], ciphers);
+	ASSERT_EQ(stats.failures[0], 0U);
+	ASSERT_GT(stats.cycles[0][EPIR_PROFILE_SCALARMULT], 0U);
+	for(uint8_t phase=1; phase<DIMENSION; phase++) {
+		ASSERT_GT(stats.ciphers[phase], 0U);
+		ASSERT_LT(stats.ciphers[phase], stats.ciphers[phase - 1]);
+	}
+}
 #endif
 
 int main(int argc, char *argv[]) {
@@ -125,3 +561,36 @@ int main(int argc, char *argv[]) {
 	return RUN_ALL_TESTS();
 }
 
+#ifdef EPIR_ENABLE_TRACING
+// The trace file is named before the first use of the library (it is opened at the first span).
+static const std::string trace_path = "/tmp/epir_trace_" + std::to_string(getpid()) + ".json";
+static const int trace_env = setenv("EPIR_TRACE", trace_path.c_str(), 1);
+
+TEST(TraceTest, spans) {
+	ASSERT_EQ(trace_env, 0);
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	epir_selector_create_fast(selector_test.data(), privkey, index_counts, n_indexes, idx, NULL);
+	epir_trace_flush();
+	std::ifstream ifs(trace_path);
+	ASSERT_FALSE(ifs.fail());
+	// The JSON array has an event on each line (the closing bracket is written at the exit).
+	std::string line;
+	ASSERT_TRUE((bool)std::getline(ifs, line));
+	ASSERT_EQ(line, "[");
+	ASSERT_TRUE((bool)std::getline(ifs, line));
+	ASSERT_TRUE(std::regex_match(line, std::regex(R"re(\{"name":"epir_trace","cat":"epir","ph":"i".*\},?)re")));
+	const std::regex complete(
+		R"re(\{"name":"([A-Za-z_]+)","cat":"epir","ph":"X","pid":(\d+),"tid":(\d+),"ts":([0-9.]+),"dur":([0-9.]+),)re"
+		R"re("args":\{"size":(\d+)\}\},?)re");
+	size_t selector_spans = 0;
+	while(std::getline(ifs, line)) {
+		std::smatch m;
+		ASSERT_TRUE(std::regex_match(line, m, complete)) << line;
+		EXPECT_EQ(std::stol(m[2]), (long)getpid());
+		EXPECT_GT(std::stol(m[3]), 0);
+		if(m[1] == "selector_create" && std::stoull(m[6]) == ciphers_count) selector_spans++;
+	}
+	EXPECT_GE(selector_spans, (size_t)1);
+	EXPECT_EQ(unlink(trace_path.c_str()), 0);
+}
+#endif
@@ -1,4 +1,11 @@
 
+#include <set>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
 #include <gtest/gtest.h>
 
 #include "../epir.h"
@@ -24,13 +31,12 @@ void test_selector_factory(const bool is_fast, const bool is_async) {
 	} else {
 		ASSERT_EQ(epir_selector_factory_fill_sync(&ctx), 0);
 	}
-	for(size_t msg=0; msg<2; msg++) {
-		#pragma omp parallel for
-		for(size_t i=0; i<ctx.capacities[msg]; i++) {
-			const int32_t decrypted = epir_ecelgamal_decrypt(
-				privkey, &ctx.ciphers[msg][i * EPIR_CIPHER_SIZE], mG.data(), EPIR_DEFAULT_MG_MAX);
-			EXPECT_EQ(decrypted, (int32_t)msg);
-		}
+	// The pool holds only the ciphers of zero.
+	#pragma omp parallel for
+	for(size_t i=0; i<ctx.capacity; i++) {
+		const int32_t decrypted = epir_ecelgamal_decrypt(
+			privkey, &ctx.ciphers[i * EPIR_CIPHER_SIZE], mG.data(), EPIR_DEFAULT_MG_MAX);
+		EXPECT_EQ(decrypted, 0);
 	}
 	// Creata selector.
 	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
@@ -63,6 +69,228 @@ TEST(SelectorFactoryTest, async_fast) {
 	test_selector_factory(true, true);
 }
 
+TEST(SelectorFactoryTest, workspace) {
+	std::vector<unsigned char> workspace(epir_selector_factory_ctx_workspace_size(false, CAPACITY_ZERO, CAPACITY_ONE));
+	epir_selector_factory_ctx ctx;
+	ASSERT_EQ(epir_selector_factory_ctx_init_workspace(&ctx, pubkey, CAPACITY_ZERO, CAPACITY_ONE, workspace.data()), 0);
+	ASSERT_EQ((unsigned char*)ctx.pubkey_ctx, workspace.data());
+	ASSERT_EQ(epir_selector_factory_fill_sync(&ctx), 0);
+	ASSERT_EQ(epir_selector_factory_available(&ctx), (uint32_t)(CAPACITY_ZERO + CAPACITY_ONE));
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	ASSERT_EQ(epir_selector_factory_create_selector(selector_test.data(), &ctx, index_counts, n_indexes, idx), 0);
+	ASSERT_EQ(epir_selector_factory_ctx_destroy(&ctx), 0);
+	std::vector<unsigned char> choices(ciphers_count);
+	epir_selector_create_choice(choices.data(), 1, index_counts, n_indexes, idx);
+	#pragma omp parallel for
+	for(size_t i=0; i<ciphers_count; i++) {
+		const int32_t decrypted = epir_ecelgamal_decrypt(
+			privkey, &selector_test[i * EPIR_CIPHER_SIZE], mG.data(), EPIR_DEFAULT_MG_MAX);
+		EXPECT_EQ(decrypted, choices[i]);
+	}
+}
+
+TEST(SelectorFactoryTest, stats) {
+	epir_selector_factory_ctx ctx;
+	ASSERT_EQ(epir_selector_factory_ctx_init_fast(&ctx, privkey, ciphers_count, 0), 0);
+	ASSERT_EQ(epir_selector_factory_fill_sync(&ctx), 0);
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	ASSERT_EQ(epir_selector_factory_create_selector(selector_test.data(), &ctx, index_counts, n_indexes, idx), 0);
+	ASSERT_EQ(epir_selector_factory_create_selector(selector_test.data(), &ctx, index_counts, n_indexes, idx), -1);
+	epir_selector_factory_stats stats;
+	epir_selector_factory_get_stats(&ctx, &stats);
+	epir_memory_usage usage;
+	epir_selector_factory_memory_usage(&ctx, &usage);
+	ASSERT_EQ(epir_selector_factory_ctx_destroy(&ctx), 0);
+	EXPECT_EQ(stats.hits, (uint64_t)1);
+	EXPECT_EQ(stats.misses, (uint64_t)1);
+	EXPECT_EQ(stats.empties, (uint64_t)2);
+	EXPECT_EQ(stats.depth, (uint32_t)0);
+	EXPECT_EQ(stats.capacity, (uint32_t)ciphers_count);
+	EXPECT_EQ(stats.produced, (uint64_t)ciphers_count);
+	EXPECT_GT(stats.produced_per_second, 0);
+	EXPECT_GT(stats.refill_latency_p50, 0);
+	EXPECT_LE(stats.refill_latency_p50, stats.refill_latency_p99);
+	EXPECT_EQ(usage.resident, (size_t)0);
+	EXPECT_EQ(usage.reserved, (size_t)(ciphers_count * EPIR_CIPHER_SIZE));
+}
+
+TEST(SelectorFactoryTest, concurrent_fill_and_create) {
+	epir_selector_factory_ctx ctx;
+	ASSERT_EQ(epir_selector_factory_ctx_init_fast(&ctx, privkey, CAPACITY_ZERO, CAPACITY_ONE), 0);
+	ASSERT_EQ(epir_selector_factory_fill_sync(&ctx), 0);
+	ASSERT_EQ(epir_selector_factory_available(&ctx), (uint32_t)(CAPACITY_ZERO + CAPACITY_ONE));
+	// Consume selectors while refilling.
+	const size_t n_selectors = 8;
+	std::vector<std::vector<unsigned char>> selectors(n_selectors, std::vector<unsigned char>(ciphers_count * EPIR_CIPHER_SIZE));
+	std::vector<int> rets(n_selectors);
+	ASSERT_EQ(epir_selector_factory_fill(&ctx), 0);
+	#pragma omp parallel for
+	for(size_t s=0; s<n_selectors; s++) {
+		rets[s] = epir_selector_factory_create_selector(selectors[s].data(), &ctx, index_counts, n_indexes, idx);
+	}
+	ASSERT_EQ(pthread_join(ctx.thread, NULL), 0);
+	ASSERT_LE(epir_selector_factory_available(&ctx), (uint32_t)(CAPACITY_ZERO + CAPACITY_ONE));
+	ASSERT_EQ(epir_selector_factory_ctx_destroy(&ctx), 0);
+	// Every selector created should decrypt correctly.
+	std::vector<unsigned char> choices(ciphers_count);
+	epir_selector_create_choice(choices.data(), 1, index_counts, n_indexes, idx);
+	for(size_t s=0; s<n_selectors; s++) {
+		if(rets[s] != 0) continue;
+		#pragma omp parallel for
+		for(size_t i=0; i<ciphers_count; i++) {
+			const int32_t decrypted = epir_ecelgamal_decrypt(
+				privkey, &selectors[s][i * EPIR_CIPHER_SIZE], mG.data(), EPIR_DEFAULT_MG_MAX);
+			EXPECT_EQ(decrypted, choices[i]);
+		}
+	}
+}
+
+TEST(SelectorFactoryTest, replenisher) {
+	epir_selector_factory_ctx ctx;
+	ASSERT_EQ(epir_selector_factory_ctx_init_fast(&ctx, privkey, CAPACITY_ZERO, CAPACITY_ONE), 0);
+	epir_selector_factory_replenisher_config config = {};
+	config.high_watermark = CAPACITY_ZERO / 2;
+	ASSERT_EQ(epir_selector_factory_start_replenisher(&ctx, &config), 0);
+	ASSERT_EQ(epir_selector_factory_start_replenisher(&ctx, &config), -1);
+	// The replenisher fills the empty pool up to the high watermark (in a minute at most).
+	for(size_t i=0; i<6000 && epir_selector_factory_available(&ctx) < CAPACITY_ZERO / 2; i++) {
+		usleep(10'000);
+	}
+	// The replenisher is stopped even if these fail (it refers to the context on this stack).
+	EXPECT_GE(epir_selector_factory_available(&ctx), (uint32_t)(CAPACITY_ZERO / 2));
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	EXPECT_EQ(epir_selector_factory_create_selector(selector_test.data(), &ctx, index_counts, n_indexes, idx), 0);
+	ASSERT_EQ(epir_selector_factory_stop_replenisher(&ctx), 0);
+	ASSERT_EQ(epir_selector_factory_stop_replenisher(&ctx), -1);
+	ASSERT_LE(epir_selector_factory_available(&ctx), (uint32_t)(CAPACITY_ZERO / 2));
+	ASSERT_EQ(epir_selector_factory_ctx_destroy(&ctx), 0);
+}
+
+TEST(SelectorFactoryTest, save_load) {
+	char dir[] = "/tmp/epir_selector_factory.XXXXXX";
+	ASSERT_NE(mkdtemp(dir), nullptr);
+	const std::string path_str = std::string(dir) + "/pool.bin";
+	const char *path = path_str.c_str();
+	epir_selector_factory_ctx ctx;
+	ASSERT_EQ(epir_selector_factory_ctx_init_fast(&ctx, privkey, CAPACITY_ZERO, CAPACITY_ONE), 0);
+	ASSERT_EQ(epir_selector_factory_fill_sync(&ctx), 0);
+	ASSERT_EQ(epir_selector_factory_save(&ctx, path), CAPACITY_ZERO + CAPACITY_ONE);
+	// The file is private to the user.
+	struct stat st;
+	ASSERT_EQ(stat(path, &st), 0);
+	ASSERT_EQ(st.st_mode & 0777, (mode_t)0600);
+	// The ciphers saved are moved out of the cache.
+	ASSERT_EQ(epir_selector_factory_available(&ctx), (uint32_t)0);
+	ASSERT_EQ(epir_selector_factory_ctx_destroy(&ctx), 0);
+	// Another key cannot load the file.
+	epir_selector_factory_ctx ctx_other;
+	ASSERT_EQ(epir_selector_factory_ctx_init(&ctx_other, pubkey, CAPACITY_ZERO, CAPACITY_ONE), 0);
+	ASSERT_EQ(epir_selector_factory_load(&ctx_other, path), -2);
+	ASSERT_EQ(epir_selector_factory_ctx_destroy(&ctx_other), 0);
+	// Load in two steps: no cipher is loaded twice.
+	ASSERT_EQ(epir_selector_factory_ctx_init_fast(&ctx, privkey, CAPACITY_ZERO / 2, CAPACITY_ONE), 0);
+	ASSERT_EQ(epir_selector_factory_load(&ctx, path), CAPACITY_ZERO / 2 + CAPACITY_ONE);
+	ASSERT_EQ(epir_selector_factory_load(&ctx, path), 0);
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	ASSERT_EQ(epir_selector_factory_create_selector(selector_test.data(), &ctx, index_counts, n_indexes, idx), 0);
+	ASSERT_EQ(epir_selector_factory_load(&ctx, path), (int64_t)ciphers_count);
+	ASSERT_EQ(epir_selector_factory_ctx_destroy(&ctx), 0);
+	std::vector<unsigned char> choices(ciphers_count);
+	epir_selector_create_choice(choices.data(), 1, index_counts, n_indexes, idx);
+	#pragma omp parallel for
+	for(size_t i=0; i<ciphers_count; i++) {
+		const int32_t decrypted = epir_ecelgamal_decrypt(
+			privkey, &selector_test[i * EPIR_CIPHER_SIZE], mG.data(), EPIR_DEFAULT_MG_MAX);
+		EXPECT_EQ(decrypted, choices[i]);
+	}
+	EXPECT_EQ(unlink(path), 0);
+	EXPECT_EQ(unlink((path_str + ".lock").c_str()), 0);
+	EXPECT_EQ(rmdir(dir), 0);
+}
+
+TEST(SelectorFactoryTest, save_load_concurrent) {
+	char dir[] = "/tmp/epir_selector_factory.XXXXXX";
+	ASSERT_NE(mkdtemp(dir), nullptr);
+	const std::string path_str = std::string(dir) + "/pool.bin";
+	const char *path = path_str.c_str();
+	epir_selector_factory_ctx ctx;
+	ASSERT_EQ(epir_selector_factory_ctx_init_fast(&ctx, privkey, CAPACITY_ZERO, CAPACITY_ONE), 0);
+	ASSERT_EQ(epir_selector_factory_fill_sync(&ctx), 0);
+	ASSERT_EQ(epir_selector_factory_save(&ctx, path), CAPACITY_ZERO + CAPACITY_ONE);
+	ASSERT_EQ(epir_selector_factory_ctx_destroy(&ctx), 0);
+	// Two loaders, each of which can take all the ciphers, load the same file concurrently.
+	const size_t n_loaders = 2;
+	std::vector<epir_selector_factory_ctx> loaders(n_loaders);
+	for(size_t l=0; l<n_loaders; l++) {
+		ASSERT_EQ(epir_selector_factory_ctx_init_fast(&loaders[l], privkey, CAPACITY_ZERO, CAPACITY_ONE), 0);
+	}
+	std::vector<int64_t> loaded(n_loaders);
+	std::vector<std::thread> threads;
+	for(size_t l=0; l<n_loaders; l++) {
+		threads.emplace_back([&, l]() {
+			loaded[l] = epir_selector_factory_load(&loaders[l], path);
+		});
+	}
+	for(auto &thread: threads) thread.join();
+	// Every cipher is loaded exactly once.
+	std::set<std::string> ciphers;
+	int64_t total = 0;
+	for(size_t l=0; l<n_loaders; l++) {
+		ASSERT_GE(loaded[l], 0);
+		total += loaded[l];
+		for(int64_t i=0; i<loaded[l]; i++) {
+			ciphers.emplace((const char*)&loaders[l].ciphers[i * EPIR_CIPHER_SIZE], EPIR_CIPHER_SIZE);
+		}
+		ASSERT_EQ(epir_selector_factory_ctx_destroy(&loaders[l]), 0);
+	}
+	ASSERT_EQ(total, CAPACITY_ZERO + CAPACITY_ONE);
+	ASSERT_EQ(ciphers.size(), (size_t)total);
+	EXPECT_EQ(unlink(path), 0);
+	EXPECT_EQ(unlink((path_str + ".lock").c_str()), 0);
+	EXPECT_EQ(rmdir(dir), 0);
+}
+
+TEST(SelectorFactoryTest, pool) {
+	epir_selector_factory_pool pool;
+	epir_selector_factory_pool_config config = {};
+	config.memory_budget = EPIR_CIPHER_SIZE * CAPACITY_ZERO;
+	config.max_keys = 2;
+	config.n_workers = 2;
+	ASSERT_EQ(epir_selector_factory_pool_init(&pool, &config), 0);
+	const int64_t hot = epir_selector_factory_pool_add_key_fast(&pool, privkey);
+	const int64_t idle = epir_selector_factory_pool_add_key(&pool, pubkey);
+	ASSERT_GE(hot, 0);
+	ASSERT_GE(idle, 0);
+	ASSERT_EQ(epir_selector_factory_pool_add_key_fast(&pool, privkey), -1);
+	// The requests (even failed ones) warm up the cache of the hot key.
+	std::vector<unsigned char> selector_test(ciphers_count * EPIR_CIPHER_SIZE);
+	while(epir_selector_factory_pool_create_selector(selector_test.data(), &pool, hot, index_counts, n_indexes, idx) != 0) {
+		usleep(10'000);
+	}
+	// The idle key costs nothing, and the budget is kept.
+	ASSERT_EQ(pool.entries[idle]->factory.capacity, (uint32_t)0);
+	ASSERT_LE(pool.allocated, (uint64_t)CAPACITY_ZERO);
+	ASSERT_EQ(epir_selector_factory_pool_remove_key(&pool, idle), 0);
+	ASSERT_EQ(epir_selector_factory_pool_remove_key(&pool, idle), -1);
+	// The removed and out of range key IDs are rejected.
+	epir_selector_factory_stats stats;
+	for(const uint32_t key_id: { (uint32_t)idle, config.max_keys }) {
+		ASSERT_EQ(epir_selector_factory_pool_available(&pool, key_id), (uint32_t)0);
+		ASSERT_EQ(epir_selector_factory_pool_get_stats(&pool, key_id, &stats), -1);
+		ASSERT_EQ(epir_selector_factory_pool_create_selector(
+			selector_test.data(), &pool, key_id, index_counts, n_indexes, idx), -1);
+	}
+	ASSERT_EQ(epir_selector_factory_pool_destroy(&pool), 0);
+	std::vector<unsigned char> choices(ciphers_count);
+	epir_selector_create_choice(choices.data(), 1, index_counts, n_indexes, idx);
+	#pragma omp parallel for
+	for(size_t i=0; i<ciphers_count; i++) {
+		const int32_t decrypted = epir_ecelgamal_decrypt(
+			privkey, &selector_test[i * EPIR_CIPHER_SIZE], mG.data(), EPIR_DEFAULT_MG_MAX);
+		EXPECT_EQ(decrypted, choices[i]);
+	}
+}
+
 int main(int argc, char *argv[]) {
 	::testing::InitGoogleTest(&argc, argv);
 	const size_t elems_read = epir_mG_load(mG.data(), EPIR_DEFAULT_MG_MAX, NULL);
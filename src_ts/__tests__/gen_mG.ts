@@ -22,8 +22,10 @@ export const runTests = (createDecryptionContext: DecryptionContextCreateFunctio
 		it(`with callback (interval: ${INTERVAL.toLocaleString()})`, async () => {
 			let pointsComputed = 0;
 			const decCtx = await createDecryptionContext({ cb: (pointsComputedTest: number) => {
-				pointsComputed = Math.min(MMAX, pointsComputed + INTERVAL);
-				expect(pointsComputedTest).toBe(pointsComputed);
+				// At most one callback per interval.
+				if(pointsComputedTest < MMAX) expect(pointsComputedTest).toBeGreaterThanOrEqual(pointsComputed + INTERVAL);
+				expect(pointsComputedTest).toBeGreaterThan(pointsComputed);
+				pointsComputed = pointsComputedTest;
 			}, interval: INTERVAL }, MMAX);
 			expect(pointsComputed).toBe(MMAX);
 			const mG = decCtx.getMG();
@@ -32,8 +34,8 @@ export const runTests = (createDecryptionContext: DecryptionContextCreateFunctio
 		it('with callback (interval: 1)', async () => {
 			let pointsComputed = 0;
 			const decCtx = await createDecryptionContext({ cb: (pointsComputedTest: number) => {
-				pointsComputed++;
-				expect(pointsComputedTest).toBe(pointsComputed);
+				expect(pointsComputedTest).toBeGreaterThan(pointsComputed);
+				pointsComputed = pointsComputedTest;
 			}, interval: 1 }, MMAX);
 			expect(pointsComputed).toBe(MMAX);
 			const mG = decCtx.getMG();
@@ -140,6 +140,13 @@ export const runTests = (createEpir: EpirCreateFunction, createDecryptionContext
 			expect(sha256sum(mG)).toEqual(mGHash);
 		}, 30 * 1000);
 		
+		it('memory usage of DecryptionContext', async () => {
+			const decCtx = await decCtxPromise;
+			const usage = decCtx.getMemoryUsage();
+			expect(usage.resident).toBeGreaterThanOrEqual(decCtx.getMG().byteLength);
+			expect(usage.reserved).toBeGreaterThanOrEqual(usage.resident);
+		}, 30 * 1000);
+		
 		//it('interpolation search of mG', async () => {
 		//});
 		
@@ -1,6 +1,6 @@
 
 import { MG_DEFAULT_PATH } from '../../types';
-import { createEpir, createDecryptionContext } from '../../index';
+import { createEpir, createDecryptionContext, getDecryptionContextMemoryUsage } from '../../index';
 
 test('create an Epir instance', async () => {
 	await createEpir();
@@ -10,3 +10,9 @@ test('create a DecryptionContext instance', async () => {
 	await createDecryptionContext(MG_DEFAULT_PATH);
 });
 
+
+test('get the memory usage of a DecryptionContext', async () => {
+	const decCtx = await createDecryptionContext(MG_DEFAULT_PATH);
+	expect(getDecryptionContextMemoryUsage(decCtx)).toEqual(decCtx.getMemoryUsage());
+	expect(getDecryptionContextMemoryUsage(decCtx).resident).toBeGreaterThanOrEqual(decCtx.getMG().byteLength);
+});
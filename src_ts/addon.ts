@@ -9,6 +9,10 @@ import {
 	DecryptionContextParameter,
 	DecryptionContextCreateFunction,
 	SelectorFactoryBase,
+	SelectorFactoryStats,
+	ProfileStats,
+	MemoryUsage,
+	MemoryStats,
 	DEFAULT_CAPACITIES,
 	DEFAULT_MMAX
 } from './types';
@@ -21,6 +25,7 @@ declare class DecryptionContext implements DecryptionContextBase {
 	getMG(): ArrayBuffer;
 	decryptCipher(privkey: ArrayBuffer, cipher: ArrayBuffer): number;
 	decryptReply(privkey: ArrayBuffer, dimension: number, packing: number, reply: ArrayBuffer): Promise<ArrayBuffer>;
+	getMemoryUsage(): MemoryUsage;
 }
 
 export const createDecryptionContext: DecryptionContextCreateFunction = async (
@@ -51,6 +56,8 @@ declare class SelectorFactoryNapi {
 	constructor(isFast: boolean, key: ArrayBuffer, capacityZero: number, capacityOne: number);
 	fill: () => Promise<void>;
 	create: (indexCounts: number[], idx: number) => ArrayBuffer;
+	getStats: () => SelectorFactoryStats;
+	getMemoryUsage: () => MemoryUsage;
 }
 
 export class SelectorFactory extends SelectorFactoryBase {
@@ -75,6 +82,14 @@ export class SelectorFactory extends SelectorFactoryBase {
 		return selector;
 	}
 	
+	getStats(): SelectorFactoryStats {
+		return this.napi.getStats();
+	}
+	
+	getMemoryUsage(): MemoryUsage {
+		return this.napi.getMemoryUsage();
+	}
+	
 }
 
 export class Epir implements EpirBase {
@@ -132,3 +147,26 @@ export const createEpir: EpirCreateFunction = async () => {
 	return new Epir();
 };
 
+export const getProfileStats = (): ProfileStats => {
+	return epir_napi.profile_get();
+};
+
+export const resetProfileStats = (): void => {
+	epir_napi.profile_reset();
+};
+
+export const getMemoryStats = (): MemoryStats => {
+	return epir_napi.memory_get();
+};
+
+export const resetMemoryPeak = (): void => {
+	epir_napi.memory_reset_peak();
+};
+
+/**
+ * The memory held by the mG table of a decryption context.
+ */
+export const getDecryptionContextMemoryUsage = (decCtx: DecryptionContextBase): MemoryUsage => {
+	return decCtx.getMemoryUsage();
+};
+
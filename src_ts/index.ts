@@ -5,6 +5,12 @@
  * won't work correctly.
  */
 
-import { createEpir, createDecryptionContext } from './addon';
-export { createEpir, createDecryptionContext };
+import {
+	createEpir, createDecryptionContext, getProfileStats, resetProfileStats,
+	getMemoryStats, resetMemoryPeak, getDecryptionContextMemoryUsage
+} from './addon';
+export {
+	createEpir, createDecryptionContext, getProfileStats, resetProfileStats,
+	getMemoryStats, resetMemoryPeak, getDecryptionContextMemoryUsage
+};
 
@@ -1,4 +1,6 @@
 
+#include "../../src_c/epir.hpp"
+
 #include "common.hpp"
 
 void checkIsArrayBuffer(const Napi::Value val, const size_t expectedLength) {
@@ -35,3 +37,14 @@ std::vector<uint64_t> readIndexCounts(const Napi::Env env, const Napi::Value &va
 	return index_counts;
 }
 
+Napi::Object memoryUsageToObject(const Napi::Env env, const epir_memory_usage &usage) {
+	Napi::Object obj = Napi::Object::New(env);
+	obj.Set("resident", Napi::Number::New(env, usage.resident));
+	obj.Set("reserved", Napi::Number::New(env, usage.reserved));
+	return obj;
+}
+
+EllipticPIR::Executor &sharedExecutor() {
+	static EllipticPIR::Executor executor;
+	return executor;
+}
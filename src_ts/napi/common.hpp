@@ -53,6 +53,18 @@ void checkIsArrayBuffer(const Napi::Value val, const size_t expectedLength);
 
 std::vector<uint64_t> readIndexCounts(const Napi::Env env, const Napi::Value &val);
 
+/**
+ * Convert the `epir_memory_usage` to a MemoryUsage object.
+ */
+Napi::Object memoryUsageToObject(const Napi::Env env, const epir_memory_usage &usage);
+
+namespace EllipticPIR { class Executor; }
+
+/**
+ * The executor shared by the async workers (instead of an OpenMP team per worker).
+ */
+EllipticPIR::Executor &sharedExecutor();
+
 class PromiseWorker : public Napi::AsyncWorker {
 	public:
 		Napi::Promise::Deferred _deferred;
@@ -1,4 +1,6 @@
 
+#include <atomic>
+
 #include "../../src_c/epir.hpp"
 
 #include "common.hpp"
@@ -6,9 +8,10 @@
 
 Napi::Object DecryptionContext::Init(Napi::Env env, Napi::Object exports) {
 	Napi::Function func = DefineClass(env, "DecryptionContext", {
-		InstanceMethod<&DecryptionContext::GetMG        >("getMG"),
-		InstanceMethod<&DecryptionContext::DecryptCipher>("decryptCipher"),
-		InstanceMethod<&DecryptionContext::DecryptReply >("decryptReply"),
+		InstanceMethod<&DecryptionContext::GetMG         >("getMG"),
+		InstanceMethod<&DecryptionContext::DecryptCipher >("decryptCipher"),
+		InstanceMethod<&DecryptionContext::DecryptReply  >("decryptReply"),
+		InstanceMethod<&DecryptionContext::GetMemoryUsage>("getMemoryUsage"),
 	});
 	Napi::FunctionReference *constructor = new Napi::FunctionReference();
 	*constructor = Napi::Persistent(func);
@@ -17,16 +20,19 @@ Napi::Object DecryptionContext::Init(Napi::Env env, Napi::Object exports) {
 	return exports;
 }
 
-using Context = Napi::Reference<Napi::Value>;
-void mGCallJs(Napi::Env env, Napi::Function cb, Context *ctx, size_t *data) {
+// The progress of a generation: the latest count is coalesced into a single pending JS call (no allocation per callback).
+struct Context {
+	Napi::Reference<Napi::Value> self;
+	std::atomic<size_t> pointsComputed;
+	std::atomic<bool> pending;
+};
+void mGCallJs(Napi::Env env, Napi::Function cb, Context *ctx, Context*) {
+	ctx->pending.store(false);
 	if(env != nullptr && cb != nullptr) {
-		cb.Call(ctx->Value(), { Napi::Number::New(env, *data) });
-	}
-	if(data != nullptr) {
-		delete data;
+		cb.Call(ctx->self.Value(), { Napi::Number::New(env, ctx->pointsComputed.load()) });
 	}
 }
-using TSFN = Napi::TypedThreadSafeFunction<Context, size_t, mGCallJs>;
+using TSFN = Napi::TypedThreadSafeFunction<Context, Context, mGCallJs>;
 
 // new DecryptionContext(
 //   param: string | ArrayBuffer | undefined | { cb: ((p: number) => void), interval: number }, mmax = EPIR_DEFAULT_MG_MAX);
@@ -74,27 +80,24 @@ DecryptionContext::DecryptionContext(const Napi::CallbackInfo &info) : Napi::Obj
 		if(interval <= 0) {
 			THROW_RANGE_ERROR_NO_RETURN("The parameter 'param.interval' should be greater than zero.");
 		}
-		// Generate mG.bin using the specified callback.
-		Context *ctx = new Context(Napi::Persistent(info.This()));
+		// Generate mG.bin using the specified callback (at most once per `interval` points).
+		Context *ctx = new Context{ Napi::Persistent(info.This()), { 0 }, { false } };
 		auto tsfn = TSFN::New(env, cb, "new DecryptionContext", 0, 1, ctx, [](Napi::Env, void*, Context *ctx) {
 			delete ctx;
 		});
 		typedef struct {
-			Napi::Env env;
 			TSFN tsfn;
-			size_t mmax;
-			uint64_t interval;
+			Context *ctx;
 		} mG_cb_data;
-		mG_cb_data data = { env, tsfn, mmax, (uint64_t)interval };
+		mG_cb_data data = { tsfn, ctx };
 		auto cb_ = [](const size_t points_computed, void *cb_data) {
 			mG_cb_data *data = (mG_cb_data*)cb_data;
-			if((points_computed % data->interval) != 0 && points_computed != data->mmax) return;
-			size_t *pc = new size_t(points_computed);
-			if(data->tsfn.BlockingCall(pc) != napi_ok) {
-				return;
-			}
+			data->ctx->pointsComputed.store(points_computed);
+			if(data->ctx->pending.exchange(true)) return;
+			data->tsfn.NonBlockingCall(data->ctx);
 		};
-		this->decCtx = EllipticPIR::DecryptionContext::generate(cb_, &data, mmax);
+		const epir_progress_cadence cadence = { (size_t)interval, 0 };
+		this->decCtx = EllipticPIR::DecryptionContext::generate(cb_, &data, mmax, &cadence);
 		tsfn.Release();
 	} else {
 		THROW_TYPE_ERROR_NO_RETURN("The parameter has an invalid type.");
@@ -140,7 +143,8 @@ class ReplyDecryptWorker : public ArrayBufferPromiseWorker {
 		}
 		void Execute() override {
 			try {
-				this->data = this->decCtx->decryptReply(this->privkey, this->reply, this->dimension, this->packing);
+				this->data = this->decCtx->decryptReply(
+					this->privkey, this->reply, this->dimension, this->packing, &sharedExecutor());
 			} catch(const char *err) {
 				this->SetError(std::string(err));
 			}
@@ -167,3 +171,7 @@ Napi::Value DecryptionContext::DecryptReply(const Napi::CallbackInfo& info) {
 	return wk->_deferred.Promise();
 }
 
+// DecryptionContext.getMemoryUsage(): MemoryUsage.
+Napi::Value DecryptionContext::GetMemoryUsage(const Napi::CallbackInfo &info) {
+	return memoryUsageToObject(info.Env(), this->decCtx.memoryUsage());
+}
@@ -12,6 +12,7 @@ class DecryptionContext : public Napi::ObjectWrap<DecryptionContext> {
 		Napi::Value GetMG(const Napi::CallbackInfo& info);
 		Napi::Value DecryptCipher(const Napi::CallbackInfo& info);
 		Napi::Value DecryptReply(const Napi::CallbackInfo& info);
+		Napi::Value GetMemoryUsage(const Napi::CallbackInfo& info);
 		
 	public:
 		
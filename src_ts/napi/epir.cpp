@@ -205,6 +205,51 @@ Napi::Value ReplyMock(const Napi::CallbackInfo &info) {
 	return reply.ArrayBuffer();
 }
 
+// .profile_get(): ProfileStats.
+Napi::Value ProfileGet(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	const epir_profile_stats stats = EllipticPIR::profileGet();
+	auto phases = Napi::Array::New(env, EPIR_PROFILE_MAX_PHASES);
+	for(uint32_t p=0; p<EPIR_PROFILE_MAX_PHASES; p++) {
+		Napi::Object phase = Napi::Object::New(env);
+		phase.Set("decompressCycles", Napi::Number::New(env, stats.cycles[p][EPIR_PROFILE_DECOMPRESS]));
+		phase.Set("scalarmultCycles", Napi::Number::New(env, stats.cycles[p][EPIR_PROFILE_SCALARMULT]));
+		phase.Set("compressCycles", Napi::Number::New(env, stats.cycles[p][EPIR_PROFILE_COMPRESS]));
+		phase.Set("searchCycles", Napi::Number::New(env, stats.cycles[p][EPIR_PROFILE_SEARCH]));
+		phase.Set("compactCycles", Napi::Number::New(env, stats.cycles[p][EPIR_PROFILE_COMPACT]));
+		phase.Set("ciphers", Napi::Number::New(env, stats.ciphers[p]));
+		phase.Set("probes", Napi::Number::New(env, stats.probes[p]));
+		phase.Set("failures", Napi::Number::New(env, stats.failures[p]));
+		phases.Set(p, phase);
+	}
+	Napi::Object obj = Napi::Object::New(env);
+	obj.Set("enabled", Napi::Boolean::New(env, epir_profile_enabled()));
+	obj.Set("phases", phases);
+	return obj;
+}
+
+// .profile_reset(): void.
+Napi::Value ProfileReset(const Napi::CallbackInfo &info) {
+	epir_profile_reset();
+	return info.Env().Undefined();
+}
+
+// .memory_get(): MemoryStats.
+Napi::Value MemoryGet(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	const epir_memory_stats stats = EllipticPIR::memoryGet();
+	Napi::Object obj = Napi::Object::New(env);
+	obj.Set("current", Napi::Number::New(env, stats.current));
+	obj.Set("peak", Napi::Number::New(env, stats.peak));
+	return obj;
+}
+
+// .memory_reset_peak(): void.
+Napi::Value MemoryResetPeak(const Napi::CallbackInfo &info) {
+	epir_memory_reset_peak();
+	return info.Env().Undefined();
+}
+
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
 	#define DEFINE_FUNCTION(jsName, cName) exports.Set(Napi::String::New(env, jsName), Napi::Function::New(env, cName))
 	DEFINE_FUNCTION("create_privkey"      , CreatePrivkey     );
@@ -217,6 +262,10 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
 	DEFINE_FUNCTION("selector_create_fast", SelectorCreateFast);
 	DecryptionContext::Init(env, exports);
 	SelectorFactory::Init(env, exports);
+	DEFINE_FUNCTION("profile_get"  , ProfileGet  );
+	DEFINE_FUNCTION("profile_reset", ProfileReset);
+	DEFINE_FUNCTION("memory_get"       , MemoryGet      );
+	DEFINE_FUNCTION("memory_reset_peak", MemoryResetPeak);
 	// For testing.
 	DEFINE_FUNCTION("reply_size"   , ReplySize  );
 	DEFINE_FUNCTION("reply_r_count", ReplyRCount);
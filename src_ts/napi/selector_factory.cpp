@@ -6,8 +6,10 @@
 
 Napi::Object SelectorFactory::Init(Napi::Env env, Napi::Object exports) {
 	Napi::Function func = DefineClass(env, "SelectorFactory", {
-		InstanceMethod<&SelectorFactory::Fill  >("fill"),
-		InstanceMethod<&SelectorFactory::Create>("create"),
+		InstanceMethod<&SelectorFactory::Fill          >("fill"),
+		InstanceMethod<&SelectorFactory::Create        >("create"),
+		InstanceMethod<&SelectorFactory::GetStats      >("getStats"),
+		InstanceMethod<&SelectorFactory::GetMemoryUsage>("getMemoryUsage"),
 	});
 	Napi::FunctionReference *constructor = new Napi::FunctionReference();
 	*constructor = Napi::Persistent(func);
@@ -86,3 +88,31 @@ Napi::Value SelectorFactory::Create(const Napi::CallbackInfo &info) {
 	}
 }
 
+
+// SelectorFactory.getStats(): SelectorFactoryStats.
+Napi::Value SelectorFactory::GetStats(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	epir_selector_factory_stats stats;
+	epir_selector_factory_get_stats(&this->ctx, &stats);
+	Napi::Object obj = Napi::Object::New(env);
+	obj.Set("hits", Napi::Number::New(env, stats.hits));
+	obj.Set("misses", Napi::Number::New(env, stats.misses));
+	obj.Set("empties", Napi::Number::New(env, stats.empties));
+	obj.Set("depth", Napi::Number::New(env, stats.depth));
+	obj.Set("capacity", Napi::Number::New(env, stats.capacity));
+	obj.Set("produced", Napi::Number::New(env, stats.produced));
+	obj.Set("producedPerSecond", Napi::Number::New(env, stats.produced_per_second));
+	obj.Set("commitWaitSeconds", Napi::Number::New(env, stats.commit_wait_seconds));
+	obj.Set("refillLatencyP50", Napi::Number::New(env, stats.refill_latency_p50));
+	obj.Set("refillLatencyP90", Napi::Number::New(env, stats.refill_latency_p90));
+	obj.Set("refillLatencyP99", Napi::Number::New(env, stats.refill_latency_p99));
+	return obj;
+}
+
+// SelectorFactory.getMemoryUsage(): MemoryUsage.
+Napi::Value SelectorFactory::GetMemoryUsage(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	epir_memory_usage usage;
+	epir_selector_factory_memory_usage(&this->ctx, &usage);
+	return memoryUsageToObject(env, usage);
+}
@@ -11,6 +11,8 @@ class SelectorFactory : public Napi::ObjectWrap<SelectorFactory> {
 		
 		Napi::Value Fill(const Napi::CallbackInfo& info);
 		Napi::Value Create(const Napi::CallbackInfo& info);
+		Napi::Value GetStats(const Napi::CallbackInfo& info);
+		Napi::Value GetMemoryUsage(const Napi::CallbackInfo& info);
 		
 	public:
 		
@@ -22,10 +22,51 @@ export interface DecryptionContextBase {
 	getMG(): ArrayBuffer;
 	decryptCipher(privkey: ArrayBuffer, cipher: ArrayBuffer): number;
 	decryptReply(privkey: ArrayBuffer, dimension: number, packing: number, reply: ArrayBuffer): Promise<ArrayBuffer>;
+	getMemoryUsage(): MemoryUsage;
 }
 
 export const DEFAULT_CAPACITIES = [10000, 100];
 
+export interface SelectorFactoryStats {
+	hits: number;
+	misses: number;
+	empties: number;
+	depth: number;
+	capacity: number;
+	produced: number;
+	producedPerSecond: number;
+	commitWaitSeconds: number;
+	refillLatencyP50: number;
+	refillLatencyP90: number;
+	refillLatencyP99: number;
+}
+
+export interface ProfilePhaseStats {
+	decompressCycles: number;
+	scalarmultCycles: number;
+	compressCycles: number;
+	searchCycles: number;
+	compactCycles: number;
+	ciphers: number;
+	probes: number;
+	failures: number;
+}
+
+export interface ProfileStats {
+	enabled: boolean;
+	phases: ProfilePhaseStats[];
+}
+
+export interface MemoryUsage {
+	resident: number;
+	reserved: number;
+}
+
+export interface MemoryStats {
+	current: number;
+	peak: number;
+}
+
 export abstract class SelectorFactoryBase {
 	constructor(public readonly isFast: boolean, public readonly key: ArrayBuffer, public readonly capacities: number[]) {}
 	abstract fill(): Promise<void>;
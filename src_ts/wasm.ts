@@ -13,7 +13,8 @@ import {
 	POINT_SIZE,
 	CIPHER_SIZE,
 	MG_SIZE,
-	GE25519_P3_SIZE
+	GE25519_P3_SIZE,
+	MemoryUsage
 } from './types';
 import { arrayBufferConcat, getRandomScalar, getRandomScalarsConcat } from './util';
 import EPIRWorker from './wasm.worker.ts';
@@ -43,6 +44,11 @@ export class DecryptionContext implements DecryptionContextBase {
 		return ret;
 	}
 	
+	getMemoryUsage(): MemoryUsage {
+		// The mG table is allocated at once in the heap of wasm.
+		return { resident: this.mmax * MG_SIZE, reserved: this.mmax * MG_SIZE };
+	}
+	
 	decryptCipher(privkey: ArrayBuffer, cipher: ArrayBuffer): number {
 		const decrypted = this.helper.call('ecelgamal_decrypt', privkey, cipher, this.mG_, this.mmax) as number;
 		if(decrypted < 0) throw new Error('Failed to decrypt.');